@@ -0,0 +1,262 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "FPSBatchMovementSubsystem.h"
+#include "FPSCharacter.h"
+#include "FPSMovementStats.h"
+#include "Async/ParallelFor.h"
+#include "Math/VectorRegister.h"
+
+namespace
+{
+    // Lanes processed per SIMD step
+    constexpr int32 VectorWidth = 4;
+    // Lanes processed per ParallelFor task
+    constexpr int32 LanesPerTask = 1024;
+
+    // Bits in DirtyFlags
+    constexpr uint8 DirtyRoll = 1 << 0;
+    constexpr uint8 DirtyScale = 1 << 1;
+    constexpr uint8 DirtyLocation = 1 << 2;
+    constexpr uint8 DirtyCameraOffset = 1 << 3;
+
+    // Same result as FMath::FInterpTo for four lanes
+    FORCEINLINE VectorRegister4Float VectorInterpTo(const VectorRegister4Float &Current,
+                                                    const VectorRegister4Float &Target,
+                                                    const VectorRegister4Float &DeltaTime,
+                                                    const VectorRegister4Float &Speed)
+    {
+        const VectorRegister4Float Dist = VectorSubtract(Target, Current);
+        const VectorRegister4Float Alpha =
+            VectorMin(VectorMax(VectorMultiply(DeltaTime, Speed), VectorZeroFloat()), VectorOneFloat());
+        const VectorRegister4Float Result = VectorMultiplyAdd(Dist, Alpha, Current);
+        // Snaps to the target when close or when the speed is not positive
+        const VectorRegister4Float SnapMask =
+            VectorBitwiseOr(VectorCompareLT(VectorMultiply(Dist, Dist), VectorSetFloat1(UE_SMALL_NUMBER)),
+                            VectorCompareLE(Speed, VectorZeroFloat()));
+        return VectorSelect(SnapMask, Target, Result);
+    }
+} // namespace
+
+void UFPSBatchMovementSubsystem::Tick(float DeltaTime)
+{
+    FPS_MOVEMENT_SCOPE(STAT_FPSBatchMovement);
+    FPSMovementFrameStats::FScopedMovementTimer MovementTimer;
+    Super::Tick(DeltaTime);
+    // Nothing moves on a zero length frame, and settled lanes would be retired by mistake
+    if (NumActive == 0 || DeltaTime <= 0.f)
+    {
+        return;
+    }
+
+    // Steps all active lanes, split across worker threads for large batches
+    const int32 NumTasks = FMath::DivideAndRoundUp(NumActive, LanesPerTask);
+    ParallelFor(
+        NumTasks,
+        [this, DeltaTime](int32 TaskIndex)
+        {
+            const int32 FirstLane = TaskIndex * LanesPerTask;
+            UpdateLanes(FirstLane, FMath::Min(FirstLane + LanesPerTask, NumActive), DeltaTime);
+        },
+        NumTasks > 1 ? EParallelForFlags::None : EParallelForFlags::ForceSingleThread);
+
+    // Writes transforms back only for characters that changed, and retires lanes that settled.
+    // Iterates backwards so swapping a settled lane out of the active range does not skip any lane.
+    for (int32 Lane = NumActive - 1; Lane >= 0; Lane--)
+    {
+        const uint8 Flags = DirtyFlags[Lane];
+        if (Flags != 0)
+        {
+            FPSMovementKernel::FViewStep Step;
+            Step.bRollChanged = (Flags & DirtyRoll) != 0;
+            Step.Crouch.bScaleChanged = (Flags & DirtyScale) != 0;
+            Step.Crouch.LocationDeltaZ = (Flags & DirtyLocation) != 0 ? LocationDeltaZ[Lane] : 0.f;
+            Step.Crouch.bCameraOffsetChanged = (Flags & DirtyCameraOffset) != 0;
+            Characters[Lane]->ApplyBatchedView({CrouchScaleZ[Lane], CameraRoll[Lane], CrouchCameraOffsetZ[Lane]},
+                                               Step);
+        }
+        else
+        {
+            NumActive--;
+            SwapLanes(Lane, NumActive);
+        }
+    }
+}
+
+TStatId UFPSBatchMovementSubsystem::GetStatId() const
+{
+    RETURN_QUICK_DECLARE_CYCLE_STAT(UFPSBatchMovementSubsystem, STATGROUP_Tickables);
+}
+
+int32 UFPSBatchMovementSubsystem::RegisterCharacter(AFPSCharacter *Character,
+                                                    const FPSMovementKernel::FViewState &View)
+{
+    const int32 Lane = NumCharacters++;
+    ResizeLanes();
+    Characters[Lane] = Character;
+    CameraRoll[Lane] = View.CameraRoll;
+    CrouchScaleZ[Lane] = View.CrouchScaleZ;
+    CrouchCameraOffsetZ[Lane] = View.CrouchCameraOffsetZ;
+    // Starts settled until the first movement state arrives
+    TargetCameraRoll[Lane] = View.CameraRoll;
+    TargetCrouchScaleZ[Lane] = View.CrouchScaleZ;
+    return Lane;
+}
+
+void UFPSBatchMovementSubsystem::UnregisterCharacter(int32 Lane)
+{
+    if (!ensure(Lane >= 0 && Lane < NumCharacters))
+    {
+        return;
+    }
+    // Keeps the active range contiguous, then moves the lane to the end before removing it
+    if (Lane < NumActive)
+    {
+        NumActive--;
+        SwapLanes(Lane, NumActive);
+        Lane = NumActive;
+    }
+    NumCharacters--;
+    SwapLanes(Lane, NumCharacters);
+    // Clears the removed lane so it reads as settled padding
+    Characters[NumCharacters] = nullptr;
+    CameraRoll[NumCharacters] = 0.f;
+    CrouchScaleZ[NumCharacters] = 0.f;
+    CrouchCameraOffsetZ[NumCharacters] = 0.f;
+    TargetCameraRoll[NumCharacters] = 0.f;
+    TiltSpeed[NumCharacters] = 0.f;
+    TargetCrouchScaleZ[NumCharacters] = 0.f;
+    TargetLocationDeltaZ[NumCharacters] = 0.f;
+    CrouchTransitionSpeed[NumCharacters] = 0.f;
+    ResizeLanes();
+}
+
+void UFPSBatchMovementSubsystem::SetMovementState(int32 Lane, const FPSMovementKernel::FViewState &View,
+                                                  const FPSMovementKernel::FMovementState &State,
+                                                  const FPSMovementKernel::FMovementParams &Params,
+                                                  bool bIsCrouching, bool bIsWallRunning)
+{
+    if (!ensure(Lane >= 0 && Lane < NumCharacters))
+    {
+        return;
+    }
+    // The character's view matches the lane except for offsets it just added, such as a capsule crouch
+    CameraRoll[Lane] = View.CameraRoll;
+    CrouchScaleZ[Lane] = View.CrouchScaleZ;
+    CrouchCameraOffsetZ[Lane] = View.CrouchCameraOffsetZ;
+    const FPSMovementKernel::FViewTargets Targets =
+        FPSMovementKernel::GetViewTargets(State, Params, bIsCrouching, bIsWallRunning);
+    TargetCameraRoll[Lane] = Targets.CameraRoll;
+    TiltSpeed[Lane] = Targets.TiltSpeed;
+    TargetCrouchScaleZ[Lane] = Targets.CrouchScaleZ;
+    TargetLocationDeltaZ[Lane] = Targets.LocationDeltaZ;
+    CrouchTransitionSpeed[Lane] = Params.CrouchTransitionSpeed;
+    ActivateLane(Lane);
+}
+
+void UFPSBatchMovementSubsystem::UpdateLanes(int32 FirstLane, int32 LastLane, float DeltaTime)
+{
+    const VectorRegister4Float DeltaTimeV = VectorSetFloat1(DeltaTime);
+    const VectorRegister4Float Epsilon = VectorSetFloat1(UE_SMALL_NUMBER);
+
+    // Arrays are padded to the vector width, so the last group can run past LastLane
+    for (int32 Lane = FirstLane; Lane < LastLane; Lane += VectorWidth)
+    {
+        // Smoothly tilts the camera
+        const VectorRegister4Float Roll = VectorLoad(&CameraRoll[Lane]);
+        const VectorRegister4Float NewRoll =
+            VectorInterpTo(Roll, VectorLoad(&TargetCameraRoll[Lane]), DeltaTimeV, VectorLoad(&TiltSpeed[Lane]));
+        VectorStore(NewRoll, &CameraRoll[Lane]);
+
+        // Gradually changes scale of player to crouch or normal scale
+        const VectorRegister4Float CrouchSpeed = VectorLoad(&CrouchTransitionSpeed[Lane]);
+        const VectorRegister4Float Scale = VectorLoad(&CrouchScaleZ[Lane]);
+        const VectorRegister4Float NewScale =
+            VectorInterpTo(Scale, VectorLoad(&TargetCrouchScaleZ[Lane]), DeltaTimeV, CrouchSpeed);
+        VectorStore(NewScale, &CrouchScaleZ[Lane]);
+
+        // Moves the player towards the crouch offset while it scales, skipped when there is no offset
+        const VectorRegister4Float ScaleChanged = VectorCompareNE(NewScale, Scale);
+        const VectorRegister4Float TargetDelta = VectorLoad(&TargetLocationDeltaZ[Lane]);
+        const VectorRegister4Float HasDelta =
+            VectorBitwiseAnd(ScaleChanged, VectorCompareGT(VectorAbs(TargetDelta), Epsilon));
+        const VectorRegister4Float Delta =
+            VectorSelect(HasDelta, VectorInterpTo(VectorZeroFloat(), TargetDelta, DeltaTimeV, CrouchSpeed),
+                         VectorZeroFloat());
+        VectorStore(Delta, &LocationDeltaZ[Lane]);
+
+        // Eases the camera back after a capsule crouch and snaps it once close enough
+        const VectorRegister4Float CameraOffset = VectorLoad(&CrouchCameraOffsetZ[Lane]);
+        const VectorRegister4Float EasedOffset =
+            VectorInterpTo(CameraOffset, VectorZeroFloat(), DeltaTimeV, CrouchSpeed);
+        const VectorRegister4Float NewCameraOffset =
+            VectorSelect(VectorCompareLE(VectorAbs(EasedOffset),
+                                         VectorSetFloat1(FPSMovementKernel::CrouchCameraSettleTolerance)),
+                         VectorZeroFloat(), EasedOffset);
+        VectorStore(NewCameraOffset, &CrouchCameraOffsetZ[Lane]);
+
+        const int32 RollBits = VectorMaskBits(VectorCompareNE(NewRoll, Roll));
+        const int32 ScaleBits = VectorMaskBits(ScaleChanged);
+        const int32 MoveBits = VectorMaskBits(VectorCompareNE(Delta, VectorZeroFloat()));
+        const int32 CameraOffsetBits = VectorMaskBits(VectorCompareNE(CameraOffset, VectorZeroFloat()));
+        for (int32 Index = 0; Index < VectorWidth; Index++)
+        {
+            DirtyFlags[Lane + Index] = ((RollBits >> Index) & 1) * DirtyRoll |
+                                       ((ScaleBits >> Index) & 1) * DirtyScale |
+                                       ((MoveBits >> Index) & 1) * DirtyLocation |
+                                       ((CameraOffsetBits >> Index) & 1) * DirtyCameraOffset;
+        }
+    }
+}
+
+void UFPSBatchMovementSubsystem::SwapLanes(int32 LaneA, int32 LaneB)
+{
+    if (LaneA == LaneB)
+    {
+        return;
+    }
+    Characters.Swap(LaneA, LaneB);
+    CameraRoll.Swap(LaneA, LaneB);
+    CrouchScaleZ.Swap(LaneA, LaneB);
+    CrouchCameraOffsetZ.Swap(LaneA, LaneB);
+    TargetCameraRoll.Swap(LaneA, LaneB);
+    TiltSpeed.Swap(LaneA, LaneB);
+    TargetCrouchScaleZ.Swap(LaneA, LaneB);
+    TargetLocationDeltaZ.Swap(LaneA, LaneB);
+    CrouchTransitionSpeed.Swap(LaneA, LaneB);
+    LocationDeltaZ.Swap(LaneA, LaneB);
+    DirtyFlags.Swap(LaneA, LaneB);
+    if (Characters[LaneA])
+    {
+        Characters[LaneA]->SetBatchMovementLane(LaneA);
+    }
+    if (Characters[LaneB])
+    {
+        Characters[LaneB]->SetBatchMovementLane(LaneB);
+    }
+}
+
+void UFPSBatchMovementSubsystem::ActivateLane(int32 Lane)
+{
+    if (Lane >= NumActive)
+    {
+        SwapLanes(Lane, NumActive);
+        NumActive++;
+    }
+}
+
+void UFPSBatchMovementSubsystem::ResizeLanes()
+{
+    // Padding lanes stay zeroed, which reads as settled
+    const int32 NumLanes = Align(NumCharacters, VectorWidth);
+    Characters.SetNumZeroed(NumLanes);
+    CameraRoll.SetNumZeroed(NumLanes);
+    CrouchScaleZ.SetNumZeroed(NumLanes);
+    CrouchCameraOffsetZ.SetNumZeroed(NumLanes);
+    TargetCameraRoll.SetNumZeroed(NumLanes);
+    TiltSpeed.SetNumZeroed(NumLanes);
+    TargetCrouchScaleZ.SetNumZeroed(NumLanes);
+    TargetLocationDeltaZ.SetNumZeroed(NumLanes);
+    CrouchTransitionSpeed.SetNumZeroed(NumLanes);
+    LocationDeltaZ.SetNumZeroed(NumLanes);
+    DirtyFlags.SetNumZeroed(NumLanes);
+}
@@ -0,0 +1,76 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "FPSMovementKernel.h"
+#include "FPSBatchMovementSubsystem.generated.h"
+
+class AFPSCharacter;
+
+/**
+ * Runs the camera tilt and crouch transitions of batched characters (load test bots) in one
+ * vectorized pass instead of one actor tick each. State is stored as structure of arrays and
+ * characters with a transition in progress are kept at the front, so only those are processed.
+ */
+UCLASS()
+class MOVEMENT_REMAKE_API UFPSBatchMovementSubsystem : public UTickableWorldSubsystem
+{
+    GENERATED_BODY()
+
+public:
+    virtual void Tick(float DeltaTime) override;
+    virtual TStatId GetStatId() const override;
+
+    // Adds a character to the batch and returns its lane
+    int32 RegisterCharacter(AFPSCharacter *Character, const FPSMovementKernel::FViewState &View);
+    // Removes the character in this lane
+    void UnregisterCharacter(int32 Lane);
+    // Updates the transition targets after the character's crouch or wall run state changed
+    void SetMovementState(int32 Lane, const FPSMovementKernel::FViewState &View,
+                          const FPSMovementKernel::FMovementState &State,
+                          const FPSMovementKernel::FMovementParams &Params, bool bIsCrouching, bool bIsWallRunning);
+
+    int32 GetNumCharacters() const
+    {
+        return NumCharacters;
+    }
+    int32 GetNumActive() const
+    {
+        return NumActive;
+    }
+
+private:
+    // Steps lanes [FirstLane, LastLane) four at a time
+    void UpdateLanes(int32 FirstLane, int32 LastLane, float DeltaTime);
+    // Swaps all data of two lanes and tells the characters their new lane
+    void SwapLanes(int32 LaneA, int32 LaneB);
+    // Moves a lane into the active range
+    void ActivateLane(int32 Lane);
+    // Keeps every array padded to a multiple of the vector width
+    void ResizeLanes();
+
+    // Characters in lane order
+    UPROPERTY(Transient)
+    TArray<AFPSCharacter *> Characters;
+
+    // Current values
+    TArray<float> CameraRoll;
+    TArray<float> CrouchScaleZ;
+    TArray<float> CrouchCameraOffsetZ;
+    // Transition targets, recomputed when the movement state changes
+    TArray<float> TargetCameraRoll;
+    TArray<float> TiltSpeed;
+    TArray<float> TargetCrouchScaleZ;
+    TArray<float> TargetLocationDeltaZ;
+    TArray<float> CrouchTransitionSpeed;
+    // Outputs of the last pass
+    TArray<float> LocationDeltaZ;
+    TArray<uint8> DirtyFlags;
+
+    // Number of registered characters
+    int32 NumCharacters = 0;
+    // Number of characters at the front of the arrays with a transition in progress
+    int32 NumActive = 0;
+};
@@ -0,0 +1,62 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "FPSCameraEffects.h"
+#include "FPSMovementStats.h"
+#include "Camera/CameraComponent.h"
+
+namespace
+{
+    // Changes smaller than this in units or degrees are not written to the camera
+    constexpr float CameraWriteTolerance = 1.e-3f;
+} // namespace
+
+// Takes the camera's relative transform and field of view as the base the effects are added to
+void FFPSCameraEffects::Initialize(const UCameraComponent &Camera)
+{
+    BaseLocation = Camera.GetRelativeLocation();
+    BaseRotation = Camera.GetRelativeRotation();
+    // Camera tilt submits the whole roll
+    BaseRotation.Roll = 0.f;
+    BaseFieldOfView = Camera.FieldOfView;
+    AppliedLocation = BaseLocation;
+    AppliedRotation = Camera.GetRelativeRotation();
+    AppliedFieldOfView = BaseFieldOfView;
+}
+
+// Writes the blended contributions and clears them for the next frame
+bool FFPSCameraEffects::Apply(UCameraComponent &Camera)
+{
+    FPS_MOVEMENT_SCOPE(STAT_FPSCameraEffects);
+    const FRotator Rotation = BaseRotation + PendingRotation;
+    FVector Location = BaseLocation;
+    if (!PendingWorldOffset.IsZero())
+    {
+        // The relative location is in the space of the socket the camera is attached to
+        const USceneComponent *Parent = Camera.GetAttachParent();
+        Location += Parent ? Parent->GetSocketTransform(Camera.GetAttachSocketName())
+                                 .InverseTransformVectorNoScale(PendingWorldOffset)
+                           : PendingWorldOffset;
+    }
+    const float FieldOfView = BaseFieldOfView + PendingFieldOfView;
+    PendingRotation = FRotator::ZeroRotator;
+    PendingWorldOffset = FVector::ZeroVector;
+    PendingFieldOfView = 0.f;
+
+    bool bChanged = false;
+    if (!Location.Equals(AppliedLocation, CameraWriteTolerance) ||
+        !Rotation.Equals(AppliedRotation, CameraWriteTolerance))
+    {
+        Camera.SetRelativeLocationAndRotation(Location, Rotation);
+        AppliedLocation = Location;
+        AppliedRotation = Rotation;
+        INC_DWORD_STAT(STAT_FPSTransformWrites);
+        bChanged = true;
+    }
+    if (!FMath::IsNearlyEqual(FieldOfView, AppliedFieldOfView, CameraWriteTolerance))
+    {
+        Camera.SetFieldOfView(FieldOfView);
+        AppliedFieldOfView = FieldOfView;
+        bChanged = true;
+    }
+    return bChanged;
+}
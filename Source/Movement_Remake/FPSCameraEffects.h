@@ -0,0 +1,53 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class UCameraComponent;
+
+/**
+ * Blends the camera effects active in a frame and writes them to the camera in one update.
+ * Slide and wall run tilt, the crouch camera offset, landing shake and field of view kicks each submit a
+ * contribution every frame they are active. Apply adds them to the camera's base transform and only touches
+ * the camera when the result differs from what it last wrote.
+ */
+class FFPSCameraEffects
+{
+public:
+    // Takes the camera's relative transform and field of view as the base the effects are added to
+    void Initialize(const UCameraComponent &Camera);
+
+    // Rotation in degrees added to the base rotation
+    void AddRotation(const FRotator &Rotation)
+    {
+        PendingRotation += Rotation;
+    }
+    // Offset in world space, stays upright however the camera's parent is rotated
+    void AddWorldOffset(const FVector &Offset)
+    {
+        PendingWorldOffset += Offset;
+    }
+    // Degrees added to the base field of view
+    void AddFieldOfView(float Degrees)
+    {
+        PendingFieldOfView += Degrees;
+    }
+
+    // Writes the blended contributions and clears them for the next frame, returns true if the camera changed
+    bool Apply(UCameraComponent &Camera);
+
+private:
+    // Camera values with no effects applied
+    FVector BaseLocation = FVector::ZeroVector;
+    FRotator BaseRotation = FRotator::ZeroRotator;
+    float BaseFieldOfView = 90.f;
+    // Contributions submitted since the last Apply
+    FRotator PendingRotation = FRotator::ZeroRotator;
+    FVector PendingWorldOffset = FVector::ZeroVector;
+    float PendingFieldOfView = 0.f;
+    // Values last written to the camera
+    FVector AppliedLocation = FVector::ZeroVector;
+    FRotator AppliedRotation = FRotator::ZeroRotator;
+    float AppliedFieldOfView = 90.f;
+};
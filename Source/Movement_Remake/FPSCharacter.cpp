@@ -1,14 +1,22 @@
 // Fill out your copyright notice in the Description page of Project Settings.
 
 #include "FPSCharacter.h"
+#include "FPSCharacterMovementComponent.h"
+#include "FPSBatchMovementSubsystem.h"
+#include "FPSMovementLODSubsystem.h"
+#include "FPSMovementValidationSubsystem.h"
+#include "FPSMovementStats.h"
 #include "Components/CapsuleComponent.h"
 #include "Containers/UnrealString.h"
-#include "Engine/Engine.h"
 #include "EnhancedInputComponent.h"
 #include "GameFramework/Character.h"
 #include "GameFramework/CharacterMovementComponent.h"
 #include "HAL/Platform.h"
 #include "InputTriggers.h"
+#include "Misc/CommandLine.h"
+#include "Misc/DateTime.h"
+#include "Misc/Parse.h"
+#include "Misc/Paths.h"
 #include "Math/Color.h"
 #include "Math/MathFwd.h"
 #include "Math/UnrealMathUtility.h"
@@ -16,11 +24,13 @@
 #include "Delegates/Delegate.h"
 
 // Sets default values
-AFPSCharacter::AFPSCharacter()
+AFPSCharacter::AFPSCharacter(const FObjectInitializer &ObjectInitializer)
+    : Super(ObjectInitializer.SetDefaultSubobjectClass<UFPSCharacterMovementComponent>(
+          ACharacter::CharacterMovementComponentName))
 {
-    // Set this character to call Tick() every frame.  You can turn this off to improve performance if you don't need
-    // it.
+    // Ticks only while a camera tilt or crouch transition is in progress, see ScheduleViewTick
     PrimaryActorTick.bCanEverTick = true;
+    PrimaryActorTick.bStartWithTickEnabled = false;
 
     // Get default capsule collider
     UCapsuleComponent *Collider = GetCapsuleComponent();
@@ -36,61 +46,408 @@ AFPSCharacter::AFPSCharacter()
     // Setup camera
     CameraComp = CreateDefaultSubobject<UCameraComponent>(TEXT("Camera"));
     CameraComp->SetupAttachment(SpringArm);
+
+    // Movement component with slide and wall run modes
+    FPSMovement = CastChecked<UFPSCharacterMovementComponent>(GetCharacterMovement());
+}
+
+// Picks the movement tuning before the movement component first uses it
+void AFPSCharacter::PostInitializeComponents()
+{
+    // Characters without an asset share the class defaults
+    Tuning = MovementTuning ? MovementTuning : GetMutableDefault<UFPSMovementTuning>();
+    FPSMovement->SetMovementParams(Tuning->GetParams());
+    Super::PostInitializeComponents();
+}
+
+// BP_FPSCharacter overrode the walk speed before it moved into UFPSMovementTuning
+void AFPSCharacter::PostLoad()
+{
+    Super::PostLoad();
+    if (WalkSpeed_DEPRECATED < 0.f)
+    {
+        return;
+    }
+    if (!MovementTuning)
+    {
+        // Saved with the character's package, so resaving it keeps the value without this migration
+        MovementTuning = NewObject<UFPSMovementTuning>(this, TEXT("MigratedMovementTuning"));
+        MovementTuning->WalkSpeed = WalkSpeed_DEPRECATED;
+        MovementTuning->Rebuild();
+        UE_LOG(LogFPSMovement, Warning,
+               TEXT("%s: moved its saved walk speed of %.0f into a tuning of its own, resave it or point it at a "
+                    "shared movement tuning asset"),
+               *GetPathName(), WalkSpeed_DEPRECATED);
+    }
+    else if (MovementTuning->WalkSpeed != WalkSpeed_DEPRECATED)
+    {
+        UE_LOG(LogFPSMovement, Warning, TEXT("%s: ignored its saved walk speed of %.0f, %s sets %.0f"),
+               *GetPathName(), WalkSpeed_DEPRECATED, *MovementTuning->GetPathName(), MovementTuning->WalkSpeed);
+    }
+    WalkSpeed_DEPRECATED = -1.f;
 }
 
 // Called when the game starts or when spawned
 void AFPSCharacter::BeginPlay()
 {
     Super::BeginPlay();
-    // Sets character's max walkspeed to default set in the class
-    GetCharacterMovement()->MaxWalkSpeed = WalkSpeed;
-    // Links oncomponenthit function
-    GetCapsuleComponent()->OnComponentHit.AddDynamic(this, &AFPSCharacter::OnComponentHitCharacter);
+    ViewState.CrouchScaleZ = GetActorScale3D().Z;
+    ViewState.CameraRoll = CameraComp->GetRelativeRotation().Roll;
+    CameraEffects.Initialize(*CameraComp);
+    PlayerMeshBaseScale = PlayerMesh->GetRelativeScale3D();
+    PlayerMeshBaseLocation = PlayerMesh->GetRelativeLocation();
+    // Follows changes to the tuning while running
+    ApplyTuning();
+    TuningChangedHandle = Tuning->OnChanged.AddUObject(this, &AFPSCharacter::OnTuningChanged);
+    // The server checks the moves remote players report
+    if (HasAuthority())
+    {
+        if (UFPSMovementValidationSubsystem *Validation = GetWorld()->GetSubsystem<UFPSMovementValidationSubsystem>())
+        {
+            Validation->RegisterMovement(FPSMovement);
+        }
+    }
+    if (UFPSMovementLODSubsystem *LODSubsystem = GetWorld()->GetSubsystem<UFPSMovementLODSubsystem>())
+    {
+        LODSubsystem->RegisterCharacter(this);
+    }
+    // Hands camera tilt and crouch over to the batch movement subsystem
+    if (bUseBatchedMovement)
+    {
+        if (UFPSBatchMovementSubsystem *BatchMovement = GetWorld()->GetSubsystem<UFPSBatchMovementSubsystem>())
+        {
+            BatchMovementLane = BatchMovement->RegisterCharacter(this, ViewState);
+            SetActorTickEnabled(false);
+        }
+    }
+}
+
+// Called when the character is removed from the world
+void AFPSCharacter::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+    InputRecorder.Reset();
+    if (Tuning)
+    {
+        Tuning->OnChanged.Remove(TuningChangedHandle);
+    }
+    if (UFPSMovementValidationSubsystem *Validation = GetWorld()->GetSubsystem<UFPSMovementValidationSubsystem>())
+    {
+        Validation->UnregisterMovement(FPSMovement);
+    }
+    if (UFPSMovementLODSubsystem *LODSubsystem = GetWorld()->GetSubsystem<UFPSMovementLODSubsystem>())
+    {
+        LODSubsystem->UnregisterCharacter(this);
+    }
+    if (BatchMovementLane != INDEX_NONE)
+    {
+        if (UFPSBatchMovementSubsystem *BatchMovement = GetWorld()->GetSubsystem<UFPSBatchMovementSubsystem>())
+        {
+            BatchMovement->UnregisterCharacter(BatchMovementLane);
+        }
+        BatchMovementLane = INDEX_NONE;
+    }
+    Super::EndPlay(EndPlayReason);
+}
+
+// Allows jumping while crouched so slides can be jumped out of
+bool AFPSCharacter::CanJumpInternal_Implementation() const
+{
+    return JumpIsAllowedInternal();
 }
 
 // Called every frame
 void AFPSCharacter::Tick(float DeltaTime)
 {
+    FPS_MOVEMENT_SCOPE(STAT_FPSCharacterTick);
+    FPSMovementFrameStats::FScopedMovementTimer MovementTimer;
     Super::Tick(DeltaTime);
-    if (bIsCrouching)
+    // Smoothly tilts the camera and changes the scale of the player when sliding or wall running
+    const FPSMovementKernel::FViewStep Step =
+        FPSMovementKernel::UpdateView(ViewState, FPSMovement->GetMovementState(), FPSMovement->GetMovementParams(),
+                                      bIsCrouching, FPSMovement->IsWallRunning(), DeltaTime);
+    // Steps the landing shake, the final step writes the camera back to rest
+    const bool bLandingShake = ActiveLandingShakeAngle > 0.f;
+    if (bLandingShake)
     {
-        // Makes smoothly camera tilt when sliding
-        if (!bIsWallrunning || !bIsOnWall)
+        LandingShakeElapsed += DeltaTime;
+        if (LandingShakeElapsed >= Tuning->LandingShakeDuration)
         {
-            SmoothCameraTilt(-3.f, SlideCameraTiltSpeed, DeltaTime);
+            ActiveLandingShakeAngle = 0.f;
         }
-        // Gradually changes scale of player to crouch scale
-        GradualCrouch(CrouchScale.Z, DeltaTime);
-        // TODO - Slide downhill only when player's forward vector is towards slope direction
-        if (GetCharacterMovement()->IsMovingOnGround() && GetCharacterMovement()->IsJumpAllowed())
+    }
+    ApplyViewStep(Step);
+    // Sleeps until the movement state changes again
+    if (FPSMovementKernel::IsSettled(Step) && !bLandingShake)
+    {
+        SetActorTickEnabled(false);
+    }
+}
+
+// Called when the capsule shrinks for crouching
+void AFPSCharacter::OnStartCrouch(float HalfHeightAdjust, float ScaledHalfHeightAdjust)
+{
+    FPS_MOVEMENT_SCOPE(STAT_FPSCrouch);
+    Super::OnStartCrouch(HalfHeightAdjust, ScaledHalfHeightAdjust);
+    // Squashes the mesh once to fit the capsule, which keeps its base in place
+    PlayerMesh->SetRelativeScale3D(PlayerMeshBaseScale * Tuning->CrouchScale);
+    INC_DWORD_STAT(STAT_FPSTransformWrites);
+    // The camera dropped with the capsule centre, start it from where it was and ease it down
+    if (FPSMovement->bCrouchMaintainsBaseLocation)
+    {
+        FPSMovementKernel::OffsetCrouchCamera(ViewState, ScaledHalfHeightAdjust);
+    }
+    OnMovementStateChanged();
+}
+
+// Called when the capsule grows back after crouching
+void AFPSCharacter::OnEndCrouch(float HalfHeightAdjust, float ScaledHalfHeightAdjust)
+{
+    FPS_MOVEMENT_SCOPE(STAT_FPSCrouch);
+    Super::OnEndCrouch(HalfHeightAdjust, ScaledHalfHeightAdjust);
+    PlayerMesh->SetRelativeScale3D(PlayerMeshBaseScale);
+    INC_DWORD_STAT(STAT_FPSTransformWrites);
+    if (FPSMovement->bCrouchMaintainsBaseLocation)
+    {
+        FPSMovementKernel::OffsetCrouchCamera(ViewState, -ScaledHalfHeightAdjust);
+    }
+    OnMovementStateChanged();
+}
+
+// Dips the camera when landing hard enough, only the player looking through it sees the shake
+void AFPSCharacter::Landed(const FHitResult &Hit)
+{
+    Super::Landed(Hit);
+    if (!IsLocallyControlled() || BatchMovementLane != INDEX_NONE || MovementLOD != EFPSMovementLOD::Full)
+    {
+        return;
+    }
+    const float Strength = FMath::GetMappedRangeValueClamped(
+        FVector2f(Tuning->MinLandingShakeSpeed, Tuning->MaxLandingShakeSpeed), FVector2f(0.f, 1.f),
+        -GetVelocity().Z);
+    if (Strength > 0.f)
+    {
+        ActiveLandingShakeAngle = Tuning->LandingShakeAngle * Strength;
+        LandingShakeElapsed = 0.f;
+        ScheduleViewTick();
+    }
+}
+
+// Called when crouching or the movement mode changes
+void AFPSCharacter::OnMovementStateChanged()
+{
+    if (BatchMovementLane != INDEX_NONE)
+    {
+        if (UFPSBatchMovementSubsystem *BatchMovement = GetWorld()->GetSubsystem<UFPSBatchMovementSubsystem>())
         {
-            // Make sliding down slope faster
-            GetCharacterMovement()->Velocity +=
-                FVector::VectorPlaneProject(FVector::DownVector,
-                                            GetCharacterMovement()->CurrentFloor.HitResult.Normal) *
-                DeltaTime * 10000.f;
+            BatchMovement->SetMovementState(BatchMovementLane, ViewState, FPSMovement->GetMovementState(),
+                                            FPSMovement->GetMovementParams(), bIsCrouching,
+                                            FPSMovement->IsWallRunning());
         }
     }
+    else if (MovementLOD == EFPSMovementLOD::Full || Tuning->CrouchMode == EFPSCrouchMode::ActorScale)
+    {
+        ScheduleViewTick();
+    }
+    else if (MovementLOD == EFPSMovementLOD::Reduced)
+    {
+        SnapView();
+    }
+}
+
+// Switches cosmetic work, tick rate and proxy simulation to the level of detail
+void AFPSCharacter::SetMovementLOD(EFPSMovementLOD LOD)
+{
+    if (LOD == MovementLOD)
+    {
+        return;
+    }
+    MovementLOD = LOD;
+    SetSignificance(LOD == EFPSMovementLOD::Full ? 1.f : (LOD == EFPSMovementLOD::Reduced ? .5f : 0.f));
+    FPSMovement->SetSimpleExtrapolation(LOD == EFPSMovementLOD::Minimal && GetLocalRole() == ROLE_SimulatedProxy);
+    // Catches the view up with the current state, Minimal then leaves it alone until promoted
+    if (BatchMovementLane == INDEX_NONE && LOD != EFPSMovementLOD::Full)
+    {
+        SnapView();
+    }
     else
     {
-        // Makes smoothly camera tilt when sliding
-        if (!bIsOnWall || !bIsWallrunning)
-        {
-            SmoothCameraTilt(0.f, SlideCameraTiltSpeed, DeltaTime);
-        }
-        // Gradually changes scale of player to normal scale
-        GradualCrouch(NormalScale.Z, DeltaTime);
+        OnMovementStateChanged();
+    }
+}
+
+// Saves the state at the end of a frame for rollback
+void AFPSCharacter::SaveSnapshot(int32 Frame)
+{
+    FFPSMovementSnapshot Snapshot;
+    FPSMovement->SaveMovementSnapshot(Snapshot);
+    Snapshot.ViewState = ViewState;
+    Snapshot.bIsCrouching = bIsCrouching;
+    Snapshots.Save(Frame, Snapshot);
+}
+
+// Puts the character back to the end of a saved frame
+bool AFPSCharacter::RestoreSnapshot(int32 Frame)
+{
+    const FFPSMovementSnapshot *Snapshot = Snapshots.Find(Frame);
+    if (!Snapshot)
+    {
+        return false;
     }
-    if (bIsWallrunning && bIsOnWall)
+    FPSMovement->RestoreMovementSnapshot(*Snapshot);
+    ViewState = Snapshot->ViewState;
+    bIsCrouching = Snapshot->bIsCrouching;
+    ApplyCrouchTuning(bIsCrouching);
+    ApplyFullView();
+    OnMovementStateChanged();
+    return true;
+}
+
+// Restores a frame and steps the following frames again with their saved input
+int32 AFPSCharacter::Resimulate(int32 Frame, int32 NumFrames, float DeltaTime)
+{
+    if (!RestoreSnapshot(Frame))
     {
-        if (FrameCounter % 20 == 0)
+        return 0;
+    }
+    int32 NumSimulated = 0;
+    for (; NumSimulated < NumFrames; NumSimulated++)
+    {
+        const int32 NextFrame = Frame + NumSimulated + 1;
+        const FFPSMovementSnapshot *Next = Snapshots.Find(NextFrame);
+        if (!Next)
+        {
+            break;
+        }
+        const FFPSMovementInput Input = Next->Input;
+        if (Input.bWantsToSlide != bIsCrouching)
         {
-            bIsOnWall = false;
+            bIsCrouching = Input.bWantsToSlide;
+            ApplyCrouchTuning(bIsCrouching);
         }
-        WallRun(DeltaTime);
-        SmoothCameraTilt(WallRunTiltDirection * WallRunCameraTiltAngle, WallRunTransitionSpeed, DeltaTime);
+        FPSMovement->ResimulateMove(Input, DeltaTime);
+        // Only the view state is stepped, transforms are written once at the end. The legacy actor scale
+        // crouch nudges the actor location, which is not replayed.
+        FPSMovementKernel::UpdateView(ViewState, FPSMovement->GetMovementState(), FPSMovement->GetMovementParams(),
+                                      bIsCrouching, FPSMovement->IsWallRunning(), DeltaTime);
+        SaveSnapshot(NextFrame);
+    }
+    ApplyFullView();
+    OnMovementStateChanged();
+    return NumSimulated;
+}
+
+// Lowers the tick rate of simulated proxies and AI, 1 is fully significant and ticks every frame
+void AFPSCharacter::SetSignificance(float Significance)
+{
+    float TickInterval = 0.f;
+    if (!IsLocallyControlled() && (GetLocalRole() == ROLE_SimulatedProxy || !IsPlayerControlled()))
+    {
+        TickInterval = FMath::Lerp(LowSignificanceTickInterval, 0.f, FMath::Clamp(Significance, 0.f, 1.f));
     }
-    FrameCounter++;
+    SetActorTickInterval(TickInterval);
+}
+
+// Ticks only while a camera tilt or crouch transition needs stepping
+void AFPSCharacter::ScheduleViewTick()
+{
+    // The next tick steps the transition and disables the tick again once it settles
+    if (!IsActorTickEnabled() && NeedsViewTick())
+    {
+        SetActorTickEnabled(true);
+    }
+}
+
+// True when view transitions change gameplay state or are seen on this machine
+bool AFPSCharacter::NeedsViewTick() const
+{
+    // Capsule crouch leaves only the camera and mesh to animate, which a dedicated server never shows
+    return Tuning->CrouchMode == EFPSCrouchMode::ActorScale || GetNetMode() != NM_DedicatedServer;
+}
+
+// Applies a camera tilt and crouch step computed by the batch movement subsystem
+void AFPSCharacter::ApplyBatchedView(const FPSMovementKernel::FViewState &View,
+                                     const FPSMovementKernel::FViewStep &Step)
+{
+    ViewState = View;
+    ApplyViewStep(Step);
+}
+
+// Writes the whole view state, used after a rollback
+void AFPSCharacter::ApplyFullView()
+{
+    FPSMovementKernel::FViewStep Step;
+    Step.bRollChanged = true;
+    Step.Crouch.bScaleChanged = Tuning->CrouchMode == EFPSCrouchMode::ActorScale;
+    Step.Crouch.LocationDeltaZ = 0.f;
+    Step.Crouch.bCameraOffsetChanged = Tuning->CrouchMode == EFPSCrouchMode::Capsule;
+    ApplyViewStep(Step);
+}
+
+// Jumps the camera tilt and crouch straight to their targets, used below full level of detail
+void AFPSCharacter::SnapView()
+{
+    // Actor scale crouch moves the collision, so it always steps through the transition
+    if (Tuning->CrouchMode == EFPSCrouchMode::ActorScale)
+    {
+        ScheduleViewTick();
+        return;
+    }
+    const FPSMovementKernel::FViewTargets Targets =
+        FPSMovementKernel::GetViewTargets(FPSMovement->GetMovementState(), FPSMovement->GetMovementParams(),
+                                          bIsCrouching, FPSMovement->IsWallRunning());
+    ViewState.CameraRoll = Targets.CameraRoll;
+    ViewState.CrouchCameraOffsetZ = 0.f;
+    ApplyFullView();
+    SetActorTickEnabled(false);
+}
+
+// Writes the view state to the actor transform and submits the camera effects
+void AFPSCharacter::ApplyViewStep(const FPSMovementKernel::FViewStep &Step)
+{
+    if (Step.Crouch.bScaleChanged)
+    {
+        FVector NewScale = GetActorScale3D();
+        NewScale.Z = ViewState.CrouchScaleZ;
+        SetActorScale3D(NewScale);
+        INC_DWORD_STAT(STAT_FPSTransformWrites);
+    }
+    if (Step.Crouch.LocationDeltaZ != 0.f)
+    {
+        SetActorLocation(GetActorLocation() + FVector(0.f, 0.f, Step.Crouch.LocationDeltaZ));
+        INC_DWORD_STAT(STAT_FPSTransformWrites);
+    }
+    // Fixed step movement writes the camera after it moves this frame, once the presentation offset is known
+    if (FPSMovement->GetFixedStepTime() <= 0.f)
+    {
+        ApplyCameraEffects();
+    }
+}
+
+// Blends tilt, crouch offset, landing shake and presentation offset into the camera
+void AFPSCharacter::ApplyCameraEffects()
+{
+    // Everything is blended into a single camera write, skipped when unchanged
+    CameraEffects.AddRotation(FRotator(0.f, 0.f, ViewState.CameraRoll));
+    CameraEffects.AddWorldOffset(FVector(0.f, 0.f, ViewState.CrouchCameraOffsetZ));
+    CameraEffects.AddRotation(FRotator(FPSMovementKernel::LandingShakePitch(LandingShakeElapsed,
+                                                                            Tuning->LandingShakeDuration,
+                                                                            ActiveLandingShakeAngle),
+                                       0.f, 0.f));
+    CameraEffects.AddWorldOffset(PresentationOffset);
+    CameraEffects.Apply(*CameraComp);
+}
+
+// Draws the mesh and camera at this world offset from the capsule, set by fixed step movement every frame
+void AFPSCharacter::SetPresentationOffset(const FVector &Offset)
+{
+    if (!Offset.Equals(PresentationOffset, 1e-3f))
+    {
+        PresentationOffset = Offset;
+        // Relative locations are in the capsule's scaled space, which actor scale crouch changes
+        PlayerMesh->SetRelativeLocation(PlayerMeshBaseLocation + GetActorTransform().InverseTransformVector(Offset));
+        INC_DWORD_STAT(STAT_FPSTransformWrites);
+    }
+    ApplyCameraEffects();
 }
 
 // Called to bind functionality to input
@@ -101,24 +458,57 @@ void AFPSCharacter::SetupPlayerInputComponent(UInputComponent *PlayerInputCompon
     {
         // Binds walk function to walk action
         EnhancedInput->BindAction(WalkAction, ETriggerEvent::Triggered, this, &AFPSCharacter::Walk);
+        EnhancedInput->BindAction(WalkAction, ETriggerEvent::Completed, this, &AFPSCharacter::StopWalk);
         // Binds look function to look action
         EnhancedInput->BindAction(LookAction, ETriggerEvent::Triggered, this, &AFPSCharacter::Look);
-        // Binds jump function to built in jump function
-        EnhancedInput->BindAction(JumpAction, ETriggerEvent::Triggered, this, &ACharacter::Jump);
-        EnhancedInput->BindAction(JumpAction, ETriggerEvent::Triggered, this, &AFPSCharacter::WallJump);
+        // Binds jump function to built in jump and wall jump
+        EnhancedInput->BindAction(JumpAction, ETriggerEvent::Triggered, this, &AFPSCharacter::JumpPressed);
         // Binds bIsCrouching to startcrouch and stopcrouch function
         EnhancedInput->BindAction(CrouchAction, ETriggerEvent::Started, this, &AFPSCharacter::StartCrouch);
         EnhancedInput->BindAction(CrouchAction, ETriggerEvent::Completed, this, &AFPSCharacter::StopCrouch);
-        // Screen Text for debugging
-        GEngine->AddOnScreenDebugMessage(1, 3.f, FColor::Green, TEXT("Input Actions Binded"));
+        FPS_MOVEMENT_DEBUG(1, FColor::Green, TEXT("Input Actions Binded"));
+    }
+    // Records this player's input for playback, -RecordInput=<File> or a new file in Saved/InputRecordings
+    FString RecordingPath;
+    if (FParse::Value(FCommandLine::Get(), TEXT("RecordInput="), RecordingPath) ||
+        FParse::Param(FCommandLine::Get(), TEXT("RecordInput")))
+    {
+        if (RecordingPath.IsEmpty())
+        {
+            RecordingPath = FPaths::ProjectSavedDir() / TEXT("InputRecordings") /
+                            FString::Printf(TEXT("%s.fpsinput"), *FDateTime::Now().ToString());
+        }
+        InputRecorder = MakeUnique<FPSInputRecording::FRecorder>(RecordingPath);
+        if (!InputRecorder->IsOpen())
+        {
+            InputRecorder.Reset();
+        }
     }
 }
 // Function for walking functionality
 void AFPSCharacter::Walk(const FInputActionInstance &Instance)
 {
-    // Gets value of input
-    FVector2D Input = Instance.GetValue().Get<FVector2D>();
-    // Adds input corresponding to character's forward and right vector
+    const FVector2D Input = Instance.GetValue().Get<FVector2D>();
+    // Recorded as the held value, playback keeps applying it every frame until the next walk record
+    if (Input != RecordedWalkInput)
+    {
+        RecordedWalkInput = Input;
+        RecordInput(FPSInputRecording::EAction::Walk, Input);
+    }
+    WalkInput(Input);
+}
+// Records the walk input going back to rest
+void AFPSCharacter::StopWalk(const FInputActionInstance &Instance)
+{
+    if (!RecordedWalkInput.IsZero())
+    {
+        RecordedWalkInput = FVector2D::ZeroVector;
+        RecordInput(FPSInputRecording::EAction::Walk);
+    }
+}
+// Adds input corresponding to character's forward and right vector
+void AFPSCharacter::WalkInput(const FVector2D &Input)
+{
     AddMovementInput(GetActorForwardVector(), Input.Y);
     AddMovementInput(GetActorRightVector(), Input.X);
     // GEngine->AddOnScreenDebugMessage(0, 5.f, FColor::Green,
@@ -129,7 +519,13 @@ void AFPSCharacter::Walk(const FInputActionInstance &Instance)
 // Function for player camera rotation
 void AFPSCharacter::Look(const FInputActionInstance &Instance)
 {
-    FVector2D Input = Instance.GetValue().Get<FVector2D>();
+    const FVector2D Input = Instance.GetValue().Get<FVector2D>();
+    RecordInput(FPSInputRecording::EAction::Look, Input);
+    LookInput(Input);
+}
+// Rotates the controller by the look input
+void AFPSCharacter::LookInput(const FVector2D &Input)
+{
     AddControllerPitchInput(Input.Y);
     AddControllerYawInput(Input.X);
     // GEngine->AddOnScreenDebugMessage(0, 3.0f, FColor::Blue, TEXT("Look"));
@@ -137,186 +533,115 @@ void AFPSCharacter::Look(const FInputActionInstance &Instance)
 // Starts crouching
 void AFPSCharacter::StartCrouch(const FInputActionInstance &Instance)
 {
-    // SetActorScale3D(CrouchScale);
-    // FVector NewLocation = GetActorLocation();
-    // NewLocation.Z -= NormalScale.Z - CrouchScale.Z;
-    // SetActorLocation(NewLocation);
-
-    bIsCrouching = true;
-
-    // Adds message containing character velocity
-    // GEngine->AddOnScreenDebugMessage(0, 5.f, FColor::Green,
-    //                                  FString::Printf(TEXT("Velocity = %d"),
-    //                                  GetCharacterMovement()->Velocity.Size2D()));
-    // Sets ground friction to sliding friction
-    GetCharacterMovement()->GroundFriction = SlideFriction;
-    GetCharacterMovement()->BrakingFrictionFactor = 0.1f;
-    // Sets walkspeed to bIsCrouching walkspeed
-    GetCharacterMovement()->MaxWalkSpeed = CrouchSpeed;
-
-    // Checks if current velocity is fast enough for sliding
-    if (GetCharacterMovement()->Velocity.Size() > 100.f)
-    {
-        // Checks if character is on ground
-        if (GetCharacterMovement()->IsMovingOnGround())
-        {
-            // Adds impulse force to character
-            GetCharacterMovement()->Velocity += GetCharacterMovement()->Velocity.GetSafeNormal2D() * SlideForce;
-            // Log message for debugging
-            // GEngine->AddOnScreenDebugMessage(0, 5, FColor::Green, TEXT("Force added"));
-            bAppliedSlideForce = true;
-        }
-    }
+    RecordInput(FPSInputRecording::EAction::CrouchStart);
+    SetCrouchInput(true);
 }
 // Stops Crouching
 void AFPSCharacter::StopCrouch(const FInputActionInstance &Instance)
 {
-    // SetActorScale3D(NormalScale);
+    RecordInput(FPSInputRecording::EAction::CrouchStop);
+    SetCrouchInput(false);
+}
+// Starts or stops crouching and sliding
+void AFPSCharacter::SetCrouchInput(bool bPressed)
+{
+    FPS_MOVEMENT_SCOPE(STAT_FPSCrouch);
+    // SetActorScale3D(bPressed ? CrouchScale : NormalScale);
     // FVector NewLocation = GetActorLocation();
-    // NewLocation.Z += NormalScale.Z - CrouchScale.Z;
+    // NewLocation.Z -= NormalScale.Z - CrouchScale.Z;
     // SetActorLocation(NewLocation);
 
-    bIsCrouching = false;
-
-    // Reset to default walkspeed and friction
-    GetCharacterMovement()->GroundFriction = 8.0f;
-    GetCharacterMovement()->BrakingFrictionFactor = 2.0f;
-    GetCharacterMovement()->MaxWalkSpeed = WalkSpeed;
-    if (GetCharacterMovement()->IsMovingOnGround())
-    {
-        bAppliedSlideForce = false;
-    }
-}
-void AFPSCharacter::OnComponentHitCharacter(UPrimitiveComponent *HitComp, AActor *OtherActor,
-                                            UPrimitiveComponent *OtherComp, FVector NormalImpulse,
-                                            const FHitResult &Hit)
-{
-    // GEngine->AddOnScreenDebugMessage(0, 5.0f, FColor::Cyan, TEXT("CompHit"));
-    if (GetCharacterMovement()->IsMovingOnGround())
+    bIsCrouching = bPressed;
+    // Slide impulse and downhill acceleration are applied by the movement component
+    FPSMovement->SetWantsToSlide(bPressed);
+    if (Tuning->CrouchMode == EFPSCrouchMode::Capsule)
     {
-        if (bIsCrouching)
+        if (bPressed)
         {
-            if (GetCharacterMovement()->Velocity.Size() > 100.f && !bAppliedSlideForce)
-            {
-                // Adds impulse force to character
-                GetCharacterMovement()->Velocity += GetCharacterMovement()->Velocity.GetSafeNormal2D() * SlideForce;
-                bAppliedSlideForce = true;
-                // GEngine->AddOnScreenDebugMessage(0, 5.0f, FColor::Cyan, TEXT("JumpSlide"));
-            }
+            Crouch();
         }
-        // Sets bAppliedSlideForce to false when player hits ground and is not crouching
         else
         {
-            bAppliedSlideForce = false;
-            // GEngine->AddOnScreenDebugMessage(0, 5, FColor::Blue, TEXT("Slide reset"));
-        }
-        if (bIsWallrunning)
-        {
-            bIsWallrunning = false;
-        }
-    }
-    // Debug message
-    GEngine->AddOnScreenDebugMessage(0, 5, FColor::Emerald,
-                                     FString::Printf(TEXT("Normal: %s, RightVector: %s"), *Hit.Normal.ToString(),
-                                                     *GetActorRightVector().ToString()));
-    // Checks if there is a wall
-    if (IsWall(Hit.Normal))
-    {
-        if (!bIsWallrunning)
-        {
-            // GEngine->AddOnScreenDebugMessage(0, 5, FColor::Blue, TEXT("IsWall = True!"));
-            StartWallRun(Hit.Normal);
+            UnCrouch();
         }
-        bIsOnWall = true;
-    }
-}
-// Makes smoothly camera tilt when sliding
-void AFPSCharacter::SmoothCameraTilt(const float &Angle, const float &TiltSpeed, const float &DeltaTime)
-{
-    FRotator CameraTilt = CameraComp->GetRelativeRotation();
-    if (!FMath::IsNearlyEqual(CameraTilt.Roll, Angle))
-    {
-        CameraTilt.Roll = FMath::FInterpTo(CameraTilt.Roll, Angle, DeltaTime, TiltSpeed);
-        CameraComp->SetRelativeRotation(CameraTilt);
     }
+    OnMovementStateChanged();
+
+    // Adds message containing character velocity
+    // GEngine->AddOnScreenDebugMessage(0, 5.f, FColor::Green,
+    //                                  FString::Printf(TEXT("Velocity = %d"),
+    //                                  GetCharacterMovement()->Velocity.Size2D()));
+    ApplyCrouchTuning(bPressed);
 }
-// Gradually changes scale of player to crouch or normal scale
-void AFPSCharacter::GradualCrouch(const float &ZScale, const float &DeltaTime)
+// Switches friction and walk speed between the crouched and standing values
+void AFPSCharacter::ApplyCrouchTuning(bool bPressed)
 {
-    FVector NewScale = GetActorScale3D();
-    if (!FMath::IsNearlyEqual(NewScale.Z, ZScale))
+    const FPSMovementKernel::FMovementParams &Params = Tuning->GetParams();
+    if (bPressed)
     {
-        NewScale.Z = FMath::FInterpTo(NewScale.Z, ZScale, DeltaTime, CrouchTransitionSpeed);
-        SetActorScale3D(NewScale);
+        // Sets ground friction to sliding friction
+        GetCharacterMovement()->GroundFriction = Params.SlideFriction;
+        GetCharacterMovement()->BrakingFrictionFactor = Params.SlideBrakingFrictionFactor;
+        // Sets walkspeed to bIsCrouching walkspeed
+        GetCharacterMovement()->MaxWalkSpeed = Params.CrouchSpeed;
     }
-    FVector NewLocation = GetActorLocation();
-    float TargetLocationZ = NewLocation.Z + (NormalScale.Z - ZScale) * (bIsCrouching ? -1 : 1);
-    if (!FMath::IsNearlyEqual(NewLocation.Z, TargetLocationZ))
+    else
     {
-        NewLocation.Z = FMath::FInterpTo(NewLocation.Z, TargetLocationZ, DeltaTime, CrouchTransitionSpeed);
-        SetActorLocation(NewLocation);
+        // Reset to default walkspeed and friction
+        GetCharacterMovement()->GroundFriction = Params.GroundFriction;
+        GetCharacterMovement()->BrakingFrictionFactor = Params.BrakingFrictionFactor;
+        GetCharacterMovement()->MaxWalkSpeed = Params.WalkSpeed;
     }
 }
-// Checks if the object the player collides with is a wall
-bool AFPSCharacter::IsWall(const FVector &Normal)
+// Points the movement component at the tuning and applies the values it keeps itself
+void AFPSCharacter::ApplyTuning()
 {
-    return Normal.Z >= -0.01 && Normal.Z <= 0.5;
-    // return FMath::IsNearlyEqual(FMath::Abs(Normal.Z), 0);
-    // return FMath::IsNearlyEqual(FMath::Abs(Normal.X), 1) || FMath::IsNearlyEqual(FMath::Abs(Normal.Y), 1);
+    const FPSMovementKernel::FMovementParams &Params = Tuning->GetParams();
+    FPSMovement->SetMovementParams(Params);
+    FPSMovement->JumpZVelocity = Params.JumpZVelocity;
+    FPSMovement->Mass = Params.Mass;
+    FPSMovement->MaxWalkSpeedCrouched = Params.CrouchSpeed;
+    // Capsule crouch shrinks the capsule to the crouch scale of its standing height
+    const float StandingHalfHeight =
+        GetClass()->GetDefaultObject<ACharacter>()->GetCapsuleComponent()->GetUnscaledCapsuleHalfHeight();
+    FPSMovement->SetCrouchedHalfHeight(StandingHalfHeight * Params.CrouchScaleZ);
+    ApplyCrouchTuning(bIsCrouching);
 }
-// Starts the wall run
-void AFPSCharacter::StartWallRun(const FVector &Normal)
+// Reapplies the tuning after it was edited or set from the console
+void AFPSCharacter::OnTuningChanged(const UFPSMovementTuning *ChangedTuning)
 {
-    if (!GetCharacterMovement()->IsMovingOnGround())
-    {
-        WallNormalVector = Normal;
-        WallRunTiltDirection = FMath::Sign(FVector::DotProduct(GetActorRightVector(), WallNormalVector));
-        if (!bIsWallrunning)
-        {
-            GetCharacterMovement()->Velocity.Z = 0;
-            GetCharacterMovement()->Velocity.Z += 100.f;
-        }
-        bIsWallrunning = true;
-    }
+    ApplyTuning();
+    OnMovementStateChanged();
 }
-// Called every frame when wall running
-void AFPSCharacter::WallRun(const float &DeltaTime)
+// Called by the jump action
+void AFPSCharacter::JumpPressed(const FInputActionInstance &Instance)
 {
-    // Force to keep player on wall when wall running
-    GetCharacterMovement()->Velocity += -WallNormalVector * DeltaTime * WallRunSpeed;
-    // Counter gravity to make player fall slower
-    GetCharacterMovement()->Velocity += DeltaTime * GetCharacterMovement()->Mass * WallRunCounterGravity *
-                                        -GetCharacterMovement()->GetGravityDirection() * .4f;
+    RecordInput(FPSInputRecording::EAction::Jump);
+    JumpInput();
 }
-// Stops the wall running
-void AFPSCharacter::StopWallRun()
+// Same as pressing the jump action, jumps from the ground or off the wall. Only sets input, the movement
+// component jumps inside its next move.
+void AFPSCharacter::JumpInput()
 {
-    GetCharacterMovement()->Velocity += WallNormalVector * WallRunSpeed;
-    bIsWallrunning = false;
-    bIsOnWall = false;
+    Jump();
+    FPSMovement->SetWantsToWallJump(true);
 }
-// Jumps off the wall when wall running
-void AFPSCharacter::WallJump()
+// Adds an input event to the recording when recording
+void AFPSCharacter::RecordInput(FPSInputRecording::EAction Action, const FVector2D &Value)
 {
-    // Check if character is on wall and wall running
-    if (bIsWallrunning && bIsOnWall)
+    if (InputRecorder)
     {
-        StopWallRun();
-        GetCharacterMovement()->Launch(
-            (FVector::UpVector * 1.7 + WallNormalVector * 2 + GetCharacterMovement()->Velocity.GetSafeNormal()) *
-            WallJumpForce);
+        InputRecorder->Record(GetWorld()->GetTimeSeconds(), Action, Value);
     }
 }
 // TODO - Add function to apply gradual slide force
 void AFPSCharacter::GradualSlideForce(const float &DeltaTime)
 {
     // Velocity vector to add to player
-    FVector AddVelocity = FMath::FInterpTo(SlideForce, 0.f, DeltaTime, 20.f) * GetActorForwardVector();
+    FVector AddVelocity = FMath::FInterpTo(Tuning->SlideForce, 0.f, DeltaTime, 20.f) * GetActorForwardVector();
     if (FMath::IsNearlyEqual(AddVelocity.SizeSquared(), 0.f))
     {
         GetCharacterMovement()->Velocity += AddVelocity;
     }
 }
-// TODO - Add camera shake when player lands
 // TODO - Add double jumping
-// TODO - Add vaulting functionality
@@ -10,8 +10,27 @@
 #include "GameFramework/SpringArmComponent.h"
 #include "InputAction.h"
 #include "Math/MathFwd.h"
+#include "FPSMovementKernel.h"
+#include "FPSInputRecording.h"
+#include "FPSMovementSnapshot.h"
+#include "FPSCameraEffects.h"
+#include "FPSMovementTuning.h"
 #include "FPSCharacter.generated.h"
 
+class UFPSCharacterMovementComponent;
+
+// Movement level of detail, picked by the movement LOD subsystem from distance and visibility to local viewers
+UENUM()
+enum class EFPSMovementLOD : uint8
+{
+    // Ticks every frame and interpolates camera tilt and crouch
+    Full,
+    // Ticks less often and snaps camera tilt and crouch to their targets
+    Reduced,
+    // Skips cosmetic work, simulated proxies extrapolate replicated movement without collision
+    Minimal,
+};
+
 UCLASS()
 class MOVEMENT_REMAKE_API AFPSCharacter : public ACharacter
 {
@@ -19,11 +38,19 @@ class MOVEMENT_REMAKE_API AFPSCharacter : public ACharacter
 
 public:
     // Sets default values for this character's properties
-    AFPSCharacter();
+    AFPSCharacter(const FObjectInitializer &ObjectInitializer);
 
 protected:
+    // Moves values saved before the tuning moved into UFPSMovementTuning into a tuning
+    virtual void PostLoad() override;
+    // Picks the movement tuning before the movement component first uses it
+    virtual void PostInitializeComponents() override;
     // Called when the game starts or when spawned
     virtual void BeginPlay() override;
+    // Called when the character is removed from the world
+    virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+    // Allows jumping while crouched so slides can be jumped out of
+    virtual bool CanJumpInternal_Implementation() const override;
 
 public:
     // Called every frame
@@ -31,6 +58,48 @@ public:
 
     // Called to bind functionality to input
     virtual void SetupPlayerInputComponent(class UInputComponent *PlayerInputComponent) override;
+    // Called when the capsule shrinks or grows for crouching
+    virtual void OnStartCrouch(float HalfHeightAdjust, float ScaledHalfHeightAdjust) override;
+    virtual void OnEndCrouch(float HalfHeightAdjust, float ScaledHalfHeightAdjust) override;
+    // Starts the landing camera shake
+    virtual void Landed(const FHitResult &Hit) override;
+
+    // Called when crouching or the movement mode changes
+    void OnMovementStateChanged();
+    // Lowers the tick rate of simulated proxies and AI, 1 is fully significant and ticks every frame
+    void SetSignificance(float Significance);
+    // Switches cosmetic work, tick rate and proxy simulation to the level of detail
+    void SetMovementLOD(EFPSMovementLOD LOD);
+    EFPSMovementLOD GetMovementLOD() const
+    {
+        return MovementLOD;
+    }
+    UFPSCharacterMovementComponent *GetFPSMovement() const
+    {
+        return FPSMovement;
+    }
+    // Saves the state at the end of a frame for rollback, the movement component calls it after every move it
+    // runs from its tick with its movement frame
+    void SaveSnapshot(int32 Frame);
+    // Puts the character back to the end of a saved frame, returns false if it is no longer saved
+    bool RestoreSnapshot(int32 Frame);
+    // Restores a frame and steps up to NumFrames following frames with the input saved for them,
+    // overwriting their snapshots. Returns the number of frames simulated.
+    int32 Resimulate(int32 Frame, int32 NumFrames, float DeltaTime);
+    // Input handlers the action bindings forward to, also driven by the movement perf capture
+    void WalkInput(const FVector2D &Input);
+    void LookInput(const FVector2D &Input);
+    void SetCrouchInput(bool bPressed);
+    void JumpInput();
+    // Draws the mesh and camera at this world offset from the capsule, set by fixed step movement every frame
+    void SetPresentationOffset(const FVector &Offset);
+    // Applies a camera tilt and crouch step computed by the batch movement subsystem
+    void ApplyBatchedView(const FPSMovementKernel::FViewState &View, const FPSMovementKernel::FViewStep &Step);
+    // Called by the batch movement subsystem when this character moves to another lane
+    void SetBatchMovementLane(int32 Lane)
+    {
+        BatchMovementLane = Lane;
+    }
 
 private:
     // Base character components
@@ -42,6 +111,9 @@ private:
     USpringArmComponent *SpringArm;
     UPROPERTY(EditAnywhere, Category = "Components")
     UCapsuleComponent *PlayerOverlapCollider;
+    // Movement component with slide and wall run modes
+    UPROPERTY()
+    UFPSCharacterMovementComponent *FPSMovement;
 
     // Input actions
     UPROPERTY(EditAnywhere, Category = "Input")
@@ -53,85 +125,65 @@ private:
     UPROPERTY(EditAnywhere, Category = "Input")
     UInputAction *CrouchAction;
 
-    // Values
-
-    // Scale when crouching
-    UPROPERTY(EditAnywhere, Category = "Values")
-    FVector CrouchScale = {1, 1, .5f};
-    // Scale in normal state
-    UPROPERTY(EditAnywhere, Category = "Values")
-    FVector NormalScale = {1, 1, 1};
-
-    // Movement Physics
-
-    // Normal Walkspeed
-    UPROPERTY(EditAnywhere, Category = "Movement")
-    float WalkSpeed = 600.f;
-    // Crouched Walkspeed
-    UPROPERTY(EditAnywhere, Category = "Movement")
-    float CrouchSpeed = 300.f;
-    // Slide force impulse applied when character slides
-    UPROPERTY(EditAnywhere, Category = "Movement")
-    float SlideForce = 1000.f;
-    // Ground friction when sliding
-    UPROPERTY(EditAnywhere, Category = "Movement")
-    float SlideFriction = .2f;
-    UPROPERTY(EditAnywhere, Category = "Movement")
-    float WallRunCounterGravity = 1;
-    UPROPERTY(EditAnywhere, Category = "Movement")
-    float WallRunSpeed = 1000;
+    // Movement tuning shared with other characters, the class defaults of UFPSMovementTuning when unset
     UPROPERTY(EditAnywhere, Category = "Movement")
-    float WallJumpForce = 300.f;
-    // TODO - Implement air strafing function for this
-    UPROPERTY(EditAnywhere, Category = "Movement")
-    float AirStrafeAcceleration = 500.f;
-    // TODO - Implement modified walk function for this
-    UPROPERTY(EditAnywhere, Category = "Movement")
-    float MaxWalkSpeed = 600.f;
-    // Rate at which player's velocity is interpolated to wish velocity
-    UPROPERTY(EditAnywhere, Category = "Movement")
-    float GroundAcceleration = 10.f;
-
-    // Transition Speeds
-
-    // Camera tilt transition speed when sliding
-    UPROPERTY(EditAnywhere, Category = "Transitions")
-    float SlideCameraTiltSpeed = 7.f;
-    // Transition speed of crouching
-    UPROPERTY(EditAnywhere, Category = "Transitions")
-    float CrouchTransitionSpeed = 25.f;
-    // Wall running camera tilt speed
-    UPROPERTY(EditAnywhere, Category = "Transitions")
-    float WallRunTransitionSpeed = 10.f;
-    // Angle camera tilts at when wall running
-    UPROPERTY(EditAnywhere, Category = "Transitions")
-    float WallRunCameraTiltAngle = 10.f;
+    UFPSMovementTuning *MovementTuning;
+    // Walk speed saved by blueprints and placed characters before it moved into the tuning, negative when none
+    // was saved. Only loaded, PostLoad moves it into the tuning.
+    UPROPERTY()
+    float WalkSpeed_DEPRECATED = -1.f;
+
+    // Performance
+
+    // Updates camera tilt and crouch in the batch movement subsystem instead of ticking, used for bots
+    UPROPERTY(EditAnywhere, Category = "Performance")
+    bool bUseBatchedMovement = false;
+    // Tick interval of simulated proxies and AI at zero significance, locally controlled characters always tick
+    // every frame while a transition is active
+    UPROPERTY(EditAnywhere, Category = "Performance", meta = (ClampMin = "0"))
+    float LowSignificanceTickInterval = .1f;
 
     // States to keep track of
 
+    // Tuning in use, MovementTuning or the class defaults
+    UPROPERTY(Transient)
+    UFPSMovementTuning *Tuning = nullptr;
+    FDelegateHandle TuningChangedHandle;
+
     // True whenever player is crouching
     bool bIsCrouching = false;
-    // True whenever initial slide impulse is applied to the player
-    bool bAppliedSlideForce = false;
-    // True when player is wallrunning
-    bool bIsWallrunning = false;
-    // Normal vector for wall normal
-    FVector WallNormalVector;
-    // Dot product between wall normal and player right vector
-    float WallRunTiltDirection = 0;
-    // True when player is running on wall
-    bool bIsOnWall = false;
     // TODO - Check if this bool variable is needed in the implementation
     // True when player slide force is being applied
     bool bIsSliding = false;
-    // Frame counter to help run code every few frames
-    // Note: Overflow of this number is intentional
-    uint8 FrameCounter = 0;
+    // Crouch scale and camera roll stepped by the movement kernel
+    FPSMovementKernel::FViewState ViewState = {};
+    // Player mesh scale when standing, used by capsule crouch
+    FVector PlayerMeshBaseScale = FVector::OneVector;
+    FVector PlayerMeshBaseLocation = FVector::ZeroVector;
+    // Offset between the last two fixed movement steps the mesh and camera are drawn at
+    FVector PresentationOffset = FVector::ZeroVector;
+    // Blends camera tilt, crouch offset and landing shake into one camera write per frame
+    FFPSCameraEffects CameraEffects;
+    // Dip of the landing shake in progress, zero when there is none
+    float ActiveLandingShakeAngle = 0.f;
+    float LandingShakeElapsed = 0.f;
+    // Lane in the batch movement subsystem when batched
+    int32 BatchMovementLane = INDEX_NONE;
+    // Level of detail set by the movement LOD subsystem
+    EFPSMovementLOD MovementLOD = EFPSMovementLOD::Full;
+    // Recent frames for rollback
+    FFPSMovementSnapshotRing Snapshots;
+    // Writes the player's input to a file when started with -RecordInput
+    TUniquePtr<FPSInputRecording::FRecorder> InputRecorder;
+    // Walk input held when it was last recorded, walk records are only written when it changes
+    FVector2D RecordedWalkInput = FVector2D::ZeroVector;
 
 private:
     // Function for fps camera rotations
     UFUNCTION()
     void Walk(const FInputActionInstance &Instance);
+    UFUNCTION()
+    void StopWalk(const FInputActionInstance &Instance);
     // Function for basic fps movement
     UFUNCTION()
     void Look(const FInputActionInstance &Instance);
@@ -140,27 +192,29 @@ private:
     UFUNCTION()
     void StopCrouch(const FInputActionInstance &Instance);
     UFUNCTION()
-    void OnComponentHitCharacter(UPrimitiveComponent *HitComp, AActor *OtherActor, UPrimitiveComponent *OtherComp,
-                                 FVector NormalImpulse, const FHitResult &Hit);
-    UFUNCTION()
-    void SmoothCameraTilt(const float &Angle, const float &TiltSpeed, const float &DeltaTime);
-    UFUNCTION()
-    void GradualCrouch(const float &Scale, const float &DeltaTime);
+    void JumpPressed(const FInputActionInstance &Instance);
     // TODO - Implement Slide force function
     // UFUNCTION()
     // void ApplySlideForce();
-    // TODO - Implement IsWall function
-    UFUNCTION()
-    bool IsWall(const FVector &Normal);
-    UFUNCTION()
-    void StartWallRun(const FVector &Normal);
-    UFUNCTION()
-    void WallRun(const float &DeltaTime);
-    UFUNCTION()
-    void StopWallRun();
-    UFUNCTION()
-    void WallJump();
     UFUNCTION()
     void GradualSlideForce(const float &DeltaTime);
-    
+    // Points the movement component at the tuning and applies the values it keeps itself
+    void ApplyTuning();
+    void OnTuningChanged(const UFPSMovementTuning *ChangedTuning);
+    // Adds an input event to the recording when recording
+    void RecordInput(FPSInputRecording::EAction Action, const FVector2D &Value = FVector2D::ZeroVector);
+    // Writes the view state to the actor transform and submits the camera effects
+    void ApplyViewStep(const FPSMovementKernel::FViewStep &Step);
+    // Blends tilt, crouch offset, landing shake and presentation offset into the camera
+    void ApplyCameraEffects();
+    // Switches friction and walk speed between the crouched and standing values
+    void ApplyCrouchTuning(bool bPressed);
+    // Writes the whole view state, used after a rollback
+    void ApplyFullView();
+    // Jumps the camera tilt and crouch straight to their targets, used below full level of detail
+    void SnapView();
+    // Ticks only while a camera tilt or crouch transition needs stepping
+    void ScheduleViewTick();
+    // True when view transitions change gameplay state or are seen on this machine
+    bool NeedsViewTick() const;
 };
@@ -0,0 +1,1240 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "FPSCharacterMovementComponent.h"
+#include "FPSCharacter.h"
+#include "FPSMovementStats.h"
+#include "FPSMovementTelemetrySubsystem.h"
+#include "FPSWallIndexSubsystem.h"
+#include "Components/CapsuleComponent.h"
+#include "Engine/World.h"
+#include "GameFramework/Character.h"
+#include "Math/UnrealMathUtility.h"
+
+namespace
+{
+    // Cosine of the largest angle between the probe direction and a wall the player can climb
+    constexpr float LedgeFacingTolerance = .5f;
+
+    // Slots in LedgeProbes
+    constexpr int32 LedgeProbeWall = 0;
+    constexpr int32 LedgeProbeTop = 1;
+    constexpr int32 LedgeProbeClearance = 2;
+
+    float FixedStepRate = 0.f;
+    FAutoConsoleVariableRef CVarFixedStepRate(
+        TEXT("fps.Movement.FixedStepRate"), FixedStepRate,
+        TEXT("Steps locally controlled and AI movement at this many Hz instead of once per frame and draws the\n"
+             "character between the last two steps. 0: step with the frame (default)"));
+
+    // Steps run in one frame before the rest of the frame time is dropped, keeps a hitch from snowballing
+    constexpr int32 MaxFixedStepsPerFrame = 4;
+
+    // Cosine of the largest angle between a wall contact and the indexed wall that confirms it, covers the
+    // rounding of the packed normal
+    constexpr float WallIndexNormalTolerance = .99f;
+
+    // Seconds before reaching an indexed wall that the camera starts tilting towards it
+    constexpr float WallPreAlignTime = .2f;
+
+    const FHitResult *FindBlockingHit(const FTraceDatum &Datum)
+    {
+        return Datum.OutHits.FindByPredicate([](const FHitResult &Hit) { return Hit.bBlockingHit; });
+    }
+} // namespace
+
+void FSavedMove_FPS::Clear()
+{
+    Super::Clear();
+    bSavedWantsToSlide = false;
+    bSavedWantsToWallJump = false;
+    bSavedWallContact = false;
+    bSavedWantsToMantle = false;
+    SavedWallNormal = 0;
+    SavedMantleTarget = FVector::ZeroVector;
+}
+
+uint8 FSavedMove_FPS::GetCompressedFlags() const
+{
+    uint8 Flags = Super::GetCompressedFlags();
+    if (bSavedWantsToSlide)
+    {
+        Flags |= FLAG_WantsToSlide;
+    }
+    if (bSavedWantsToWallJump)
+    {
+        Flags |= FLAG_WantsToWallJump;
+    }
+    if (bSavedWallContact)
+    {
+        Flags |= FLAG_WallContact;
+    }
+    if (bSavedWantsToMantle)
+    {
+        Flags |= FLAG_WantsToMantle;
+    }
+    return Flags;
+}
+
+bool FSavedMove_FPS::CanCombineWith(const FSavedMovePtr &NewMove, ACharacter *InCharacter, float MaxDelta) const
+{
+    const FSavedMove_FPS *NewFPSMove = static_cast<const FSavedMove_FPS *>(NewMove.Get());
+    if (bSavedWantsToSlide != NewFPSMove->bSavedWantsToSlide ||
+        bSavedWantsToWallJump != NewFPSMove->bSavedWantsToWallJump ||
+        bSavedWallContact != NewFPSMove->bSavedWallContact || SavedWallNormal != NewFPSMove->SavedWallNormal ||
+        bSavedWantsToMantle || NewFPSMove->bSavedWantsToMantle)
+    {
+        return false;
+    }
+    return Super::CanCombineWith(NewMove, InCharacter, MaxDelta);
+}
+
+void FSavedMove_FPS::SetMoveFor(ACharacter *C, float InDeltaTime, FVector const &NewAccel,
+                                FNetworkPredictionData_Client_Character &ClientData)
+{
+    Super::SetMoveFor(C, InDeltaTime, NewAccel, ClientData);
+    const UFPSCharacterMovementComponent *Movement = CastChecked<UFPSCharacterMovementComponent>(C->GetCharacterMovement());
+    const FPSMovementKernel::FMovementState &State = Movement->GetMovementState();
+    bSavedWantsToSlide = State.bWantsToSlide;
+    bSavedWantsToWallJump = Movement->WantsToWallJump();
+    bSavedWallContact = State.bIsOnWall;
+    SavedWallNormal = State.bIsOnWall ? FPSMovementKernel::PackWallNormal(State.WallNormal) : 0;
+    bSavedWantsToMantle = Movement->WantsToMantle();
+    SavedMantleTarget = bSavedWantsToMantle ? Movement->GetMantleTarget() : FVector::ZeroVector;
+}
+
+void FSavedMove_FPS::PrepMoveFor(ACharacter *C)
+{
+    Super::PrepMoveFor(C);
+    UFPSCharacterMovementComponent *Movement = CastChecked<UFPSCharacterMovementComponent>(C->GetCharacterMovement());
+    Movement->SetWantsToSlide(bSavedWantsToSlide);
+    Movement->SetWantsToWallJump(bSavedWantsToWallJump);
+    Movement->SetWantsToMantle(bSavedWantsToMantle, SavedMantleTarget);
+}
+
+FNetworkPredictionData_Client_FPS::FNetworkPredictionData_Client_FPS(const UCharacterMovementComponent &ClientMovement)
+    : Super(ClientMovement)
+{
+}
+
+FSavedMovePtr FNetworkPredictionData_Client_FPS::AllocateNewMove()
+{
+    return FSavedMovePtr(new FSavedMove_FPS());
+}
+
+void FFPSNetworkMoveData::ClientFillNetworkMoveData(const FSavedMove_Character &ClientMove, ENetworkMoveType MoveType)
+{
+    Super::ClientFillNetworkMoveData(ClientMove, MoveType);
+    const FSavedMove_FPS &FPSMove = static_cast<const FSavedMove_FPS &>(ClientMove);
+    WallNormal = FPSMove.SavedWallNormal;
+    MantleTarget = FPSMove.SavedMantleTarget;
+}
+
+bool FFPSNetworkMoveData::Serialize(UCharacterMovementComponent &CharacterMovement, FArchive &Ar,
+                                    UPackageMap *PackageMap, ENetworkMoveType MoveType)
+{
+    Super::Serialize(CharacterMovement, Ar, PackageMap, MoveType);
+    // The normal is only sent with moves that report wall contact
+    if (CompressedMoveFlags & FSavedMove_FPS::FLAG_WallContact)
+    {
+        Ar.SerializeBits(&WallNormal, FPSMovementKernel::WallNormalBits);
+    }
+    else
+    {
+        WallNormal = 0;
+    }
+    // The ledge target is only sent with moves that start a climb
+    if (CompressedMoveFlags & FSavedMove_FPS::FLAG_WantsToMantle)
+    {
+        bool bOutSuccess = true;
+        MantleTarget.NetSerialize(Ar, PackageMap, bOutSuccess);
+    }
+    else
+    {
+        MantleTarget = FVector::ZeroVector;
+    }
+    return !Ar.IsError();
+}
+
+FFPSNetworkMoveDataContainer::FFPSNetworkMoveDataContainer()
+{
+    NewMoveData = &FPSMoveData[0];
+    PendingMoveData = &FPSMoveData[1];
+    OldMoveData = &FPSMoveData[2];
+}
+
+// Sets default values for this component's properties
+UFPSCharacterMovementComponent::UFPSCharacterMovementComponent()
+{
+    // Used by the capsule crouch mode
+    NavAgentProps.bCanCrouch = true;
+    SetNetworkMoveDataContainer(FPSMoveDataContainer);
+}
+
+void UFPSCharacterMovementComponent::BeginPlay()
+{
+    Super::BeginPlay();
+    WallIndex = GetWorld()->GetSubsystem<UFPSWallIndexSubsystem>();
+    if (UFPSMovementTelemetrySubsystem *TelemetrySubsystem =
+            GetWorld()->GetSubsystem<UFPSMovementTelemetrySubsystem>())
+    {
+        Telemetry = TelemetrySubsystem->OpenChannel(GetNameSafe(GetOwner()));
+    }
+}
+
+void UFPSCharacterMovementComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+    // The writer drains what is left in the ring and then releases it
+    if (Telemetry)
+    {
+        Telemetry->bClosed.store(true, std::memory_order_release);
+        Telemetry.Reset();
+    }
+    Super::EndPlay(EndPlayReason);
+}
+
+void UFPSCharacterMovementComponent::TickComponent(float DeltaTime, enum ELevelTick TickType,
+                                                   FActorComponentTickFunction *ThisTickFunction)
+{
+    FPS_MOVEMENT_SCOPE(STAT_FPSMovementTick);
+    FPSMovementFrameStats::FScopedMovementTimer MovementTimer;
+    // Turns last frame's probes into input before the move is saved, so the climb is sent with it
+    if (bLedgeProbesPending)
+    {
+        ConsumeLedgeProbes();
+    }
+    const float FixedStepTime = GetFixedStepTime();
+    if (FixedStepTime <= 0.f)
+    {
+        if (!PresentationOffset.IsZero())
+        {
+            ResetPresentation();
+            ApplyPresentation();
+        }
+        Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+        SaveFrameSnapshot();
+    }
+    else
+    {
+        // Runs as many whole steps as the frame time covers, every step moves with the input of this frame
+        FixedStepRemainder += DeltaTime;
+        const FVector InputVector = PawnOwner ? PawnOwner->GetPendingMovementInputVector() : FVector::ZeroVector;
+        int32 NumSteps = 0;
+        for (; FixedStepRemainder >= FixedStepTime && NumSteps < MaxFixedStepsPerFrame; NumSteps++)
+        {
+            if (NumSteps > 0)
+            {
+                PawnOwner->Internal_AddMovementInput(InputVector);
+            }
+            PreviousStepLocation = UpdatedComponent->GetComponentLocation();
+            Super::TickComponent(FixedStepTime, TickType, ThisTickFunction);
+            SaveFrameSnapshot();
+            FixedStepRemainder -= FixedStepTime;
+        }
+        if (NumSteps == 0 && PawnOwner)
+        {
+            // Input is added again every frame, unconsumed input would add up until the next step
+            PawnOwner->ConsumeMovementInputVector();
+        }
+        FixedStepRemainder = FMath::Min(FixedStepRemainder, FixedStepTime);
+
+        // Draws the capsule as far between the last two steps as the frame is between them
+        if (GetNetMode() != NM_DedicatedServer)
+        {
+            const float Alpha = FixedStepRemainder / FixedStepTime;
+            PresentationOffset = (PreviousStepLocation - UpdatedComponent->GetComponentLocation()) * (1.f - Alpha);
+            ApplyPresentation();
+        }
+    }
+    // Probes from where this frame's movement ended, the results are the mantle input of next frame's movement
+    SendLedgeProbes();
+}
+
+// Seconds of one fixed movement step, zero when movement steps with the frame
+float UFPSCharacterMovementComponent::GetFixedStepTime() const
+{
+    // Only moves this machine runs from its own tick are stepped, the server runs client moves with their own
+    // time steps and simulated proxies follow replication
+    if (FixedStepRate <= 0.f || !CharacterOwner || !UpdatedComponent || GetOwnerRole() == ROLE_SimulatedProxy ||
+        (!CharacterOwner->IsLocallyControlled() && CharacterOwner->IsPlayerControlled()))
+    {
+        return 0.f;
+    }
+    return 1.f / FixedStepRate;
+}
+
+void UFPSCharacterMovementComponent::OnTeleported()
+{
+    Super::OnTeleported();
+    ResetPresentation();
+}
+
+void UFPSCharacterMovementComponent::SaveFrameSnapshot()
+{
+    // Only moves run here can be replayed, the server rolls back remote players with their own moves
+    if (!HasValidData() || !CharacterOwner->IsLocallyControlled())
+    {
+        return;
+    }
+    if (AFPSCharacter *FPSCharacter = Cast<AFPSCharacter>(CharacterOwner))
+    {
+        FPSCharacter->SaveSnapshot(++MovementFrame);
+    }
+}
+
+// Forgets the previous fixed step so the capsule is drawn where it is
+void UFPSCharacterMovementComponent::ResetPresentation()
+{
+    PreviousStepLocation = UpdatedComponent ? UpdatedComponent->GetComponentLocation() : FVector::ZeroVector;
+    PresentationOffset = FVector::ZeroVector;
+}
+
+// Hands the presentation offset to the character, which draws its mesh and camera there
+void UFPSCharacterMovementComponent::ApplyPresentation()
+{
+    if (AFPSCharacter *FPSCharacter = Cast<AFPSCharacter>(CharacterOwner))
+    {
+        FPSCharacter->SetPresentationOffset(PresentationOffset);
+    }
+}
+
+bool UFPSCharacterMovementComponent::CanCrouchInCurrentState() const
+{
+    // Stays crouched through slides and wall runs
+    return Super::CanCrouchInCurrentState() || (CanEverCrouch() && IsWallRunning());
+}
+
+bool UFPSCharacterMovementComponent::CanAttemptJump() const
+{
+    // Unlike the default, crouching does not stop jumping so slides can be jumped out of, and wall runs jump
+    // off the wall
+    return IsJumpAllowed() && (IsMovingOnGround() || IsFalling() || IsWallRunning());
+}
+
+bool UFPSCharacterMovementComponent::DoJump(bool bReplayingMoves)
+{
+    // Called from the move on the client, the server and in replays, so the wall jump is predicted like a jump
+    if (IsWallRunning())
+    {
+        return bWantsToWallJump && WallJump();
+    }
+    return Super::DoJump(bReplayingMoves);
+}
+
+FNetworkPredictionData_Client *UFPSCharacterMovementComponent::GetPredictionData_Client() const
+{
+    if (!ClientPredictionData)
+    {
+        UFPSCharacterMovementComponent *MutableThis = const_cast<UFPSCharacterMovementComponent *>(this);
+        MutableThis->ClientPredictionData = new FNetworkPredictionData_Client_FPS(*this);
+    }
+    return ClientPredictionData;
+}
+
+void UFPSCharacterMovementComponent::UpdateFromCompressedFlags(uint8 Flags)
+{
+    Super::UpdateFromCompressedFlags(Flags);
+    MoveState.bWantsToSlide = (Flags & FSavedMove_FPS::FLAG_WantsToSlide) != 0;
+    bWantsToWallJump = (Flags & FSavedMove_FPS::FLAG_WantsToWallJump) != 0;
+    // Replayed moves keep the target restored by PrepMoveFor, the server takes the client's. StartMantle checks
+    // the target is within reach and has a ledge to stand on, and the climb sweeps, so a client cannot climb
+    // through geometry or into the air.
+    bWantsToMantle = (Flags & FSavedMove_FPS::FLAG_WantsToMantle) != 0;
+    if (bWantsToMantle)
+    {
+        if (const FFPSNetworkMoveData *MoveData = static_cast<const FFPSNetworkMoveData *>(GetCurrentNetworkMoveData()))
+        {
+            MantleTarget = MoveData->MantleTarget;
+        }
+    }
+
+    // On the server, takes the client's wall contact when our own hits missed it. It is confirmed with a
+    // sweep before it is used, so a client cannot wall run on a wall that is not there.
+    if (Flags & FSavedMove_FPS::FLAG_WallContact)
+    {
+        if (const FFPSNetworkMoveData *MoveData = static_cast<const FFPSNetworkMoveData *>(GetCurrentNetworkMoveData()))
+        {
+            FPSMovementKernel::SuggestWallContact(MoveState, *MoveParams,
+                                                  FPSMovementKernel::UnpackWallNormal(MoveData->WallNormal),
+                                                  IsMovingOnGround());
+        }
+    }
+}
+
+void UFPSCharacterMovementComponent::ServerMove_PerformMovement(const FCharacterNetworkMoveData &MoveData)
+{
+    // What the envelope allows depends on the state the move started in
+    uint8 Flags = 0;
+    if (IsSliding())
+    {
+        Flags |= FPSMovementKernel::MoveSampleSliding;
+    }
+    if (IsWallRunning())
+    {
+        Flags |= FPSMovementKernel::MoveSampleWallRunning;
+    }
+    if (MoveState.bIsOnWall || MoveState.bIsWallrunning)
+    {
+        Flags |= FPSMovementKernel::MoveSampleOnWall;
+    }
+    if (IsMantling())
+    {
+        Flags |= FPSMovementKernel::MoveSampleClimbing;
+    }
+    const bool bHadSlideForce = MoveState.bAppliedSlideForce;
+
+    Super::ServerMove_PerformMovement(MoveData);
+
+    const FNetworkPredictionData_Server_Character *ServerData = GetPredictionData_Server_Character();
+    if (!ServerData || ServerData->CurrentClientTimeStamp != MoveData.TimeStamp)
+    {
+        // Rejected as too old or invalid, nothing moved
+        return;
+    }
+    if (!bHadSlideForce && MoveState.bAppliedSlideForce)
+    {
+        Flags |= FPSMovementKernel::MoveSampleSlideImpulse;
+    }
+    // A climb started by this move rises in it
+    if (IsMantling())
+    {
+        Flags |= FPSMovementKernel::MoveSampleClimbing;
+    }
+
+    // Locations relative to a moving base are not comparable between moves, the server's location is used then
+    const FVector ReportedLocation = MovementBaseUtility::UseRelativeLocation(MoveData.MovementBase)
+                                         ? UpdatedComponent->GetComponentLocation()
+                                         : FVector(MoveData.Location);
+    const float MoveDeltaTime = MoveData.TimeStamp - LastReportedTimeStamp;
+    // Corrections, teleports and timestamp resets move the client without a move, start again from here
+    const bool bRebase = !bHasReportedLocation || MoveDeltaTime <= 0.f || bJustTeleported ||
+                         !ServerData->PendingAdjustment.bAckGoodMove;
+    if (!bRebase)
+    {
+        PendingMoveSample.Delta += ToKernelVector(ReportedLocation - LastReportedLocation);
+        PendingMoveSample.DeltaTime += MoveDeltaTime;
+        PendingMoveSample.Flags |= Flags;
+        if (Flags & FPSMovementKernel::MoveSampleClimbing)
+        {
+            PendingMoveSample.ClimbReach = GetLedgeReach();
+        }
+    }
+    LastReportedLocation = bRebase ? UpdatedComponent->GetComponentLocation() : ReportedLocation;
+    LastReportedTimeStamp = MoveData.TimeStamp;
+    bHasReportedLocation = true;
+}
+
+bool UFPSCharacterMovementComponent::ConsumeMoveSample(FPSMovementKernel::FMoveSample &OutSample)
+{
+    if (PendingMoveSample.DeltaTime <= 0.f)
+    {
+        return false;
+    }
+    OutSample = PendingMoveSample;
+    PendingMoveSample = {};
+    return true;
+}
+
+void UFPSCharacterMovementComponent::SimulateMovement(float DeltaTime)
+{
+    if (!bSimpleExtrapolation || !HasValidData() || CharacterOwner->GetLocalRole() != ROLE_SimulatedProxy)
+    {
+        Super::SimulateMovement(DeltaTime);
+        return;
+    }
+    // Carries the replicated velocity forward without collision, the next replicated update corrects any drift
+    const FVector Extrapolated =
+        IsMovingOnGround() ? FVector(Velocity.X, Velocity.Y, 0.f) * DeltaTime : Velocity * DeltaTime;
+    UpdatedComponent->SetWorldLocation(UpdatedComponent->GetComponentLocation() + Extrapolated);
+}
+
+void UFPSCharacterMovementComponent::SetSimpleExtrapolation(bool bEnable)
+{
+    if (bEnable == bSimpleExtrapolation)
+    {
+        return;
+    }
+    bSimpleExtrapolation = bEnable;
+    // Corrections snap instead of being smoothed, too far away to notice
+    if (bEnable)
+    {
+        SmoothingModeBeforeExtrapolation = NetworkSmoothingMode;
+        NetworkSmoothingMode = ENetworkSmoothingMode::Disabled;
+    }
+    else
+    {
+        NetworkSmoothingMode = SmoothingModeBeforeExtrapolation;
+    }
+}
+
+const FPSMovementKernel::FMovementParams UFPSCharacterMovementComponent::DefaultMoveParams =
+    FPSMovementKernel::MakeDefaultParams();
+
+void UFPSCharacterMovementComponent::SetMovementParams(const FPSMovementKernel::FMovementParams &InParams)
+{
+    MoveParams = &InParams;
+}
+
+float UFPSCharacterMovementComponent::GetMaxSpeed() const
+{
+    // Sliding uses the crouch speed, taken from the tuning values so client and server agree
+    if (IsSliding())
+    {
+        return MoveParams->CrouchSpeed;
+    }
+    return Super::GetMaxSpeed();
+}
+
+float UFPSCharacterMovementComponent::GetMaxBrakingDeceleration() const
+{
+    if (IsSliding())
+    {
+        return BrakingDecelerationWalking;
+    }
+    if (IsWallRunning())
+    {
+        return BrakingDecelerationFalling;
+    }
+    return Super::GetMaxBrakingDeceleration();
+}
+
+bool UFPSCharacterMovementComponent::IsMovingOnGround() const
+{
+    return Super::IsMovingOnGround() || IsSliding();
+}
+
+void UFPSCharacterMovementComponent::SetWantsToSlide(bool bInWantsToSlide)
+{
+    MoveState.bWantsToSlide = bInWantsToSlide;
+}
+
+void UFPSCharacterMovementComponent::NotifyWallContact(const FVector &Normal)
+{
+    FPSMovementKernel::NotifyWallContact(MoveState, ToKernelVector(Normal), IsMovingOnGround());
+}
+
+bool UFPSCharacterMovementComponent::WallJump()
+{
+    // Check if character is on wall and wall running
+    if (!IsWallRunning())
+    {
+        return false;
+    }
+    MoveState.Velocity = ToKernelVector(Velocity);
+    Launch(FromKernelVector(FPSMovementKernel::WallJump(MoveState, *MoveParams)));
+    RecordTelemetry(FPSMovementTelemetry::EEvent::WallJump);
+    return true;
+}
+
+FPSMovementTrajectory::FArc UFPSCharacterMovementComponent::PredictArc() const
+{
+    const FPSMovementKernel::FVec3 Location = ToKernelVector(UpdatedComponent->GetComponentLocation());
+    FPSMovementKernel::FMovementState State = MoveState;
+    State.Velocity = ToKernelVector(Velocity);
+    if (IsSliding())
+    {
+        return FPSMovementTrajectory::MakeSlideArc(State, *MoveParams, Location,
+                                                   ToKernelVector(CurrentFloor.HitResult.Normal),
+                                                   GetMaxBrakingDeceleration(), !Acceleration.IsNearlyZero());
+    }
+    if (IsWallRunning())
+    {
+        return FPSMovementTrajectory::MakeWallRunArc(State, *MoveParams, Location, GetGravityZ());
+    }
+    if (IsMovingOnGround())
+    {
+        const float Friction = (bUseSeparateBrakingFriction ? BrakingFriction : GroundFriction) * BrakingFrictionFactor;
+        return FPSMovementTrajectory::MakeWalkArc(Location, State.Velocity,
+                                                  ToKernelVector(CurrentFloor.HitResult.Normal), Friction,
+                                                  GetMaxBrakingDeceleration(), GetMaxSpeed(),
+                                                  !Acceleration.IsNearlyZero());
+    }
+    if (IsMantling())
+    {
+        // Climbs follow a fixed path rather than an arc, so the arc stays where the climb ends
+        return FPSMovementTrajectory::MakeFallArc(State.MantleTarget, {0.f, 0.f, 0.f}, 0.f);
+    }
+    // Falling, the character has no flying or swimming
+    return FPSMovementTrajectory::MakeFallArc(Location, State.Velocity, GetGravityZ());
+}
+
+bool UFPSCharacterMovementComponent::PredictWallJumpArc(FPSMovementTrajectory::FArc &OutArc) const
+{
+    if (!IsWallRunning())
+    {
+        return false;
+    }
+    FPSMovementKernel::FMovementState State = MoveState;
+    State.Velocity = ToKernelVector(Velocity);
+    OutArc = FPSMovementTrajectory::MakeWallJumpArc(
+        State, *MoveParams, ToKernelVector(UpdatedComponent->GetComponentLocation()), GetGravityZ());
+    return true;
+}
+
+void UFPSCharacterMovementComponent::SaveMovementSnapshot(FFPSMovementSnapshot &Snapshot) const
+{
+    Snapshot.Location = UpdatedComponent->GetComponentLocation();
+    Snapshot.Rotation = UpdatedComponent->GetComponentQuat();
+    Snapshot.Velocity = Velocity;
+    Snapshot.MoveState = MoveState;
+    Snapshot.MovementMode = MovementMode;
+    Snapshot.CustomMovementMode = CustomMovementMode;
+    Snapshot.bIsCrouched = CharacterOwner->bIsCrouched;
+    Snapshot.Input = LastMoveInput;
+}
+
+void UFPSCharacterMovementComponent::RestoreMovementSnapshot(const FFPSMovementSnapshot &Snapshot)
+{
+    // Resizes the capsule first, the location is restored afterwards
+    if (Snapshot.bIsCrouched != CharacterOwner->bIsCrouched)
+    {
+        bWantsToCrouch = Snapshot.bIsCrouched;
+        if (Snapshot.bIsCrouched)
+        {
+            Crouch();
+        }
+        else
+        {
+            UnCrouch();
+        }
+    }
+
+    // Sets the mode directly, entering a mode again would rerun the wall run start and landing
+    MovementMode = EMovementMode(Snapshot.MovementMode);
+    CustomMovementMode = Snapshot.CustomMovementMode;
+    bCrouchMaintainsBaseLocation = IsMovingOnGround();
+    MoveState = Snapshot.MoveState;
+    LastMoveInput = Snapshot.Input;
+    Velocity = Snapshot.Velocity;
+    UpdatedComponent->SetWorldLocationAndRotation(Snapshot.Location, Snapshot.Rotation, false, nullptr,
+                                                  ETeleportType::TeleportPhysics);
+    bJustTeleported = true;
+    if (IsMovingOnGround())
+    {
+        FindFloor(UpdatedComponent->GetComponentLocation(), CurrentFloor, false);
+    }
+    else
+    {
+        CurrentFloor.Clear();
+    }
+    UpdateComponentVelocity();
+    ResetPresentation();
+}
+
+void UFPSCharacterMovementComponent::ResimulateMove(const FFPSMovementInput &Input, float DeltaTime)
+{
+    if (!HasValidData())
+    {
+        return;
+    }
+    // Same order as a locally controlled move: jump input, then the move, then clearing the jump input
+    TGuardValue<bool> ResimulatingGuard(bResimulating, true);
+    CharacterOwner->bPressedJump = Input.bPressedJump;
+    bWantsToCrouch = Input.bWantsToCrouch;
+    MoveState.bWantsToSlide = Input.bWantsToSlide;
+    // A recorded wall jump is replayed through its launch velocity
+    bWantsToWallJump = false;
+    bWantsToMantle = Input.bWantsToMantle;
+    MantleTarget = Input.MantleTarget;
+    PendingLaunchVelocity = Input.LaunchVelocity;
+    CharacterOwner->CheckJumpInput(DeltaTime);
+    Acceleration = Input.Acceleration;
+    AnalogInputModifier = ComputeAnalogInputModifier();
+    PerformMovement(DeltaTime);
+    CharacterOwner->ClearJumpInput(DeltaTime);
+}
+
+bool UFPSCharacterMovementComponent::IsSliding() const
+{
+    return MovementMode == MOVE_Custom && CustomMovementMode == CMOVE_Slide;
+}
+
+bool UFPSCharacterMovementComponent::IsWallRunning() const
+{
+    return MovementMode == MOVE_Custom && CustomMovementMode == CMOVE_WallRun;
+}
+
+bool UFPSCharacterMovementComponent::IsMantling() const
+{
+    return MovementMode == MOVE_Custom && CustomMovementMode == CMOVE_Mantle;
+}
+
+void UFPSCharacterMovementComponent::UpdateCharacterStateBeforeMovement(float DeltaSeconds)
+{
+    Super::UpdateCharacterStateBeforeMovement(DeltaSeconds);
+    if (MoveState.bWantsToSlide != LastMoveInput.bWantsToSlide)
+    {
+        RecordTelemetry(MoveState.bWantsToSlide ? FPSMovementTelemetry::EEvent::StartCrouch
+                                                : FPSMovementTelemetry::EEvent::StopCrouch);
+    }
+    // Pending launches are applied after this, so this is everything the move will use
+    LastMoveInput = {Acceleration, PendingLaunchVelocity, MantleTarget, CharacterOwner->bPressedJump,
+                     bWantsToCrouch, MoveState.bWantsToSlide, bWantsToMantle};
+
+    // Slide impulse can be applied again once the player is on the ground without crouching
+    if (MovementMode == MOVE_Walking && !MoveState.bWantsToSlide)
+    {
+        MoveState.bAppliedSlideForce = false;
+    }
+    if (MovementMode == MOVE_Walking && MoveState.bWantsToSlide)
+    {
+        EnterSlide();
+    }
+    else if (IsSliding() && !MoveState.bWantsToSlide)
+    {
+        SetMovementMode(MOVE_Walking);
+    }
+
+    // Climbs a ledge found by last frame's probes
+    if (bWantsToMantle)
+    {
+        StartMantle();
+    }
+
+    // Touches indexed walls as soon as the capsule is within probe distance while moving into them, instead of
+    // waiting for the hit. The index is checked against the collision when it is built, so it needs no sweep.
+    // Walls a little further ahead start tilting the camera, which only players see.
+    bool bNearingWall = false;
+    if (IsFalling() && !MoveState.bIsOnWall)
+    {
+        const float LookAhead = GetNetMode() != NM_DedicatedServer ? Velocity.Size2D() * WallPreAlignTime : 0.f;
+        FVector IndexedNormal;
+        float Distance;
+        if (FindIndexedWall(LookAhead, IndexedNormal, Distance) && (Velocity | IndexedNormal) < 0.f)
+        {
+            if (Distance <= CharacterOwner->GetCapsuleComponent()->GetScaledCapsuleRadius() +
+                                MoveParams->WallProbeDistance)
+            {
+                NotifyWallContact(IndexedNormal);
+            }
+            else
+            {
+                FPSMovementKernel::NearWall(MoveState, ToKernelVector(UpdatedComponent->GetRightVector()),
+                                            ToKernelVector(IndexedNormal));
+                bNearingWall = true;
+            }
+        }
+    }
+    if (MoveState.bNearingWall != bNearingWall)
+    {
+        MoveState.bNearingWall = bNearingWall;
+        if (AFPSCharacter *FPSCharacter = Cast<AFPSCharacter>(CharacterOwner))
+        {
+            FPSCharacter->OnMovementStateChanged();
+        }
+    }
+
+    // Starts wall running on a wall touched while falling that is still there, wall runs check their own contact
+    if (IsFalling() && MoveState.bIsOnWall && UpdateWallContact(DeltaSeconds))
+    {
+        SetMovementMode(MOVE_Custom, CMOVE_WallRun);
+    }
+}
+
+void UFPSCharacterMovementComponent::UpdateCharacterStateAfterMovement(float DeltaSeconds)
+{
+    Super::UpdateCharacterStateAfterMovement(DeltaSeconds);
+    // Wall jump and mantle input last one move, like a jump press
+    bWantsToWallJump = false;
+    bWantsToMantle = false;
+}
+
+void UFPSCharacterMovementComponent::OnMovementModeChanged(EMovementMode PreviousMovementMode,
+                                                           uint8 PreviousCustomMode)
+{
+    Super::OnMovementModeChanged(PreviousMovementMode, PreviousCustomMode);
+    INC_DWORD_STAT(STAT_FPSStateTransitions);
+    FPS_MOVEMENT_DEBUG(2, FColor::Cyan, TEXT("%s movement mode: %s"), *GetNameSafe(CharacterOwner),
+                       *GetMovementName());
+    // Crouching on the ground or in a slide keeps the feet in place, in the air it shrinks around the centre
+    bCrouchMaintainsBaseLocation = IsMovingOnGround();
+
+    if (PreviousMovementMode == MOVE_Custom && PreviousCustomMode == CMOVE_WallRun && !IsWallRunning())
+    {
+        RecordTelemetry(FPSMovementTelemetry::EEvent::StopWallRun);
+    }
+    if (IsWallRunning())
+    {
+        MoveState.Velocity = ToKernelVector(Velocity);
+        FPSMovementKernel::StartWallRun(MoveState, *MoveParams, ToKernelVector(UpdatedComponent->GetRightVector()));
+        Velocity = FromKernelVector(MoveState.Velocity);
+        RecordTelemetry(FPSMovementTelemetry::EEvent::StartWallRun);
+    }
+    else if (IsMovingOnGround())
+    {
+        FPSMovementKernel::Land(MoveState);
+        if (PreviousMovementMode == MOVE_Falling ||
+            (PreviousMovementMode == MOVE_Custom && PreviousCustomMode != CMOVE_Slide))
+        {
+            RecordTelemetry(FPSMovementTelemetry::EEvent::Land);
+        }
+    }
+    else if (IsMantling())
+    {
+        RecordTelemetry(FPSMovementTelemetry::EEvent::StartMantle);
+    }
+
+    if (AFPSCharacter *FPSCharacter = Cast<AFPSCharacter>(CharacterOwner))
+    {
+        FPSCharacter->OnMovementStateChanged();
+    }
+}
+
+void UFPSCharacterMovementComponent::PhysCustom(float DeltaTime, int32 Iterations)
+{
+    Super::PhysCustom(DeltaTime, Iterations);
+
+    switch (CustomMovementMode)
+    {
+    case CMOVE_Slide:
+        PhysSlide(DeltaTime, Iterations);
+        break;
+    case CMOVE_WallRun:
+        PhysWallRun(DeltaTime, Iterations);
+        break;
+    case CMOVE_Mantle:
+        PhysMantle(DeltaTime, Iterations);
+        break;
+    default:
+        SetMovementMode(MOVE_Walking);
+        break;
+    }
+}
+
+bool UFPSCharacterMovementComponent::MoveUpdatedComponentImpl(const FVector &Delta, const FQuat &NewRotation,
+                                                              bool bSweep, FHitResult *OutHit, ETeleportType Teleport)
+{
+    if (bSweep && !Delta.IsZero())
+    {
+        FPSMovementFrameStats::CountPhysicsQuery();
+    }
+    return Super::MoveUpdatedComponentImpl(Delta, NewRotation, bSweep, OutHit, Teleport);
+}
+
+void UFPSCharacterMovementComponent::ComputeFloorDist(const FVector &CapsuleLocation, float LineDistance,
+                                                      float SweepDistance, FFindFloorResult &OutFloorResult,
+                                                      float SweepRadius, const FHitResult *DownwardSweepResult) const
+{
+    FPSMovementFrameStats::CountPhysicsQuery();
+    Super::ComputeFloorDist(CapsuleLocation, LineDistance, SweepDistance, OutFloorResult, SweepRadius,
+                            DownwardSweepResult);
+}
+
+void UFPSCharacterMovementComponent::HandleImpact(const FHitResult &Hit, float TimeSlice, const FVector &MoveDelta)
+{
+    FPS_MOVEMENT_SCOPE(STAT_FPSHitHandling);
+    INC_DWORD_STAT(STAT_FPSHits);
+    Super::HandleImpact(Hit, TimeSlice, MoveDelta);
+    // Blocking hits from our own moves report wall contact, so no capsule hit events are needed
+    if (FPSMovementKernel::IsWall(ToKernelVector(Hit.Normal)))
+    {
+        NotifyWallContact(Hit.Normal);
+        // Walking into a wall might be walking into a ledge
+        bPushingIntoWall |= IsMovingOnGround() && (Acceleration | Hit.Normal) < 0.f;
+    }
+}
+
+bool UFPSCharacterMovementComponent::UpdateWallContact(float DeltaTime)
+{
+    if (!FPSMovementKernel::AgeWallContact(MoveState, *MoveParams, DeltaTime))
+    {
+        return MoveState.bIsOnWall;
+    }
+
+    // No hit refreshed the contact for a while. An indexed wall is still there if the capsule is within probe
+    // distance of it, other walls are swept for a short way into the wall.
+    const FVector WallNormal = FromKernelVector(MoveState.WallNormal);
+    FVector IndexedNormal;
+    float Distance;
+    if (FindIndexedWall(0.f, IndexedNormal, Distance) && (IndexedNormal | WallNormal) >= WallIndexNormalTolerance)
+    {
+        NotifyWallContact(IndexedNormal);
+        return true;
+    }
+    if (SweepForWall(WallNormal))
+    {
+        return true;
+    }
+    FPSMovementKernel::LoseWallContact(MoveState);
+    return false;
+}
+
+bool UFPSCharacterMovementComponent::SweepForWall(const FVector &Normal)
+{
+    FPS_MOVEMENT_SCOPE(STAT_FPSWallContactProbe);
+    INC_DWORD_STAT(STAT_FPSWallProbes);
+    FPSMovementFrameStats::CountPhysicsQuery();
+    const FVector Start = UpdatedComponent->GetComponentLocation();
+    const FVector End = Start - Normal * MoveParams->WallProbeDistance;
+    FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(WallContactProbe), false, CharacterOwner);
+    FCollisionResponseParams ResponseParams;
+    InitCollisionParams(QueryParams, ResponseParams);
+    FHitResult Hit;
+    if (GetWorld()->SweepSingleByChannel(Hit, Start, End, UpdatedComponent->GetComponentQuat(),
+                                         UpdatedComponent->GetCollisionObjectType(),
+                                         GetPawnCapsuleCollisionShape(SHRINK_None), QueryParams, ResponseParams) &&
+        FPSMovementKernel::IsWall(ToKernelVector(Hit.Normal)))
+    {
+        NotifyWallContact(Hit.Normal);
+        return true;
+    }
+    return false;
+}
+
+bool UFPSCharacterMovementComponent::FindIndexedWall(float LookAhead, FVector &OutNormal, float &OutDistance) const
+{
+    if (!WallIndex)
+    {
+        return false;
+    }
+    const UCapsuleComponent *Capsule = CharacterOwner->GetCapsuleComponent();
+    FPSWallIndex::FWallHit Hit;
+    if (!WallIndex->FindWall(UpdatedComponent->GetComponentLocation(),
+                             Capsule->GetScaledCapsuleRadius() + MoveParams->WallProbeDistance + LookAhead,
+                             Capsule->GetScaledCapsuleHalfHeight(), Hit))
+    {
+        return false;
+    }
+    OutNormal = Hit.Normal;
+    OutDistance = Hit.Distance;
+    return true;
+}
+
+void UFPSCharacterMovementComponent::SendLedgeProbes()
+{
+    const bool bPushing = bPushingIntoWall;
+    bPushingIntoWall = false;
+    // Only probes where the moves are made, simulated proxies get climbs through replication and the server
+    // takes the climbs of remote players from their moves
+    if (!HasValidData() || CharacterOwner->GetLocalRole() == ROLE_SimulatedProxy ||
+        (!CharacterOwner->IsLocallyControlled() && CharacterOwner->IsPlayerControlled()) || IsMantling() ||
+        IsWallRunning() || !(IsFalling() || (IsMovingOnGround() && bPushing)))
+    {
+        return;
+    }
+    const FVector Direction = Acceleration.GetSafeNormal2D();
+    if (Direction.IsZero())
+    {
+        return;
+    }
+
+    FPS_MOVEMENT_SCOPE(STAT_FPSLedgeProbes);
+    INC_DWORD_STAT_BY(STAT_FPSLedgeProbeQueries, 3);
+    const UCapsuleComponent *Capsule = CharacterOwner->GetCapsuleComponent();
+    const float Radius = Capsule->GetScaledCapsuleRadius();
+    const float HalfHeight = Capsule->GetScaledCapsuleHalfHeight();
+    const FVector Location = UpdatedComponent->GetComponentLocation();
+    const FVector Feet = Location - FVector(0.f, 0.f, HalfHeight);
+    FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(LedgeProbe), false, CharacterOwner);
+    FCollisionResponseParams ResponseParams;
+    InitCollisionParams(QueryParams, ResponseParams);
+    const ECollisionChannel Channel = UpdatedComponent->GetCollisionObjectType();
+    UWorld *World = GetWorld();
+
+    // Wall in front at the height of the lowest climbable ledge
+    const FVector WallStart = Feet + FVector(0.f, 0.f, MoveParams->MinLedgeHeight);
+    LedgeProbes[LedgeProbeWall] =
+        World->AsyncLineTraceByChannel(EAsyncTraceType::Single, WallStart,
+                                       WallStart + Direction * (Radius + MoveParams->LedgeReachDistance), Channel,
+                                       QueryParams, ResponseParams);
+    // Top of the ledge where the capsule would stand, far enough in that it clears the edge of a wall
+    // anywhere within reach
+    const FVector Column = Feet + Direction * (2.f * Radius + MoveParams->LedgeReachDistance);
+    LedgeProbes[LedgeProbeTop] = World->AsyncLineTraceByChannel(
+        EAsyncTraceType::Single, Column + FVector(0.f, 0.f, MoveParams->MaxMantleHeight + 5.f),
+        Column + FVector(0.f, 0.f, MoveParams->MinLedgeHeight), Channel, QueryParams, ResponseParams);
+    // Room for the capsule on top, it rests where the sweep stops
+    LedgeProbes[LedgeProbeClearance] = World->AsyncSweepByChannel(
+        EAsyncTraceType::Single, Column + FVector(0.f, 0.f, MoveParams->MaxMantleHeight + HalfHeight + 5.f),
+        Column + FVector(0.f, 0.f, MoveParams->MinLedgeHeight + HalfHeight), UpdatedComponent->GetComponentQuat(),
+        Channel, GetPawnCapsuleCollisionShape(SHRINK_None), QueryParams, ResponseParams);
+    LedgeProbeDirection = Direction;
+    bLedgeProbesPending = true;
+}
+
+void UFPSCharacterMovementComponent::ConsumeLedgeProbes()
+{
+    bLedgeProbesPending = false;
+    if (!(IsFalling() || IsMovingOnGround()))
+    {
+        return;
+    }
+    UWorld *World = GetWorld();
+    FTraceDatum WallProbe;
+    FTraceDatum TopProbe;
+    FTraceDatum ClearanceProbe;
+    if (!World->QueryTraceData(LedgeProbes[LedgeProbeWall], WallProbe) ||
+        !World->QueryTraceData(LedgeProbes[LedgeProbeTop], TopProbe) ||
+        !World->QueryTraceData(LedgeProbes[LedgeProbeClearance], ClearanceProbe))
+    {
+        return;
+    }
+    const FHitResult *WallHit = FindBlockingHit(WallProbe);
+    const FHitResult *TopHit = FindBlockingHit(TopProbe);
+    const FHitResult *ClearanceHit = FindBlockingHit(ClearanceProbe);
+    // A wall facing the player with a walkable top that the capsule fits on
+    if (!WallHit || !FPSMovementKernel::IsWall(ToKernelVector(WallHit->Normal)) ||
+        (WallHit->Normal | -LedgeProbeDirection) < LedgeFacingTolerance || !TopHit || !IsWalkable(*TopHit) ||
+        !ClearanceHit || ClearanceHit->bStartPenetrating || !IsWalkable(*ClearanceHit))
+    {
+        return;
+    }
+
+    // The capsule resting on the ledge is as far above the current capsule as the ledge is above the feet
+    const float LedgeHeight = ClearanceHit->Location.Z - UpdatedComponent->GetComponentLocation().Z;
+    if (FPSMovementKernel::ClassifyLedge(LedgeHeight, *MoveParams) != FPSMovementKernel::ELedgeClimb::None)
+    {
+        SetWantsToMantle(true, ClearanceHit->Location + FVector(0.f, 0.f, MIN_FLOOR_DIST));
+    }
+}
+
+void UFPSCharacterMovementComponent::StartMantle()
+{
+    if (!(IsFalling() || IsMovingOnGround()))
+    {
+        return;
+    }
+    const FVector Location = UpdatedComponent->GetComponentLocation();
+    const float Reach = GetLedgeReach();
+    const float LedgeHeight = MantleTarget.Z - MIN_FLOOR_DIST - Location.Z;
+    const FPSMovementKernel::ELedgeClimb Climb = FPSMovementKernel::ClassifyLedge(LedgeHeight, *MoveParams);
+    if (Climb == FPSMovementKernel::ELedgeClimb::None ||
+        FVector::DistSquared2D(Location, MantleTarget) > FMath::Square(Reach))
+    {
+        return;
+    }
+    // Remote players pick their own ledges, the server checks once per climb that one is there
+    if (CharacterOwner->GetLocalRole() == ROLE_Authority && !CharacterOwner->IsLocallyControlled() &&
+        CharacterOwner->IsPlayerControlled() && !IsMantleTargetStandable())
+    {
+        FPS_MOVEMENT_DEBUG(3, FColor::Red, TEXT("%s climb to %s rejected, no ledge there"),
+                           *GetNameSafe(CharacterOwner), *MantleTarget.ToCompactString());
+        GetPredictionData_Server_Character()->bForceClientUpdate = true;
+        return;
+    }
+    MoveState.Velocity = ToKernelVector(Velocity);
+    FPSMovementKernel::StartMantle(MoveState, *MoveParams, ToKernelVector(Location), ToKernelVector(MantleTarget),
+                                   Climb);
+    FPS_MOVEMENT_DEBUG(3, FColor::Yellow, TEXT("%s %s onto a %.0f ledge"), *GetNameSafe(CharacterOwner),
+                       Climb == FPSMovementKernel::ELedgeClimb::Vault ? TEXT("vaults") : TEXT("mantles"),
+                       LedgeHeight);
+    SetMovementMode(MOVE_Custom, CMOVE_Mantle);
+}
+
+float UFPSCharacterMovementComponent::GetLedgeReach() const
+{
+    // The probes look for the ledge one capsule width past the reach distance
+    return 2.f * CharacterOwner->GetCapsuleComponent()->GetScaledCapsuleRadius() + MoveParams->LedgeReachDistance +
+           1.f;
+}
+
+bool UFPSCharacterMovementComponent::IsMantleTargetStandable() const
+{
+    // The clearance probe rests the capsule on the ledge just above it, so a short sweep down from the target
+    // starts clear and lands on the walkable top
+    FPSMovementFrameStats::CountPhysicsQuery();
+    FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(MantleTarget), false, CharacterOwner);
+    FCollisionResponseParams ResponseParams;
+    InitCollisionParams(QueryParams, ResponseParams);
+    const FVector End = MantleTarget - FVector(0.f, 0.f, MIN_FLOOR_DIST + MAX_FLOOR_DIST);
+    FHitResult Hit;
+    return GetWorld()->SweepSingleByChannel(Hit, MantleTarget, End, UpdatedComponent->GetComponentQuat(),
+                                            UpdatedComponent->GetCollisionObjectType(),
+                                            GetPawnCapsuleCollisionShape(SHRINK_None), QueryParams,
+                                            ResponseParams) &&
+           !Hit.bStartPenetrating && IsWalkable(Hit);
+}
+
+void UFPSCharacterMovementComponent::EnterSlide()
+{
+    MoveState.Velocity = ToKernelVector(Velocity);
+    if (FPSMovementKernel::TryApplySlideImpulse(MoveState, *MoveParams))
+    {
+        Velocity = FromKernelVector(MoveState.Velocity);
+        RecordTelemetry(FPSMovementTelemetry::EEvent::SlideImpulse);
+    }
+    SetMovementMode(MOVE_Custom, CMOVE_Slide);
+}
+
+void UFPSCharacterMovementComponent::PhysSlide(float DeltaTime, int32 Iterations)
+{
+    FPS_MOVEMENT_SCOPE(STAT_FPSSlide);
+    if (DeltaTime < MIN_TICK_TIME || !HasValidData())
+    {
+        return;
+    }
+
+    float RemainingTime = DeltaTime;
+    while (RemainingTime >= MIN_TICK_TIME && Iterations < MaxSimulationIterations && HasValidData())
+    {
+        Iterations++;
+        bJustTeleported = false;
+        const float TimeTick = GetSimulationTimeStep(RemainingTime, Iterations);
+        RemainingTime -= TimeTick;
+
+        const FVector OldLocation = UpdatedComponent->GetComponentLocation();
+
+        // TODO - Slide downhill only when player's forward vector is towards slope direction
+        // Makes sliding down slopes faster
+        Velocity += FromKernelVector(FPSMovementKernel::SlopeSlideAcceleration(
+                        ToKernelVector(CurrentFloor.HitResult.Normal), *MoveParams)) *
+                    TimeTick;
+        MaintainHorizontalGroundVelocity();
+        {
+            // Slide friction comes from the tuning values rather than the character's local overrides
+            TGuardValue<float> RestoreBrakingFrictionFactor(BrakingFrictionFactor,
+                                                            MoveParams->SlideBrakingFrictionFactor);
+            CalcVelocity(TimeTick, MoveParams->SlideFriction, false, GetMaxBrakingDeceleration());
+        }
+
+        // Moves along the floor and updates it for the next substep
+        FStepDownResult StepDownResult;
+        MoveAlongFloor(Velocity, TimeTick, &StepDownResult);
+        if (StepDownResult.bComputedFloor)
+        {
+            CurrentFloor = StepDownResult.FloorResult;
+        }
+        else
+        {
+            FindFloor(UpdatedComponent->GetComponentLocation(), CurrentFloor, false);
+        }
+
+        // Slid off a ledge
+        if (!CurrentFloor.IsWalkableFloor())
+        {
+            SetMovementMode(MOVE_Falling);
+            StartNewPhysics(RemainingTime, Iterations);
+            return;
+        }
+        AdjustFloorHeight();
+
+        // Uses the distance actually moved so sliding into walls loses speed
+        if (!bJustTeleported)
+        {
+            Velocity = (UpdatedComponent->GetComponentLocation() - OldLocation) / TimeTick;
+            MaintainHorizontalGroundVelocity();
+        }
+    }
+}
+
+void UFPSCharacterMovementComponent::PhysMantle(float DeltaTime, int32 Iterations)
+{
+    FPS_MOVEMENT_SCOPE(STAT_FPSMantle);
+    if (DeltaTime < MIN_TICK_TIME)
+    {
+        return;
+    }
+    // Sweeps along the climb path and slides around whatever moved into it since the probes
+    const FVector OldLocation = UpdatedComponent->GetComponentLocation();
+    const FVector Delta = FromKernelVector(FPSMovementKernel::StepMantle(MoveState, DeltaTime)) - OldLocation;
+    FHitResult Hit(1.f);
+    SafeMoveUpdatedComponent(Delta, UpdatedComponent->GetComponentQuat(), true, Hit);
+    if (Hit.IsValidBlockingHit())
+    {
+        SlideAlongSurface(Delta, 1.f - Hit.Time, Hit.Normal, Hit, true);
+    }
+    Velocity = (UpdatedComponent->GetComponentLocation() - OldLocation) / DeltaTime;
+    if (FPSMovementKernel::IsMantleFinished(MoveState))
+    {
+        Velocity = FromKernelVector(MoveState.MantleExitVelocity);
+        SetMovementMode(MOVE_Walking);
+    }
+}
+
+void UFPSCharacterMovementComponent::PhysWallRun(float DeltaTime, int32 Iterations)
+{
+    FPS_MOVEMENT_SCOPE(STAT_FPSWallRun);
+    if (DeltaTime < MIN_TICK_TIME || !HasValidData())
+    {
+        return;
+    }
+
+    // Gravity plus the wall stick force and counter gravity
+    const FVector WallRunGravity = GetGravityDirection() * FMath::Abs(GetGravityZ()) +
+                                   FromKernelVector(FPSMovementKernel::WallRunAcceleration(
+                                       MoveState, *MoveParams, ToKernelVector(GetGravityDirection())));
+
+    float RemainingTime = DeltaTime;
+    while (RemainingTime >= MIN_TICK_TIME && Iterations < MaxSimulationIterations && HasValidData())
+    {
+        Iterations++;
+        bJustTeleported = false;
+        const float TimeTick = GetSimulationTimeStep(RemainingTime, Iterations);
+
+        // Falls off as soon as the wall is gone
+        if (!UpdateWallContact(TimeTick))
+        {
+            SetMovementMode(MOVE_Falling);
+            StartNewPhysics(RemainingTime, Iterations);
+            return;
+        }
+        RemainingTime -= TimeTick;
+
+        const FVector OldLocation = UpdatedComponent->GetComponentLocation();
+        const FVector OldVelocity = Velocity;
+
+        // Applies input on the horizontal plane like falling does
+        {
+            TGuardValue<FVector> RestoreAcceleration(Acceleration, GetFallingLateralAcceleration(TimeTick));
+            Velocity.Z = 0.f;
+            CalcVelocity(TimeTick, FallingLateralFriction, false, GetMaxBrakingDeceleration());
+            Velocity.Z = OldVelocity.Z;
+        }
+        Velocity = NewFallVelocity(Velocity, WallRunGravity, TimeTick);
+
+        const FVector Adjusted = 0.5f * (OldVelocity + Velocity) * TimeTick;
+        FHitResult Hit(1.f);
+        SafeMoveUpdatedComponent(Adjusted, UpdatedComponent->GetComponentQuat(), true, Hit);
+        if (!HasValidData())
+        {
+            return;
+        }
+        if (Hit.bBlockingHit)
+        {
+            // Ran down onto the floor
+            if (IsValidLandingSpot(UpdatedComponent->GetComponentLocation(), Hit))
+            {
+                RemainingTime += TimeTick * (1.f - Hit.Time);
+                ProcessLanded(Hit, RemainingTime, Iterations);
+                return;
+            }
+            HandleImpact(Hit, TimeTick, Adjusted);
+            SlideAlongSurface(Adjusted, 1.f - Hit.Time, Hit.Normal, Hit, true);
+            if (!bJustTeleported)
+            {
+                Velocity = (UpdatedComponent->GetComponentLocation() - OldLocation) / TimeTick;
+            }
+        }
+    }
+}
+
+// Pushes a state transition to the telemetry ring when recording
+void UFPSCharacterMovementComponent::RecordTelemetry(FPSMovementTelemetry::EEvent Event)
+{
+    if (!Telemetry || bClientUpdating || bResimulating)
+    {
+        return;
+    }
+    const FVector FloorNormal =
+        CurrentFloor.IsWalkableFloor() ? CurrentFloor.HitResult.ImpactNormal : FVector::ZeroVector;
+    FPSMovementTelemetry::FRecord Record;
+    Record.Time = GetWorld()->GetTimeSeconds();
+    Record.CharacterId = Telemetry->CharacterId;
+    Record.Event = Event;
+    Record.MovementMode = MovementMode;
+    Record.CustomMovementMode = CustomMovementMode;
+    Record.Padding = 0;
+    Record.Velocity[0] = float(Velocity.X);
+    Record.Velocity[1] = float(Velocity.Y);
+    Record.Velocity[2] = float(Velocity.Z);
+    Record.FloorNormal[0] = float(FloorNormal.X);
+    Record.FloorNormal[1] = float(FloorNormal.Y);
+    Record.FloorNormal[2] = float(FloorNormal.Z);
+    if (Telemetry->Ring.Push(Record))
+    {
+        INC_DWORD_STAT(STAT_FPSTelemetryRecords);
+    }
+    else
+    {
+        Telemetry->NumDropped.fetch_add(1, std::memory_order_relaxed);
+    }
+}
@@ -0,0 +1,309 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "FPSMovementKernel.h"
+#include "FPSMovementSnapshot.h"
+#include "FPSMovementTelemetry.h"
+#include "FPSMovementTrajectory.h"
+#include "Math/MathFwd.h"
+#include "WorldCollision.h"
+#include "FPSCharacterMovementComponent.generated.h"
+
+// Converts between engine vectors and movement kernel vectors
+inline FPSMovementKernel::FVec3 ToKernelVector(const FVector &Vector)
+{
+    return {float(Vector.X), float(Vector.Y), float(Vector.Z)};
+}
+inline FVector FromKernelVector(const FPSMovementKernel::FVec3 &Vector)
+{
+    return FVector(Vector.X, Vector.Y, Vector.Z);
+}
+
+// Custom movement modes used by the FPS character
+UENUM(BlueprintType)
+enum EFPSCustomMovementMode : uint8
+{
+    CMOVE_None UMETA(Hidden),
+    CMOVE_Slide UMETA(DisplayName = "Slide"),
+    CMOVE_WallRun UMETA(DisplayName = "Wall Run"),
+    CMOVE_Mantle UMETA(DisplayName = "Mantle"),
+    CMOVE_MAX UMETA(Hidden),
+};
+
+class UFPSWallIndexSubsystem;
+
+// Saved move with the slide input, wall contact and ledge climbs, replayed by the owning client after corrections
+class FSavedMove_FPS : public FSavedMove_Character
+{
+public:
+    typedef FSavedMove_Character Super;
+
+    // Slide input
+    static constexpr uint8 FLAG_WantsToSlide = FLAG_Custom_0;
+    // The client touched a wall during this move, its normal is sent with the move data
+    static constexpr uint8 FLAG_WallContact = FLAG_Custom_1;
+    // Jump input that pushes off the wall when the move starts in a wall run
+    static constexpr uint8 FLAG_WantsToWallJump = FLAG_Custom_2;
+    // The move starts climbing the ledge the client's probes found, its target is sent with the move data
+    static constexpr uint8 FLAG_WantsToMantle = FLAG_Custom_3;
+
+    virtual void Clear() override;
+    virtual uint8 GetCompressedFlags() const override;
+    virtual bool CanCombineWith(const FSavedMovePtr &NewMove, ACharacter *InCharacter, float MaxDelta) const override;
+    virtual void SetMoveFor(ACharacter *C, float InDeltaTime, FVector const &NewAccel,
+                            FNetworkPredictionData_Client_Character &ClientData) override;
+    virtual void PrepMoveFor(ACharacter *C) override;
+
+    bool bSavedWantsToSlide = false;
+    bool bSavedWantsToWallJump = false;
+    bool bSavedWallContact = false;
+    bool bSavedWantsToMantle = false;
+    // Wall normal packed with FPSMovementKernel::PackWallNormal
+    uint32 SavedWallNormal = 0;
+    FVector SavedMantleTarget = FVector::ZeroVector;
+};
+
+class FNetworkPredictionData_Client_FPS : public FNetworkPredictionData_Client_Character
+{
+public:
+    typedef FNetworkPredictionData_Client_Character Super;
+
+    explicit FNetworkPredictionData_Client_FPS(const UCharacterMovementComponent &ClientMovement);
+
+    virtual FSavedMovePtr AllocateNewMove() override;
+};
+
+// Move data sent to the server, adds the packed wall normal when the client reports wall contact and the ledge
+// target when the move starts a climb
+struct FFPSNetworkMoveData : public FCharacterNetworkMoveData
+{
+    typedef FCharacterNetworkMoveData Super;
+
+    virtual void ClientFillNetworkMoveData(const FSavedMove_Character &ClientMove, ENetworkMoveType MoveType) override;
+    virtual bool Serialize(UCharacterMovementComponent &CharacterMovement, FArchive &Ar, UPackageMap *PackageMap,
+                           ENetworkMoveType MoveType) override;
+
+    uint32 WallNormal = 0;
+    FVector_NetQuantize10 MantleTarget = FVector::ZeroVector;
+};
+
+struct FFPSNetworkMoveDataContainer : public FCharacterNetworkMoveDataContainer
+{
+    FFPSNetworkMoveDataContainer();
+
+    FFPSNetworkMoveData FPSMoveData[3];
+};
+
+/**
+ * Character movement with slide and wall run modes. All velocity changes for these
+ * abilities happen inside the movement update so they are substepped like walking and falling.
+ * The slide input, wall contact, wall jumps and ledge climbs travel with each saved move so clients predict them
+ * without corrections.
+ */
+UCLASS()
+class MOVEMENT_REMAKE_API UFPSCharacterMovementComponent : public UCharacterMovementComponent
+{
+    GENERATED_BODY()
+
+public:
+    // Sets default values for this component's properties
+    UFPSCharacterMovementComponent();
+
+    virtual void BeginPlay() override;
+    virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+    virtual void TickComponent(float DeltaTime, enum ELevelTick TickType,
+                               FActorComponentTickFunction *ThisTickFunction) override;
+
+    virtual void OnTeleported() override;
+    virtual float GetMaxSpeed() const override;
+    virtual float GetMaxBrakingDeceleration() const override;
+    virtual bool IsMovingOnGround() const override;
+    virtual bool CanCrouchInCurrentState() const override;
+    virtual bool CanAttemptJump() const override;
+    virtual bool DoJump(bool bReplayingMoves) override;
+    virtual FNetworkPredictionData_Client *GetPredictionData_Client() const override;
+
+    // Points the slide and wall run modes at shared tuning values, which must outlive this component
+    void SetMovementParams(const FPSMovementKernel::FMovementParams &InParams);
+    const FPSMovementKernel::FMovementParams &GetMovementParams() const
+    {
+        return *MoveParams;
+    }
+    const FPSMovementKernel::FMovementState &GetMovementState() const
+    {
+        return MoveState;
+    }
+
+    // Sets whether the player is holding crouch and wants to slide when on the ground
+    void SetWantsToSlide(bool bInWantsToSlide);
+    bool WantsToSlide() const
+    {
+        return MoveState.bWantsToSlide;
+    }
+    // Sets whether the next move jumps off the wall when it starts in a wall run, cleared after every move
+    void SetWantsToWallJump(bool bInWantsToWallJump)
+    {
+        bWantsToWallJump = bInWantsToWallJump;
+    }
+    bool WantsToWallJump() const
+    {
+        return bWantsToWallJump;
+    }
+    // Sets the ledge the next move climbs onto, cleared after every move
+    void SetWantsToMantle(bool bInWantsToMantle, const FVector &Target)
+    {
+        bWantsToMantle = bInWantsToMantle;
+        MantleTarget = Target;
+    }
+    bool WantsToMantle() const
+    {
+        return bWantsToMantle;
+    }
+    const FVector &GetMantleTarget() const
+    {
+        return MantleTarget;
+    }
+    // Called when the character touches a surface that counts as a wall
+    void NotifyWallContact(const FVector &Normal);
+
+    // Copies the movement state and the input of the last move into a rollback snapshot
+    void SaveMovementSnapshot(FFPSMovementSnapshot &Snapshot) const;
+    // Puts the movement state back without running mode change events
+    void RestoreMovementSnapshot(const FFPSMovementSnapshot &Snapshot);
+    // Runs one move with recorded input the same way a locally controlled tick would
+    void ResimulateMove(const FFPSMovementInput &Input, float DeltaTime);
+    // Moves this machine has run from its own tick, the character saves a rollback snapshot under each
+    int32 GetMovementFrame() const
+    {
+        return MovementFrame;
+    }
+
+    // Hands over the client reported movement gathered since the last call, returns false when there was none
+    bool ConsumeMoveSample(FPSMovementKernel::FMoveSample &OutSample);
+
+    // Simulated proxies move along their replicated velocity without sweeping, and without mesh smoothing
+    void SetSimpleExtrapolation(bool bEnable);
+
+    // Seconds of one fixed movement step, zero when movement steps with the frame
+    float GetFixedStepTime() const;
+
+    // Arc the character follows from now on if nothing gets in the way: its walk, slide, wall run or fall, or
+    // the end of its climb
+    FPSMovementTrajectory::FArc PredictArc() const;
+    // Arc of a wall jump made now, returns false when not wall running
+    bool PredictWallJumpArc(FPSMovementTrajectory::FArc &OutArc) const;
+
+    // True when in the slide movement mode
+    bool IsSliding() const;
+    // True when in the wall run movement mode
+    bool IsWallRunning() const;
+    // True while vaulting or mantling onto a ledge
+    bool IsMantling() const;
+    // Sign of the dot product between the wall normal and the character's right vector
+    float GetWallRunTiltDirection() const
+    {
+        return MoveState.WallRunTiltDirection;
+    }
+
+protected:
+    virtual void UpdateFromCompressedFlags(uint8 Flags) override;
+    virtual void ServerMove_PerformMovement(const FCharacterNetworkMoveData &MoveData) override;
+    virtual void SimulateMovement(float DeltaTime) override;
+    virtual void UpdateCharacterStateBeforeMovement(float DeltaSeconds) override;
+    virtual void UpdateCharacterStateAfterMovement(float DeltaSeconds) override;
+    virtual void OnMovementModeChanged(EMovementMode PreviousMovementMode, uint8 PreviousCustomMode) override;
+    virtual void PhysCustom(float DeltaTime, int32 Iterations) override;
+    virtual bool MoveUpdatedComponentImpl(const FVector &Delta, const FQuat &NewRotation, bool bSweep,
+                                          FHitResult *OutHit = nullptr,
+                                          ETeleportType Teleport = ETeleportType::None) override;
+    virtual void ComputeFloorDist(const FVector &CapsuleLocation, float LineDistance, float SweepDistance,
+                                  FFindFloorResult &OutFloorResult, float SweepRadius,
+                                  const FHitResult *DownwardSweepResult = nullptr) const override;
+    virtual void HandleImpact(const FHitResult &Hit, float TimeSlice = 0.f,
+                              const FVector &MoveDelta = FVector::ZeroVector) override;
+
+private:
+    // Substepped ground movement with slide friction and downhill acceleration
+    void PhysSlide(float DeltaTime, int32 Iterations);
+    // Substepped air movement that sticks to the wall and counters gravity
+    void PhysWallRun(float DeltaTime, int32 Iterations);
+    // Launches the character off the wall from inside the move, returns false when not wall running
+    bool WallJump();
+    // Enters the slide mode and applies the slide impulse if needed
+    void EnterSlide();
+    // Ages the wall contact and confirms it with the wall index or a sweep once it is stale, returns false when
+    // the wall is gone
+    bool UpdateWallContact(float DeltaTime);
+    // Sweeps the capsule a short way against the normal and touches the wall it hits, returns false when none
+    bool SweepForWall(const FVector &Normal);
+    // Looks up the closest wall within probe distance plus LookAhead of the capsule in the level's wall index,
+    // and the distance from the capsule center to it
+    bool FindIndexedWall(float LookAhead, FVector &OutNormal, float &OutDistance) const;
+    // Moves the capsule along the ledge climb path
+    void PhysMantle(float DeltaTime, int32 Iterations);
+    // Queues the ledge probes for this frame when airborne or pushing into geometry
+    void SendLedgeProbes();
+    // Reads last frame's ledge probes and sets the mantle input of the next move when they found a ledge
+    void ConsumeLedgeProbes();
+    // Starts the vault or mantle the move's input asks for when the ledge is within reach of the capsule
+    void StartMantle();
+    // Farthest a ledge climb may start from its target, horizontally
+    float GetLedgeReach() const;
+    // True when the capsule fits at the mantle target standing on a walkable floor, one sweep
+    bool IsMantleTargetStandable() const;
+    // Counts a move run from this machine's tick and has the character save a rollback snapshot of it
+    void SaveFrameSnapshot();
+    // Forgets the previous fixed step so the capsule is drawn where it is
+    void ResetPresentation();
+    // Hands the presentation offset to the character, which draws its mesh and camera there
+    void ApplyPresentation();
+    // Pushes a state transition to the telemetry ring when recording, replayed moves are not recorded
+    void RecordTelemetry(FPSMovementTelemetry::EEvent Event);
+
+    // Tuning values shared with every character using the same movement tuning, read in place
+    static const FPSMovementKernel::FMovementParams DefaultMoveParams;
+    const FPSMovementKernel::FMovementParams *MoveParams = &DefaultMoveParams;
+    // Slide and wall run state
+    FPSMovementKernel::FMovementState MoveState = {};
+    // Input of the last move, saved with snapshots
+    FFPSMovementInput LastMoveInput = {};
+    // Client reported movement since the validator last consumed it, server only
+    FPSMovementKernel::FMoveSample PendingMoveSample = {};
+    // Last accepted client location and timestamp, the baseline for the next reported move
+    FVector LastReportedLocation = FVector::ZeroVector;
+    float LastReportedTimeStamp = 0.f;
+    bool bHasReportedLocation = false;
+    // Wall runnable surfaces of the level, touched and confirmed without sweeping
+    UPROPERTY(Transient)
+    UFPSWallIndexSubsystem *WallIndex = nullptr;
+    // Async ledge probes sent last frame: the forward wall trace, the top surface trace and the clearance sweep
+    FTraceHandle LedgeProbes[3];
+    // Horizontal direction the ledge probes looked in
+    FVector LedgeProbeDirection = FVector::ZeroVector;
+    bool bLedgeProbesPending = false;
+    // Set when a move on the ground was blocked by a wall the player is pushing into
+    bool bPushingIntoWall = false;
+    // Set by the movement LOD for distant simulated proxies
+    bool bSimpleExtrapolation = false;
+    ENetworkSmoothingMode SmoothingModeBeforeExtrapolation = ENetworkSmoothingMode::Exponential;
+    // Frame time not yet stepped in fixed step mode, and where the capsule was before the last step
+    float FixedStepRemainder = 0.f;
+    FVector PreviousStepLocation = FVector::ZeroVector;
+    FVector PresentationOffset = FVector::ZeroVector;
+    // Telemetry ring drained by the telemetry writer, null when telemetry is off
+    TSharedPtr<FPSMovementTelemetry::FChannel, ESPMode::ThreadSafe> Telemetry;
+    // Set while a rollback replays moves
+    bool bResimulating = false;
+    // Last frame a rollback snapshot was saved under
+    int32 MovementFrame = 0;
+    // Wall jump input of the current move
+    bool bWantsToWallJump = false;
+    // Mantle input of the current move, from our own ledge probes or the client's move
+    bool bWantsToMantle = false;
+    FVector MantleTarget = FVector::ZeroVector;
+    // Move data with the packed wall normal
+    FFPSNetworkMoveDataContainer FPSMoveDataContainer;
+};
@@ -1,5 +1,21 @@
 // Fill out your copyright notice in the Description page of Project Settings.
 
-
 #include "FPSGameModeBase.h"
+#include "FPSMovementLoadTest.h"
+#include "Engine/World.h"
+#include "Kismet/GameplayStatics.h"
 
+void AFPSGameModeBase::StartPlay()
+{
+    Super::StartPlay();
+    // Starts the bot load test when the map was opened with the load test options
+    const int32 LoadTestBots = UGameplayStatics::GetIntOption(OptionsString, TEXT("LoadTest"), 0);
+    if (LoadTestBots > 0)
+    {
+        if (UFPSMovementLoadTest *LoadTest = GetWorld()->GetSubsystem<UFPSMovementLoadTest>())
+        {
+            const FString StepSeconds = UGameplayStatics::ParseOption(OptionsString, TEXT("LoadTestStepSeconds"));
+            LoadTest->StartLoadTest(LoadTestBots, StepSeconds.IsEmpty() ? 20.f : FCString::Atof(*StepSeconds));
+        }
+    }
+}
@@ -7,11 +7,14 @@
 #include "FPSGameModeBase.generated.h"
 
 /**
- * 
+ * Game mode of the movement maps. Opening a map with ?LoadTest=<MaxBots> starts the movement load test once
+ * play begins, ?LoadTestStepSeconds=<Seconds> sets how long each bot count is measured.
  */
 UCLASS()
 class MOVEMENT_REMAKE_API AFPSGameModeBase : public AGameModeBase
 {
-	GENERATED_BODY()
-	
+    GENERATED_BODY()
+
+public:
+    virtual void StartPlay() override;
 };
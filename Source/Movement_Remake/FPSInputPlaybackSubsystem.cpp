@@ -0,0 +1,238 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "FPSInputPlaybackSubsystem.h"
+#include "FPSCharacter.h"
+#include "FPSMovementStats.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/App.h"
+#include "Misc/CommandLine.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Parse.h"
+#include "Misc/Paths.h"
+
+namespace
+{
+    // Playback time between trajectory samples
+    constexpr double TrajectorySampleInterval = .1;
+
+    FAutoConsoleCommandWithWorldAndArgs GInputPlayCommand(
+        TEXT("fps.Input.Play"),
+        TEXT("Replays an input recording into the player's character. Args: <File> [Lockstep|Uncapped] [StepRate=60]"),
+        FConsoleCommandWithWorldAndArgsDelegate::CreateLambda(
+            [](const TArray<FString> &Args, UWorld *World)
+            {
+                UFPSInputPlaybackSubsystem *Playback =
+                    World ? World->GetSubsystem<UFPSInputPlaybackSubsystem>() : nullptr;
+                if (!Playback || Args.IsEmpty())
+                {
+                    UE_LOG(LogFPSMovement, Error, TEXT("Usage: fps.Input.Play <File> [Lockstep|Uncapped] [StepRate]"));
+                    return;
+                }
+                const EFPSInputPlaybackMode Mode = Args.Num() > 1 && Args[1] == TEXT("Uncapped")
+                                                       ? EFPSInputPlaybackMode::Uncapped
+                                                       : EFPSInputPlaybackMode::Lockstep;
+                const float StepRate = Args.Num() > 2 ? FCString::Atof(*Args[2]) : 60.f;
+                const FString Path =
+                    FPaths::IsRelative(Args[0]) ? FPaths::Combine(FPaths::ProjectDir(), Args[0]) : Args[0];
+                if (!Playback->StartPlayback(Path, Mode, FMath::Max(StepRate, 1.f)) &&
+                    FParse::Param(FCommandLine::Get(), TEXT("InputPlaybackExit")))
+                {
+                    FPlatformMisc::RequestExitWithStatus(false, 1);
+                }
+            }));
+
+    FAutoConsoleCommandWithWorld GInputStopCommand(
+        TEXT("fps.Input.Stop"), TEXT("Stops input playback"),
+        FConsoleCommandWithWorldDelegate::CreateLambda(
+            [](UWorld *World)
+            {
+                if (UFPSInputPlaybackSubsystem *Playback =
+                        World ? World->GetSubsystem<UFPSInputPlaybackSubsystem>() : nullptr)
+                {
+                    Playback->StopPlayback();
+                }
+            }));
+} // namespace
+
+void UFPSInputPlaybackSubsystem::Tick(float DeltaTime)
+{
+    Super::Tick(DeltaTime);
+    if (!Reader)
+    {
+        return;
+    }
+    if (!IsValid(Character))
+    {
+        UE_LOG(LogFPSMovement, Warning, TEXT("Input playback character was destroyed"));
+        StopPlayback();
+        return;
+    }
+
+    // Feeds every record up to the current playback time, movement then runs with it this frame
+    PlaybackTime += DeltaTime;
+    NumFrames++;
+    const double PlaybackTimeMs = PlaybackTime * 1000.0;
+    while (NextRecord < Reader->Num() && (*Reader)[NextRecord].TimeMs <= PlaybackTimeMs)
+    {
+        Dispatch((*Reader)[NextRecord]);
+        NextRecord++;
+    }
+    if (!HeldWalkInput.IsZero())
+    {
+        Character->WalkInput(HeldWalkInput);
+    }
+
+    if (PlaybackTime >= NextTrajectorySampleTime)
+    {
+        const FVector Location = Character->GetActorLocation();
+        const FVector Velocity = Character->GetVelocity();
+        TrajectoryCsv += FString::Printf(TEXT("%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%d\n"), PlaybackTime, Location.X,
+                                         Location.Y, Location.Z, Velocity.X, Velocity.Y, Velocity.Z,
+                                         int32(Character->GetCharacterMovement()->MovementMode));
+        NextTrajectorySampleTime += TrajectorySampleInterval;
+    }
+
+    if (NextRecord >= Reader->Num())
+    {
+        StopPlayback();
+    }
+}
+
+TStatId UFPSInputPlaybackSubsystem::GetStatId() const
+{
+    RETURN_QUICK_DECLARE_CYCLE_STAT(UFPSInputPlaybackSubsystem, STATGROUP_Tickables);
+}
+
+void UFPSInputPlaybackSubsystem::Deinitialize()
+{
+    StopPlayback();
+    Super::Deinitialize();
+}
+
+bool UFPSInputPlaybackSubsystem::StartPlayback(const FString &Path, EFPSInputPlaybackMode Mode, float StepRate)
+{
+    StopPlayback();
+    APlayerController *PlayerController = GetWorld()->GetFirstPlayerController();
+    Character = PlayerController ? Cast<AFPSCharacter>(PlayerController->GetPawn()) : nullptr;
+    if (!Character)
+    {
+        UE_LOG(LogFPSMovement, Error, TEXT("Input playback needs a player controlled FPS character"));
+        return false;
+    }
+    Reader = MakeUnique<FPSInputRecording::FReader>(Path);
+    if (!Reader->IsValid())
+    {
+        Reader.Reset();
+        return false;
+    }
+
+    PlaybackPath = Path;
+    PlaybackMode = Mode;
+    NextRecord = 0;
+    HeldWalkInput = FVector2D::ZeroVector;
+    PlaybackTime = 0.0;
+    NumFrames = 0;
+    RealStartTime = FPlatformTime::Seconds();
+    TrajectoryCsv = TEXT("Time,X,Y,Z,VelocityX,VelocityY,VelocityZ,MovementMode\n");
+    NextTrajectorySampleTime = 0.0;
+
+    if (Mode == EFPSInputPlaybackMode::Lockstep)
+    {
+        // Benchmarking skips the wait for real time, every frame advances by exactly one step
+        bSavedUseFixedTimeStep = FApp::UseFixedTimeStep();
+        SavedFixedDeltaTime = FApp::GetFixedDeltaTime();
+        bSavedBenchmarking = FApp::IsBenchmarking();
+        bChangedTimestep = true;
+        FApp::SetUseFixedTimeStep(true);
+        FApp::SetFixedDeltaTime(1.0 / StepRate);
+        FApp::SetBenchmarking(true);
+    }
+    else if (GEngine)
+    {
+        bSavedUseFixedFrameRate = GEngine->bUseFixedFrameRate;
+        bSavedSmoothFrameRate = GEngine->bSmoothFrameRate;
+        SavedMaxFPS = GEngine->GetMaxFPS();
+        bChangedFrameRate = true;
+        GEngine->bUseFixedFrameRate = false;
+        GEngine->bSmoothFrameRate = false;
+        GEngine->SetMaxFPS(0.f);
+    }
+    UE_LOG(LogFPSMovement, Display, TEXT("Replaying %d input records from %s"), Reader->Num(), *Path);
+    return true;
+}
+
+void UFPSInputPlaybackSubsystem::StopPlayback()
+{
+    if (!Reader)
+    {
+        return;
+    }
+    RestoreTimestep();
+    const bool bFinished = NextRecord >= Reader->Num();
+    const double RealSeconds = FPlatformTime::Seconds() - RealStartTime;
+    Reader.Reset();
+    Character = nullptr;
+
+    const FString CsvPath = FPaths::ProjectSavedDir() / TEXT("Profiling") / TEXT("InputPlayback") /
+                            FPaths::GetBaseFilename(PlaybackPath) + TEXT("-Trajectory.csv");
+    FFileHelper::SaveStringToFile(TrajectoryCsv, *CsvPath);
+    TrajectoryCsv.Empty();
+    UE_LOG(LogFPSMovement, Display,
+           TEXT("Input playback %s: %.1f s of input in %.1f s over %d frames (%.1fx real time), trajectory in %s"),
+           bFinished ? TEXT("finished") : TEXT("stopped"), PlaybackTime, RealSeconds, NumFrames,
+           RealSeconds > 0.0 ? PlaybackTime / RealSeconds : 0.0, *CsvPath);
+
+    if (FParse::Param(FCommandLine::Get(), TEXT("InputPlaybackExit")))
+    {
+        FPlatformMisc::RequestExitWithStatus(false, bFinished ? 0 : 1);
+    }
+}
+
+void UFPSInputPlaybackSubsystem::Dispatch(const FPSInputRecording::FRecord &Record)
+{
+    using namespace FPSInputRecording;
+    switch (Record.Action)
+    {
+    case EAction::Walk:
+        HeldWalkInput = FVector2D(DequantizeAxis(Record.X, WalkAxisScale), DequantizeAxis(Record.Y, WalkAxisScale));
+        break;
+    case EAction::Look:
+        Character->LookInput(
+            FVector2D(DequantizeAxis(Record.X, LookAxisScale), DequantizeAxis(Record.Y, LookAxisScale)));
+        break;
+    case EAction::CrouchStart:
+        Character->SetCrouchInput(true);
+        break;
+    case EAction::CrouchStop:
+        Character->SetCrouchInput(false);
+        break;
+    case EAction::Jump:
+        Character->JumpInput();
+        break;
+    }
+}
+
+void UFPSInputPlaybackSubsystem::RestoreTimestep()
+{
+    if (bChangedTimestep)
+    {
+        FApp::SetUseFixedTimeStep(bSavedUseFixedTimeStep);
+        FApp::SetFixedDeltaTime(SavedFixedDeltaTime);
+        FApp::SetBenchmarking(bSavedBenchmarking);
+        bChangedTimestep = false;
+    }
+    if (bChangedFrameRate)
+    {
+        if (GEngine)
+        {
+            GEngine->bUseFixedFrameRate = bSavedUseFixedFrameRate;
+            GEngine->bSmoothFrameRate = bSavedSmoothFrameRate;
+            GEngine->SetMaxFPS(SavedMaxFPS);
+        }
+        bChangedFrameRate = false;
+    }
+}
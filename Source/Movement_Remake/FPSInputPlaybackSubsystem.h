@@ -0,0 +1,79 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "FPSInputRecording.h"
+#include "FPSInputPlaybackSubsystem.generated.h"
+
+class AFPSCharacter;
+
+// How playback time advances
+UENUM()
+enum class EFPSInputPlaybackMode : uint8
+{
+    // Fixed timestep without waiting for real time, runs as fast as the machine allows and repeats exactly
+    Lockstep,
+    // Variable timestep with the frame rate cap removed
+    Uncapped,
+};
+
+/**
+ * Replays a recorded input file into the player's character. The file is memory mapped and records are
+ * fed to the same input handlers the action bindings use. The trajectory is written to CSV so runs of
+ * different builds can be compared.
+ *
+ * Replay a session headless, faster than real time:
+ *   UnrealEditor-Cmd Movement_Remake.uproject /Game/TestMap -game -nullrhi -unattended -InputPlaybackExit
+ *       -ExecCmds="fps.Input.Play Saved/InputRecordings/Session.fpsinput Lockstep 60"
+ */
+UCLASS()
+class MOVEMENT_REMAKE_API UFPSInputPlaybackSubsystem : public UTickableWorldSubsystem
+{
+    GENERATED_BODY()
+
+public:
+    virtual void Tick(float DeltaTime) override;
+    virtual TStatId GetStatId() const override;
+    virtual void Deinitialize() override;
+
+    // Starts replaying the file into the player's character, returns false if it could not be started
+    bool StartPlayback(const FString &Path, EFPSInputPlaybackMode Mode, float StepRate);
+    void StopPlayback();
+    bool IsPlaying() const
+    {
+        return Reader.IsValid();
+    }
+
+private:
+    // Feeds one record to the character
+    void Dispatch(const FPSInputRecording::FRecord &Record);
+    // Restores the engine timestep and frame rate settings changed for playback
+    void RestoreTimestep();
+
+    UPROPERTY(Transient)
+    AFPSCharacter *Character = nullptr;
+    TUniquePtr<FPSInputRecording::FReader> Reader;
+    FString PlaybackPath;
+    EFPSInputPlaybackMode PlaybackMode = EFPSInputPlaybackMode::Lockstep;
+    int32 NextRecord = 0;
+    // Walk input of the last walk record, applied every frame like held input
+    FVector2D HeldWalkInput = FVector2D::ZeroVector;
+    double PlaybackTime = 0.0;
+    double RealStartTime = 0.0;
+    int32 NumFrames = 0;
+    // Trajectory samples, one row of CSV each
+    FString TrajectoryCsv;
+    double NextTrajectorySampleTime = 0.0;
+    // Engine timestep settings before lockstep playback
+    bool bSavedUseFixedTimeStep = false;
+    double SavedFixedDeltaTime = 0.0;
+    bool bSavedBenchmarking = false;
+    bool bChangedTimestep = false;
+    // Engine frame rate settings before uncapped playback
+    bool bSavedUseFixedFrameRate = false;
+    bool bSavedSmoothFrameRate = false;
+    float SavedMaxFPS = 0.f;
+    bool bChangedFrameRate = false;
+};
@@ -0,0 +1,100 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "FPSInputRecording.h"
+#include "FPSMovementStats.h"
+#include "HAL/PlatformFileManager.h"
+#include "Misc/Paths.h"
+
+namespace FPSInputRecording
+{
+    namespace
+    {
+        // Records buffered before they are written out
+        constexpr int32 FlushThreshold = 4096;
+    } // namespace
+
+    FRecorder::FRecorder(const FString &Path)
+    {
+        IPlatformFile &PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+        PlatformFile.CreateDirectoryTree(*FPaths::GetPath(Path));
+        FileHandle.Reset(PlatformFile.OpenWrite(*Path, false));
+        if (!FileHandle)
+        {
+            UE_LOG(LogFPSMovement, Error, TEXT("Could not open input recording %s"), *Path);
+            return;
+        }
+        const FHeader Header = {Magic, Version, uint16(sizeof(FRecord))};
+        FileHandle->Write(reinterpret_cast<const uint8 *>(&Header), sizeof(Header));
+        Pending.Reserve(FlushThreshold);
+        UE_LOG(LogFPSMovement, Display, TEXT("Recording input to %s"), *Path);
+    }
+
+    FRecorder::~FRecorder()
+    {
+        Flush();
+    }
+
+    void FRecorder::Record(double TimeSeconds, EAction Action, const FVector2D &Value)
+    {
+        if (!FileHandle)
+        {
+            return;
+        }
+        if (StartTime < 0.0)
+        {
+            StartTime = TimeSeconds;
+        }
+        const float Scale = Action == EAction::Look ? LookAxisScale : WalkAxisScale;
+        FRecord &Record = Pending.AddZeroed_GetRef();
+        Record.TimeMs = uint32(FMath::RoundToInt64((TimeSeconds - StartTime) * 1000.0));
+        Record.X = QuantizeAxis(Value.X, Scale);
+        Record.Y = QuantizeAxis(Value.Y, Scale);
+        Record.Action = Action;
+        if (Pending.Num() >= FlushThreshold)
+        {
+            Flush();
+        }
+    }
+
+    void FRecorder::Flush()
+    {
+        if (FileHandle && !Pending.IsEmpty())
+        {
+            FileHandle->Write(reinterpret_cast<const uint8 *>(Pending.GetData()), Pending.Num() * sizeof(FRecord));
+            FileHandle->Flush();
+        }
+        Pending.Reset();
+    }
+
+    FReader::FReader(const FString &Path)
+    {
+        MappedFile.Reset(FPlatformFileManager::Get().GetPlatformFile().OpenMapped(*Path));
+        if (!MappedFile || MappedFile->GetFileSize() < int64(sizeof(FHeader)))
+        {
+            UE_LOG(LogFPSMovement, Error, TEXT("Could not map input recording %s"), *Path);
+            return;
+        }
+        MappedRegion.Reset(MappedFile->MapRegion(0, MappedFile->GetFileSize()));
+        if (!MappedRegion)
+        {
+            UE_LOG(LogFPSMovement, Error, TEXT("Could not map input recording %s"), *Path);
+            return;
+        }
+        const FHeader *Header = reinterpret_cast<const FHeader *>(MappedRegion->GetMappedPtr());
+        if (Header->Magic != Magic || Header->Version != Version || Header->RecordSize != sizeof(FRecord))
+        {
+            UE_LOG(LogFPSMovement, Error, TEXT("%s is not a version %d input recording"), *Path, Version);
+            return;
+        }
+        // A partly written last record from a crashed session is ignored
+        NumRecords = int32((MappedRegion->GetMappedSize() - sizeof(FHeader)) / sizeof(FRecord));
+        Records = reinterpret_cast<const FRecord *>(MappedRegion->GetMappedPtr() + sizeof(FHeader));
+    }
+
+    FReader::~FReader()
+    {
+        // The region has to be unmapped before the file handle is closed
+        MappedRegion.Reset();
+        MappedFile.Reset();
+    }
+} // namespace FPSInputRecording
@@ -0,0 +1,114 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Async/MappedFileHandle.h"
+#include "GenericPlatform/GenericPlatformFile.h"
+#include <type_traits>
+
+// File format of recorded player input: a header followed by fixed size records in time order.
+// A recording writes a whole file, an existing file at its path is replaced rather than appended to, since
+// record times start again at zero for every recording. Walk records hold their value until the next walk
+// record, the other actions happen once at their record's time.
+namespace FPSInputRecording
+{
+    constexpr uint32 Magic = 0x49535046; // "FPSI"
+    // Version 2 records walk input when it changes rather than every frame it is held
+    constexpr uint16 Version = 2;
+
+    // Axis values are stored as fixed point, walk axes are in [-1, 1] and look deltas in hundredths
+    constexpr float WalkAxisScale = 32767.f;
+    constexpr float LookAxisScale = 100.f;
+
+    enum class EAction : uint8
+    {
+        Walk,
+        Look,
+        CrouchStart,
+        CrouchStop,
+        Jump,
+    };
+
+    struct FHeader
+    {
+        uint32 Magic;
+        uint16 Version;
+        // Size of one record, lets readers reject files written with a different layout
+        uint16 RecordSize;
+    };
+
+    struct FRecord
+    {
+        // Milliseconds of game time since the recording started
+        uint32 TimeMs;
+        int16 X;
+        int16 Y;
+        EAction Action;
+        uint8 Padding[3];
+    };
+
+    static_assert(std::is_trivially_copyable_v<FHeader> && sizeof(FHeader) == 8);
+    static_assert(std::is_trivially_copyable_v<FRecord> && sizeof(FRecord) == 12);
+
+    inline int16 QuantizeAxis(float Value, float Scale)
+    {
+        return int16(FMath::Clamp(FMath::RoundToInt32(Value * Scale), -32767, 32767));
+    }
+    inline float DequantizeAxis(int16 Value, float Scale)
+    {
+        return float(Value) / Scale;
+    }
+
+    /** Buffers input records and writes them to a new recording file. */
+    class MOVEMENT_REMAKE_API FRecorder
+    {
+    public:
+        // Creates the file and writes the header, IsOpen is false when it could not be created
+        explicit FRecorder(const FString &Path);
+        ~FRecorder();
+
+        bool IsOpen() const
+        {
+            return FileHandle.IsValid();
+        }
+        void Record(double TimeSeconds, EAction Action, const FVector2D &Value = FVector2D::ZeroVector);
+        // Writes buffered records to the file
+        void Flush();
+
+    private:
+        TUniquePtr<IFileHandle> FileHandle;
+        TArray<FRecord> Pending;
+        // Game time of the first record
+        double StartTime = -1.0;
+    };
+
+    /** Read only view of a recording file mapped into memory. */
+    class MOVEMENT_REMAKE_API FReader
+    {
+    public:
+        // Maps the file, IsValid is false when it is missing or not a recording
+        explicit FReader(const FString &Path);
+        ~FReader();
+
+        bool IsValid() const
+        {
+            return Records != nullptr;
+        }
+        int32 Num() const
+        {
+            return NumRecords;
+        }
+        const FRecord &operator[](int32 Index) const
+        {
+            check(Index >= 0 && Index < NumRecords);
+            return Records[Index];
+        }
+
+    private:
+        TUniquePtr<IMappedFileHandle> MappedFile;
+        TUniquePtr<IMappedFileRegion> MappedRegion;
+        const FRecord *Records = nullptr;
+        int32 NumRecords = 0;
+    };
+} // namespace FPSInputRecording
@@ -0,0 +1,705 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+// Movement math for the FPS character that does not depend on the engine.
+// Everything here works on plain structs so it can be stepped outside of a world,
+// only standard headers may be included.
+#include <cmath>
+#include <cstdint>
+#include <type_traits>
+
+namespace FPSMovementKernel
+{
+    // Plain 3D vector, same axes and units as FVector
+    struct FVec3
+    {
+        float X;
+        float Y;
+        float Z;
+    };
+
+    inline FVec3 operator+(const FVec3 &A, const FVec3 &B)
+    {
+        return {A.X + B.X, A.Y + B.Y, A.Z + B.Z};
+    }
+    inline FVec3 operator-(const FVec3 &A, const FVec3 &B)
+    {
+        return {A.X - B.X, A.Y - B.Y, A.Z - B.Z};
+    }
+    inline FVec3 operator-(const FVec3 &A)
+    {
+        return {-A.X, -A.Y, -A.Z};
+    }
+    inline FVec3 operator*(const FVec3 &A, float Scale)
+    {
+        return {A.X * Scale, A.Y * Scale, A.Z * Scale};
+    }
+    inline FVec3 &operator+=(FVec3 &A, const FVec3 &B)
+    {
+        A.X += B.X;
+        A.Y += B.Y;
+        A.Z += B.Z;
+        return A;
+    }
+    inline float Dot(const FVec3 &A, const FVec3 &B)
+    {
+        return A.X * B.X + A.Y * B.Y + A.Z * B.Z;
+    }
+    inline float SizeSquared(const FVec3 &A)
+    {
+        return Dot(A, A);
+    }
+    // Matches FVector::GetSafeNormal
+    inline FVec3 GetSafeNormal(const FVec3 &A)
+    {
+        const float SquareSum = SizeSquared(A);
+        if (SquareSum < 1.e-8f)
+        {
+            return {0.f, 0.f, 0.f};
+        }
+        return A * (1.f / std::sqrt(SquareSum));
+    }
+    // Matches FVector::GetSafeNormal2D
+    inline FVec3 GetSafeNormal2D(const FVec3 &A)
+    {
+        return GetSafeNormal({A.X, A.Y, 0.f});
+    }
+    // Matches FVector::VectorPlaneProject
+    inline FVec3 VectorPlaneProject(const FVec3 &V, const FVec3 &PlaneNormal)
+    {
+        return V - PlaneNormal * Dot(V, PlaneNormal);
+    }
+    // Matches FMath::Sign
+    inline float Sign(float A)
+    {
+        return A > 0.f ? 1.f : (A < 0.f ? -1.f : 0.f);
+    }
+    // Matches FMath::IsNearlyEqual with the default tolerance
+    inline bool IsNearlyEqual(float A, float B, float Tolerance = 1.e-8f)
+    {
+        return std::fabs(A - B) <= Tolerance;
+    }
+    // Matches FMath::FInterpTo
+    inline float InterpTo(float Current, float Target, float DeltaTime, float Speed)
+    {
+        if (Speed <= 0.f)
+        {
+            return Target;
+        }
+        const float Dist = Target - Current;
+        if (Dist * Dist < 1.e-8f)
+        {
+            return Target;
+        }
+        const float Alpha = std::fmin(std::fmax(DeltaTime * Speed, 0.f), 1.f);
+        return Current + Dist * Alpha;
+    }
+
+    // Tuning values, packed by the movement tuning asset
+    struct FMovementParams
+    {
+        float WalkSpeed;
+        float CrouchSpeed;
+        // Ground friction and braking friction factor when not sliding
+        float GroundFriction;
+        float BrakingFrictionFactor;
+        float SlideForce;
+        float SlideFriction;
+        float SlideBrakingFrictionFactor;
+        float MinSlideImpulseSpeed;
+        float SlideSlopeAcceleration;
+        float WallRunCounterGravity;
+        float WallRunSpeed;
+        float WallRunEntrySpeed;
+        float WallJumpForce;
+        // Upwards speed of a jump from the ground
+        float JumpZVelocity;
+        // Seconds a wall contact is trusted before a sweep has to confirm it
+        float WallContactProbeInterval;
+        // Distance swept towards the wall to confirm a contact
+        float WallProbeDistance;
+        // Heights above the feet of ledges that can be climbed, vaults are quick climbs onto low ledges
+        float MinLedgeHeight;
+        float MaxVaultHeight;
+        float MaxMantleHeight;
+        // Distance in front of the capsule probed for a ledge
+        float LedgeReachDistance;
+        // Seconds a vault and a mantle take
+        float VaultDuration;
+        float MantleDuration;
+        float Mass;
+        float SlideCameraTiltAngle;
+        float SlideCameraTiltSpeed;
+        float CrouchTransitionSpeed;
+        float WallRunTransitionSpeed;
+        float WallRunCameraTiltAngle;
+        float CrouchScaleZ;
+        float NormalScaleZ;
+        // Crouch by shrinking the capsule instead of scaling the actor
+        bool bCapsuleCrouch;
+    };
+
+    // Physics state owned by the movement component
+    struct FMovementState
+    {
+        FVec3 Velocity;
+        // Normal of the wall the player last touched
+        FVec3 WallNormal;
+        // Sign of the dot product between the wall normal and the player right vector
+        float WallRunTiltDirection;
+        // True whenever player is holding crouch
+        bool bWantsToSlide;
+        // True whenever initial slide impulse is applied to the player
+        bool bAppliedSlideForce;
+        // True from the start of a wall run until the player lands or wall jumps
+        bool bIsWallrunning;
+        // True when player is touching the wall
+        bool bIsOnWall;
+        // Seconds since the wall contact was last reported or confirmed
+        float WallContactAge;
+        // Falling towards a wall just out of reach, the camera starts tilting before the wall run
+        bool bNearingWall;
+        // Ledge climb in progress, the capsule moves from MantleStart to MantleTarget
+        FVec3 MantleStart;
+        FVec3 MantleTarget;
+        float MantleElapsed;
+        float MantleDuration;
+        // Velocity once the climb ends, a vault keeps running and a mantle stops
+        FVec3 MantleExitVelocity;
+    };
+
+    // Camera and scale state owned by the character
+    struct FViewState
+    {
+        float CrouchScaleZ;
+        float CameraRoll;
+        // Camera height offset left by a capsule crouch, eased back to zero
+        float CrouchCameraOffsetZ;
+    };
+
+    static_assert(std::is_trivial_v<FMovementParams> && std::is_standard_layout_v<FMovementParams>);
+    static_assert(std::is_trivial_v<FMovementState> && std::is_standard_layout_v<FMovementState>);
+    static_assert(std::is_trivial_v<FViewState> && std::is_standard_layout_v<FViewState>);
+
+    // Defaults that match the movement tuning defaults
+    inline FMovementParams MakeDefaultParams()
+    {
+        FMovementParams Params;
+        Params.WalkSpeed = 600.f;
+        Params.CrouchSpeed = 300.f;
+        Params.GroundFriction = 8.f;
+        Params.BrakingFrictionFactor = 2.f;
+        Params.SlideForce = 1000.f;
+        Params.SlideFriction = .2f;
+        Params.SlideBrakingFrictionFactor = .1f;
+        Params.MinSlideImpulseSpeed = 100.f;
+        Params.SlideSlopeAcceleration = 10000.f;
+        Params.WallRunCounterGravity = 1.f;
+        Params.WallRunSpeed = 1000.f;
+        Params.WallRunEntrySpeed = 100.f;
+        Params.WallJumpForce = 300.f;
+        Params.JumpZVelocity = 420.f;
+        Params.WallContactProbeInterval = .03f;
+        Params.WallProbeDistance = 5.f;
+        Params.MinLedgeHeight = 50.f;
+        Params.MaxVaultHeight = 110.f;
+        Params.MaxMantleHeight = 200.f;
+        Params.LedgeReachDistance = 50.f;
+        Params.VaultDuration = .25f;
+        Params.MantleDuration = .5f;
+        Params.Mass = 100.f;
+        Params.SlideCameraTiltAngle = -3.f;
+        Params.SlideCameraTiltSpeed = 7.f;
+        Params.CrouchTransitionSpeed = 25.f;
+        Params.WallRunTransitionSpeed = 10.f;
+        Params.WallRunCameraTiltAngle = 10.f;
+        Params.CrouchScaleZ = .5f;
+        Params.NormalScaleZ = 1.f;
+        Params.bCapsuleCrouch = true;
+        return Params;
+    }
+
+    // Checks if a surface with this normal counts as a wall
+    inline bool IsWall(const FVec3 &Normal)
+    {
+        return Normal.Z >= -0.01f && Normal.Z <= 0.5f;
+    }
+
+    // Applies the slide impulse once per slide if the player is moving fast enough
+    inline bool TryApplySlideImpulse(FMovementState &State, const FMovementParams &Params)
+    {
+        if (State.bAppliedSlideForce ||
+            SizeSquared(State.Velocity) <= Params.MinSlideImpulseSpeed * Params.MinSlideImpulseSpeed)
+        {
+            return false;
+        }
+        State.Velocity += GetSafeNormal2D(State.Velocity) * Params.SlideForce;
+        State.bAppliedSlideForce = true;
+        return true;
+    }
+
+    // Acceleration towards the bottom of the slope the player is sliding on
+    inline FVec3 SlopeSlideAcceleration(const FVec3 &FloorNormal, const FMovementParams &Params)
+    {
+        return VectorPlaneProject({0.f, 0.f, -1.f}, FloorNormal) * Params.SlideSlopeAcceleration;
+    }
+
+    // Records a wall hit, walls only matter while in the air
+    inline void NotifyWallContact(FMovementState &State, const FVec3 &Normal, bool bOnGround)
+    {
+        if (bOnGround)
+        {
+            return;
+        }
+        State.WallNormal = Normal;
+        State.bIsOnWall = true;
+        State.WallContactAge = 0.f;
+    }
+
+    // Ages the wall contact, returns true once it is old enough to be confirmed with a sweep
+    inline bool AgeWallContact(FMovementState &State, const FMovementParams &Params, float DeltaTime)
+    {
+        if (!State.bIsOnWall)
+        {
+            return false;
+        }
+        State.WallContactAge += DeltaTime;
+        return State.WallContactAge >= Params.WallContactProbeInterval;
+    }
+
+    // Called when the confirming sweep found no wall
+    inline void LoseWallContact(FMovementState &State)
+    {
+        State.bIsOnWall = false;
+    }
+
+    // Takes a wall contact reported by someone else, such as the client on the server. The contact starts
+    // stale so the next check sweeps to confirm it.
+    inline void SuggestWallContact(FMovementState &State, const FMovementParams &Params, const FVec3 &Normal,
+                                   bool bOnGround)
+    {
+        if (State.bIsOnWall || bOnGround || !IsWall(Normal))
+        {
+            return;
+        }
+        State.WallNormal = Normal;
+        State.bIsOnWall = true;
+        State.WallContactAge = Params.WallContactProbeInterval;
+    }
+
+    // Bits used by a packed wall normal
+    constexpr int WallNormalBits = 24;
+
+    // Packs a unit wall normal into 24 bits, 16 for the yaw and 8 for the height. Walls are close to
+    // vertical, so the yaw carries almost all of the direction.
+    inline uint32_t PackWallNormal(const FVec3 &Normal)
+    {
+        constexpr float Pi = 3.14159265358979f;
+        const float Yaw = std::atan2(Normal.Y, Normal.X);
+        const uint32_t YawBits = uint32_t(std::lround((Yaw + Pi) / (2.f * Pi) * 65535.f)) & 0xffffu;
+        const float Z = std::fmin(std::fmax(Normal.Z, -1.f), 1.f);
+        const uint32_t ZBits = uint32_t(std::lround((Z + 1.f) * .5f * 255.f)) & 0xffu;
+        return YawBits | (ZBits << 16);
+    }
+
+    // Inverse of PackWallNormal, returns a unit vector
+    inline FVec3 UnpackWallNormal(uint32_t Packed)
+    {
+        constexpr float Pi = 3.14159265358979f;
+        const float Yaw = float(Packed & 0xffffu) / 65535.f * (2.f * Pi) - Pi;
+        const float Z = float((Packed >> 16) & 0xffu) / 255.f * 2.f - 1.f;
+        const float Horizontal = std::sqrt(std::fmax(1.f - Z * Z, 0.f));
+        return {std::cos(Yaw) * Horizontal, std::sin(Yaw) * Horizontal, Z};
+    }
+
+    // Tilts the camera the way a wall run on a wall with this normal would, before reaching the wall
+    inline void NearWall(FMovementState &State, const FVec3 &RightVector, const FVec3 &Normal)
+    {
+        State.WallRunTiltDirection = Sign(Dot(RightVector, Normal));
+    }
+
+    // Starts the wall run, gives a small upwards boost on the first wall run since leaving the ground
+    inline void StartWallRun(FMovementState &State, const FMovementParams &Params, const FVec3 &RightVector)
+    {
+        State.bNearingWall = false;
+        State.WallRunTiltDirection = Sign(Dot(RightVector, State.WallNormal));
+        if (!State.bIsWallrunning)
+        {
+            State.Velocity.Z = Params.WallRunEntrySpeed;
+        }
+        State.bIsWallrunning = true;
+    }
+
+    // Landing ends the wall run
+    inline void Land(FMovementState &State)
+    {
+        State.bNearingWall = false;
+        State.bIsWallrunning = false;
+        State.bIsOnWall = false;
+    }
+
+    // Acceleration on top of gravity while wall running
+    inline FVec3 WallRunAcceleration(const FMovementState &State, const FMovementParams &Params,
+                                     const FVec3 &GravityDirection)
+    {
+        // Force to keep player on wall when wall running
+        const FVec3 StickAcceleration = -State.WallNormal * Params.WallRunSpeed;
+        // Counter gravity to make player fall slower
+        const FVec3 CounterGravity = -GravityDirection * (Params.Mass * Params.WallRunCounterGravity * .4f);
+        return StickAcceleration + CounterGravity;
+    }
+
+    // Ends the wall run and returns the launch velocity for jumping off the wall
+    inline FVec3 WallJump(FMovementState &State, const FMovementParams &Params)
+    {
+        // Pushes the player off the wall before working out the jump direction
+        const FVec3 PushedVelocity = State.Velocity + State.WallNormal * Params.WallRunSpeed;
+        const FVec3 Launch =
+            (FVec3{0.f, 0.f, 1.7f} + State.WallNormal * 2.f + GetSafeNormal(PushedVelocity)) * Params.WallJumpForce;
+        State.bIsWallrunning = false;
+        State.bIsOnWall = false;
+        return Launch;
+    }
+
+    // How a ledge is climbed
+    enum class ELedgeClimb : uint8_t
+    {
+        None,
+        Vault,
+        Mantle,
+    };
+
+    // Share of a climb spent rising before moving over the ledge
+    constexpr float MantleRiseFraction = .6f;
+
+    // Picks how to climb a ledge this high above the feet
+    inline ELedgeClimb ClassifyLedge(float LedgeHeight, const FMovementParams &Params)
+    {
+        if (LedgeHeight < Params.MinLedgeHeight || LedgeHeight > Params.MaxMantleHeight)
+        {
+            return ELedgeClimb::None;
+        }
+        return LedgeHeight <= Params.MaxVaultHeight ? ELedgeClimb::Vault : ELedgeClimb::Mantle;
+    }
+
+    // Starts climbing from Start to the capsule location Target on top of the ledge
+    inline void StartMantle(FMovementState &State, const FMovementParams &Params, const FVec3 &Start,
+                            const FVec3 &Target, ELedgeClimb Climb)
+    {
+        State.MantleStart = Start;
+        State.MantleTarget = Target;
+        State.MantleElapsed = 0.f;
+        State.MantleDuration = Climb == ELedgeClimb::Vault ? Params.VaultDuration : Params.MantleDuration;
+        const float Speed2D = std::sqrt(State.Velocity.X * State.Velocity.X + State.Velocity.Y * State.Velocity.Y);
+        State.MantleExitVelocity = Climb == ELedgeClimb::Vault
+                                       ? GetSafeNormal2D(Target - Start) * std::fmax(Speed2D, Params.WalkSpeed)
+                                       : FVec3{0.f, 0.f, 0.f};
+    }
+
+    // Advances the climb and returns the capsule location. Rises first and moves over the ledge once above it,
+    // or moves over first when the ledge is below the capsule.
+    inline FVec3 StepMantle(FMovementState &State, float DeltaTime)
+    {
+        State.MantleElapsed = std::fmin(State.MantleElapsed + DeltaTime, State.MantleDuration);
+        const float Alpha = State.MantleDuration > 0.f ? State.MantleElapsed / State.MantleDuration : 1.f;
+        const float Rise = std::fmin(Alpha / MantleRiseFraction, 1.f);
+        const float Over = std::fmax((Alpha - MantleRiseFraction) / (1.f - MantleRiseFraction), 0.f);
+        const FVec3 &Start = State.MantleStart;
+        const FVec3 &Target = State.MantleTarget;
+        const float ZAlpha = Target.Z >= Start.Z ? Rise : Over;
+        return {Start.X + (Target.X - Start.X) * Over, Start.Y + (Target.Y - Start.Y) * Over,
+                Start.Z + (Target.Z - Start.Z) * ZAlpha};
+    }
+
+    inline bool IsMantleFinished(const FMovementState &State)
+    {
+        return State.MantleElapsed >= State.MantleDuration;
+    }
+
+    // Longest wall jump launch relative to WallJumpForce: straight up, twice the wall normal and the push direction
+    constexpr float MaxWallJumpScale = 1.7f + 2.f + 1.f;
+
+    // Bits in FMoveSample::Flags, what the player was allowed to do during the sampled moves
+    constexpr uint8_t MoveSampleSliding = 1 << 0;
+    constexpr uint8_t MoveSampleWallRunning = 1 << 1;
+    // Touching a wall, so a wall jump may have launched the player
+    constexpr uint8_t MoveSampleOnWall = 1 << 2;
+    // The slide impulse was applied
+    constexpr uint8_t MoveSampleSlideImpulse = 1 << 3;
+    // Climbing a ledge the client picked, bounded by the climb path instead of the movement speeds
+    constexpr uint8_t MoveSampleClimbing = 1 << 4;
+
+    // Bits in FMoveCheck::Violations
+    constexpr uint8_t MoveViolationHorizontalSpeed = 1 << 0;
+    constexpr uint8_t MoveViolationVerticalSpeed = 1 << 1;
+
+    // Location change a client reported over one server frame
+    struct FMoveSample
+    {
+        FVec3 Delta;
+        float DeltaTime;
+        // Farthest a climb may carry the capsule horizontally, set with MoveSampleClimbing
+        float ClimbReach;
+        uint8_t Flags;
+    };
+
+    // Result of checking one sample against the movement envelope
+    struct FMoveCheck
+    {
+        // Measured horizontal speed and the highest speed the envelope allowed
+        float Speed;
+        float SpeedLimit;
+        // Momentum the next sample may keep
+        float CarriedSpeed;
+        uint8_t Violations;
+    };
+
+    static_assert(std::is_trivial_v<FMoveSample> && std::is_trivial_v<FMoveCheck>);
+
+    // Checks a reported move against the speeds the tuning values allow. Momentum from earlier samples is
+    // carried, since slides and wall jumps leave the player faster than they can walk until friction catches up.
+    // Tolerance scales every limit to absorb network jitter.
+    inline FMoveCheck CheckMove(const FMoveSample &Sample, const FMovementParams &Params, float CarriedSpeed,
+                                float Tolerance)
+    {
+        FMoveCheck Check = {0.f, 0.f, CarriedSpeed, 0};
+        if (Sample.DeltaTime <= 0.f)
+        {
+            return Check;
+        }
+        float BaseSpeed = Params.WalkSpeed;
+        if (Sample.Flags & MoveSampleSliding)
+        {
+            BaseSpeed = std::fmax(Params.CrouchSpeed, BaseSpeed);
+        }
+        if (Sample.Flags & MoveSampleWallRunning)
+        {
+            BaseSpeed = std::fmax(Params.WallRunSpeed, BaseSpeed);
+        }
+        float Limit = std::fmax(BaseSpeed, CarriedSpeed);
+        if (Sample.Flags & MoveSampleSliding)
+        {
+            Limit += Params.SlideSlopeAcceleration * Sample.DeltaTime;
+        }
+        if (Sample.Flags & MoveSampleSlideImpulse)
+        {
+            Limit += Params.SlideForce;
+        }
+        if (Sample.Flags & MoveSampleOnWall)
+        {
+            Limit += Params.WallJumpForce * MaxWallJumpScale;
+        }
+
+        // Climbing is bounded by a jump, or by the horizontal speed when running up a ramp
+        float UpLimit = std::fmax(Params.JumpZVelocity, Limit);
+        // A climb rises up to the highest ledge of its kind and then moves at most ClimbReach over it, over the
+        // climb's duration or the sample when the climb is quicker
+        const float CarriedLimit = Limit;
+        if (Sample.Flags & MoveSampleClimbing)
+        {
+            const float VaultRiseSpeed =
+                Params.MaxVaultHeight / std::fmax(Params.VaultDuration * MantleRiseFraction, Sample.DeltaTime);
+            const float MantleRiseSpeed =
+                Params.MaxMantleHeight / std::fmax(Params.MantleDuration * MantleRiseFraction, Sample.DeltaTime);
+            const float OverTime = std::fmin(Params.VaultDuration, Params.MantleDuration) * (1.f - MantleRiseFraction);
+            Limit = std::fmax(Limit, Sample.ClimbReach / std::fmax(OverTime, Sample.DeltaTime));
+            UpLimit = std::fmax(UpLimit, std::fmax(VaultRiseSpeed, MantleRiseSpeed));
+        }
+
+        const float InvDeltaTime = 1.f / Sample.DeltaTime;
+        Check.Speed = std::sqrt(Sample.Delta.X * Sample.Delta.X + Sample.Delta.Y * Sample.Delta.Y) * InvDeltaTime;
+        Check.SpeedLimit = Limit;
+        const float UpSpeed = std::fmax(Sample.Delta.Z, 0.f) * InvDeltaTime;
+        Check.Violations = (Check.Speed > Limit * Tolerance ? MoveViolationHorizontalSpeed : 0) |
+                           (UpSpeed > UpLimit * Tolerance ? MoveViolationVerticalSpeed : 0);
+        // The climb path does not carry over, a vault leaves at the speed it started with or at walking speed
+        Check.CarriedSpeed = (Sample.Flags & MoveSampleClimbing)
+                                 ? std::fmax(std::fmin(Check.Speed, CarriedLimit), Params.WalkSpeed)
+                                 : std::fmin(Check.Speed, Limit);
+        return Check;
+    }
+
+    // Smoothly tilts the camera towards the angle, returns true if the roll changed
+    inline bool SmoothCameraTilt(FViewState &View, float Angle, float TiltSpeed, float DeltaTime)
+    {
+        if (IsNearlyEqual(View.CameraRoll, Angle))
+        {
+            return false;
+        }
+        View.CameraRoll = InterpTo(View.CameraRoll, Angle, DeltaTime, TiltSpeed);
+        return true;
+    }
+
+    // Camera offset below which the capsule crouch transition counts as settled
+    constexpr float CrouchCameraSettleTolerance = 0.01f;
+
+    // Keeps the camera in place when the capsule changes height, the offset is then eased away
+    inline void OffsetCrouchCamera(FViewState &View, float DeltaZ)
+    {
+        View.CrouchCameraOffsetZ += DeltaZ;
+    }
+
+    // Camera pitch of a landing shake, dips down by Angle and recovers over the duration, zero once it ends
+    inline float LandingShakePitch(float Elapsed, float Duration, float Angle)
+    {
+        if (Duration <= 0.f || Elapsed >= Duration)
+        {
+            return 0.f;
+        }
+        constexpr float Pi = 3.14159265358979f;
+        return -Angle * std::sin(Pi * Elapsed / Duration);
+    }
+
+    // Values the camera tilt and crouch transition move towards
+    struct FViewTargets
+    {
+        float CameraRoll;
+        float TiltSpeed;
+        float CrouchScaleZ;
+        // Vertical offset the crouch transition moves the player towards every step until the scale is reached
+        float LocationDeltaZ;
+    };
+
+    // Picks the camera tilt and crouch scale for the current slide and wall run state
+    inline FViewTargets GetViewTargets(const FMovementState &State, const FMovementParams &Params, bool bIsCrouching,
+                                       bool bIsWallRunning)
+    {
+        FViewTargets Targets;
+        if (bIsWallRunning || State.bNearingWall)
+        {
+            Targets.CameraRoll = State.WallRunTiltDirection * Params.WallRunCameraTiltAngle;
+            Targets.TiltSpeed = Params.WallRunTransitionSpeed;
+        }
+        else
+        {
+            Targets.CameraRoll = bIsCrouching ? Params.SlideCameraTiltAngle : 0.f;
+            Targets.TiltSpeed = Params.SlideCameraTiltSpeed;
+        }
+        // Capsule crouch leaves the actor transform alone
+        if (Params.bCapsuleCrouch)
+        {
+            Targets.CrouchScaleZ = Params.NormalScaleZ;
+            Targets.LocationDeltaZ = 0.f;
+        }
+        else
+        {
+            Targets.CrouchScaleZ = bIsCrouching ? Params.CrouchScaleZ : Params.NormalScaleZ;
+            Targets.LocationDeltaZ = (Params.NormalScaleZ - Targets.CrouchScaleZ) * (bIsCrouching ? -1.f : 1.f);
+        }
+        return Targets;
+    }
+
+    // Result of one crouch transition step
+    struct FCrouchStep
+    {
+        bool bScaleChanged;
+        // Vertical offset to move the player by, zero when no move is needed
+        float LocationDeltaZ;
+        bool bCameraOffsetChanged;
+    };
+
+    // Gradually changes scale of player to crouch or normal scale, or eases the camera after a capsule crouch
+    inline FCrouchStep GradualCrouch(FViewState &View, const FMovementParams &Params, const FViewTargets &Targets,
+                                     float DeltaTime)
+    {
+        FCrouchStep Step = {false, 0.f, false};
+        if (!IsNearlyEqual(View.CrouchScaleZ, Targets.CrouchScaleZ))
+        {
+            View.CrouchScaleZ =
+                InterpTo(View.CrouchScaleZ, Targets.CrouchScaleZ, DeltaTime, Params.CrouchTransitionSpeed);
+            Step.bScaleChanged = true;
+            // The player only moves while it scales, so the step settles once the scale is reached
+            if (!IsNearlyEqual(0.f, Targets.LocationDeltaZ))
+            {
+                Step.LocationDeltaZ =
+                    InterpTo(0.f, Targets.LocationDeltaZ, DeltaTime, Params.CrouchTransitionSpeed);
+            }
+        }
+        if (View.CrouchCameraOffsetZ != 0.f)
+        {
+            const float Offset = InterpTo(View.CrouchCameraOffsetZ, 0.f, DeltaTime, Params.CrouchTransitionSpeed);
+            View.CrouchCameraOffsetZ = std::fabs(Offset) <= CrouchCameraSettleTolerance ? 0.f : Offset;
+            Step.bCameraOffsetChanged = true;
+        }
+        return Step;
+    }
+
+    // Result of one cosmetic update
+    struct FViewStep
+    {
+        bool bRollChanged;
+        FCrouchStep Crouch;
+    };
+
+    // True when a step changed nothing, so the view has settled until the movement state changes again
+    inline bool IsSettled(const FViewStep &Step)
+    {
+        return !Step.bRollChanged && !Step.Crouch.bScaleChanged && Step.Crouch.LocationDeltaZ == 0.f &&
+               !Step.Crouch.bCameraOffsetChanged;
+    }
+
+    // Per frame camera tilt and crouch transition for sliding and wall running
+    inline FViewStep UpdateView(FViewState &View, const FMovementState &State, const FMovementParams &Params,
+                                bool bIsCrouching, bool bIsWallRunning, float DeltaTime)
+    {
+        const FViewTargets Targets = GetViewTargets(State, Params, bIsCrouching, bIsWallRunning);
+        FViewStep Step;
+        Step.bRollChanged = SmoothCameraTilt(View, Targets.CameraRoll, Targets.TiltSpeed, DeltaTime);
+        Step.Crouch = GradualCrouch(View, Params, Targets, DeltaTime);
+        return Step;
+    }
+
+    // Fixed size history of snapshots indexed by frame number, for rollback and resimulation.
+    // Storage is inline, saving and finding never allocate.
+    template <typename TSnapshot, int32_t Capacity>
+    class TSnapshotRing
+    {
+        static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+        static_assert(std::is_trivially_copyable_v<TSnapshot>, "Snapshots are copied as plain memory");
+
+    public:
+        TSnapshotRing()
+        {
+            Reset();
+        }
+
+        // Forgets every saved frame
+        void Reset()
+        {
+            for (FSlot &Slot : Slots)
+            {
+                Slot.Frame = -1;
+            }
+        }
+
+        // Stores the snapshot of a frame, replacing the one Capacity frames older
+        TSnapshot &Save(int32_t Frame, const TSnapshot &Snapshot)
+        {
+            FSlot &Slot = Slots[Frame & (Capacity - 1)];
+            Slot.Frame = Frame;
+            Slot.Snapshot = Snapshot;
+            return Slot.Snapshot;
+        }
+
+        // Returns null when the frame was never saved or has been overwritten
+        const TSnapshot *Find(int32_t Frame) const
+        {
+            const FSlot &Slot = Slots[Frame & (Capacity - 1)];
+            return Frame >= 0 && Slot.Frame == Frame ? &Slot.Snapshot : nullptr;
+        }
+
+        static constexpr int32_t GetCapacity()
+        {
+            return Capacity;
+        }
+
+    private:
+        struct FSlot
+        {
+            int32_t Frame;
+            TSnapshot Snapshot;
+        };
+        FSlot Slots[Capacity];
+    };
+} // namespace FPSMovementKernel
@@ -0,0 +1,112 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "FPSMovementLODSubsystem.h"
+#include "FPSCharacter.h"
+#include "FPSMovementStats.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+
+namespace
+{
+    bool bLODEnabled = true;
+    FAutoConsoleVariableRef CVarLODEnabled(TEXT("fps.Movement.LOD.Enabled"), bLODEnabled,
+                                           TEXT("Lowers movement detail of distant and unseen characters"));
+
+    float LODFullDistance = 2000.f;
+    FAutoConsoleVariableRef CVarLODFullDistance(TEXT("fps.Movement.LOD.FullDistance"), LODFullDistance,
+                                                TEXT("Characters closer than this to a viewer are at full detail"));
+
+    float LODReducedDistance = 6000.f;
+    FAutoConsoleVariableRef CVarLODReducedDistance(
+        TEXT("fps.Movement.LOD.ReducedDistance"), LODReducedDistance,
+        TEXT("Characters closer than this to a viewer are at reduced detail, further ones at minimal detail"));
+
+    float LODUpdateInterval = .25f;
+    FAutoConsoleVariableRef CVarLODUpdateInterval(TEXT("fps.Movement.LOD.UpdateInterval"), LODUpdateInterval,
+                                                  TEXT("Seconds between rankings of characters"));
+
+    // Seconds since a character was last drawn for it to count as visible
+    constexpr float RecentlyRenderedTolerance = .25f;
+} // namespace
+
+void UFPSMovementLODSubsystem::Tick(float DeltaTime)
+{
+    Super::Tick(DeltaTime);
+    TimeUntilUpdate -= DeltaTime;
+    if (TimeUntilUpdate > 0.f || Characters.IsEmpty())
+    {
+        return;
+    }
+    TimeUntilUpdate = LODUpdateInterval;
+    UpdateLODs();
+}
+
+TStatId UFPSMovementLODSubsystem::GetStatId() const
+{
+    RETURN_QUICK_DECLARE_CYCLE_STAT(UFPSMovementLODSubsystem, STATGROUP_Tickables);
+}
+
+void UFPSMovementLODSubsystem::RegisterCharacter(AFPSCharacter *Character)
+{
+    Characters.AddUnique(Character);
+    // Ranked on the next tick
+    TimeUntilUpdate = 0.f;
+}
+
+void UFPSMovementLODSubsystem::UnregisterCharacter(AFPSCharacter *Character)
+{
+    Characters.RemoveSwap(Character);
+}
+
+void UFPSMovementLODSubsystem::UpdateLODs()
+{
+    FPS_MOVEMENT_SCOPE(STAT_FPSMovementLOD);
+    // Viewers are the local players, a dedicated server has none and ranks by nothing but control
+    TArray<FVector, TInlineAllocator<4>> ViewLocations;
+    TArray<const AActor *, TInlineAllocator<4>> ViewTargets;
+    for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+    {
+        const APlayerController *PlayerController = It->Get();
+        if (PlayerController && PlayerController->IsLocalController())
+        {
+            FVector Location;
+            FRotator Rotation;
+            PlayerController->GetPlayerViewPoint(Location, Rotation);
+            ViewLocations.Add(Location);
+            ViewTargets.Add(PlayerController->GetViewTarget());
+        }
+    }
+    const bool bCanRender = GetWorld()->GetNetMode() != NM_DedicatedServer;
+    const float FullDistanceSquared = FMath::Square(LODFullDistance);
+    const float ReducedDistanceSquared = FMath::Square(FMath::Max(LODReducedDistance, LODFullDistance));
+
+    int32 NumPerLOD[3] = {0, 0, 0};
+    for (AFPSCharacter *Character : Characters)
+    {
+        EFPSMovementLOD LOD = EFPSMovementLOD::Full;
+        if (bLODEnabled && !Character->IsLocallyControlled() && !ViewTargets.Contains(Character))
+        {
+            double NearestSquared = UE_BIG_NUMBER;
+            for (const FVector &ViewLocation : ViewLocations)
+            {
+                NearestSquared =
+                    FMath::Min(NearestSquared, FVector::DistSquared(ViewLocation, Character->GetActorLocation()));
+            }
+            LOD = NearestSquared < FullDistanceSquared      ? EFPSMovementLOD::Full
+                  : NearestSquared < ReducedDistanceSquared ? EFPSMovementLOD::Reduced
+                                                            : EFPSMovementLOD::Minimal;
+            // Unseen characters drop a tier
+            if (LOD != EFPSMovementLOD::Minimal &&
+                (!bCanRender || !Character->WasRecentlyRendered(RecentlyRenderedTolerance)))
+            {
+                LOD = EFPSMovementLOD(uint8(LOD) + 1);
+            }
+        }
+        Character->SetMovementLOD(LOD);
+        NumPerLOD[uint8(LOD)]++;
+    }
+    SET_DWORD_STAT(STAT_FPSCharactersFullLOD, NumPerLOD[uint8(EFPSMovementLOD::Full)]);
+    SET_DWORD_STAT(STAT_FPSCharactersReducedLOD, NumPerLOD[uint8(EFPSMovementLOD::Reduced)]);
+    SET_DWORD_STAT(STAT_FPSCharactersMinimalLOD, NumPerLOD[uint8(EFPSMovementLOD::Minimal)]);
+}
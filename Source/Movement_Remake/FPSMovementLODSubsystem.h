@@ -0,0 +1,37 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "FPSMovementLODSubsystem.generated.h"
+
+class AFPSCharacter;
+
+/**
+ * Ranks characters by distance and visibility to the local viewers and sets their movement level of detail.
+ * Characters the viewers control or look through are always at full detail. Tier distances are set with
+ * fps.Movement.LOD.FullDistance and fps.Movement.LOD.ReducedDistance, and the number of characters in each
+ * tier is shown by "stat FPSMovement".
+ */
+UCLASS()
+class MOVEMENT_REMAKE_API UFPSMovementLODSubsystem : public UTickableWorldSubsystem
+{
+    GENERATED_BODY()
+
+public:
+    virtual void Tick(float DeltaTime) override;
+    virtual TStatId GetStatId() const override;
+
+    void RegisterCharacter(AFPSCharacter *Character);
+    void UnregisterCharacter(AFPSCharacter *Character);
+
+private:
+    // Picks the tier of every registered character
+    void UpdateLODs();
+
+    UPROPERTY(Transient)
+    TArray<AFPSCharacter *> Characters;
+    // Time until the next ranking
+    float TimeUntilUpdate = 0.f;
+};
@@ -0,0 +1,307 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "FPSMovementLoadTest.h"
+#include "FPSCharacter.h"
+#include "FPSMovementStats.h"
+#include "Engine/NetDriver.h"
+#include "Engine/World.h"
+#include "GameFramework/Controller.h"
+#include "GameFramework/GameModeBase.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/CommandLine.h"
+#include "Misc/DateTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Parse.h"
+#include "Misc/Paths.h"
+#include "RenderCore.h"
+
+namespace
+{
+    // Time after the bots of a step are spawned that is left out of the step's measurement
+    constexpr float WarmupTime = 2.f;
+    // Spacing of the spawn grid
+    constexpr float SpawnSpacing = 250.f;
+
+    float GTickBudgetMs = 33.3f;
+    FAutoConsoleVariableRef CVarTickBudgetMs(TEXT("fps.Movement.LoadTest.TickBudgetMs"), GTickBudgetMs,
+                                             TEXT("95th percentile server tick time in milliseconds a load test "
+                                                  "step has to stay under, 33.3 matches a 30 Hz server"));
+
+    FAutoConsoleCommandWithWorldAndArgs GLoadTestCommand(
+        TEXT("fps.Movement.LoadTest"),
+        TEXT("Spawns bots in doubling steps and reports server tick time per step to CSV. "
+             "Args: [MaxBots=256] [StepSeconds=20]"),
+        FConsoleCommandWithWorldAndArgsDelegate::CreateLambda(
+            [](const TArray<FString> &Args, UWorld *World)
+            {
+                UFPSMovementLoadTest *LoadTest = World ? World->GetSubsystem<UFPSMovementLoadTest>() : nullptr;
+                if (!LoadTest)
+                {
+                    UE_LOG(LogFPSMovement, Error, TEXT("Movement load test needs a game world"));
+                    return;
+                }
+                const int32 NumBots = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 256;
+                const float StepSeconds = Args.Num() > 1 ? FCString::Atof(*Args[1]) : 20.f;
+                LoadTest->StartLoadTest(NumBots, StepSeconds);
+            }));
+} // namespace
+
+void UFPSMovementLoadTest::Tick(float DeltaTime)
+{
+    Super::Tick(DeltaTime);
+    if (!bRunning)
+    {
+        return;
+    }
+
+    // Movement done since the previous frame
+    const uint64 MovementCycles = FPSMovementFrameStats::MovementCycles - LastMovementCycles;
+    LastMovementCycles = FPSMovementFrameStats::MovementCycles;
+
+    StepTime += DeltaTime;
+    if (bMeasuring)
+    {
+        TickMs.Add(FPlatformTime::ToMilliseconds(GGameThreadTime));
+        StepMovementCycles += MovementCycles;
+        MeasuredTime += DeltaTime;
+    }
+    else if (StepTime >= WarmupTime)
+    {
+        // Spawning and the first replication of the new bots are over, the next frame is measured
+        bMeasuring = true;
+        StepStartBytes = GetSentBytes();
+    }
+
+    if (StepTime >= WarmupTime + StepDuration)
+    {
+        FinishStep();
+        if (StepBots >= MaxBots)
+        {
+            FinishLoadTest();
+            return;
+        }
+        StepBots = FMath::Min(StepBots * 2, MaxBots);
+        BeginStep();
+    }
+    DriveBots(DeltaTime);
+}
+
+TStatId UFPSMovementLoadTest::GetStatId() const
+{
+    RETURN_QUICK_DECLARE_CYCLE_STAT(UFPSMovementLoadTest, STATGROUP_Tickables);
+}
+
+void UFPSMovementLoadTest::Deinitialize()
+{
+    DestroyBots();
+    Super::Deinitialize();
+}
+
+void UFPSMovementLoadTest::StartLoadTest(int32 InMaxBots, float StepSeconds)
+{
+    if (bRunning)
+    {
+        UE_LOG(LogFPSMovement, Warning, TEXT("Movement load test already running"));
+        return;
+    }
+    AGameModeBase *GameMode = GetWorld()->GetAuthGameMode();
+    if (!GameMode)
+    {
+        UE_LOG(LogFPSMovement, Error, TEXT("Movement load test needs to run on the server"));
+        return;
+    }
+
+    // Uses the project's character blueprint when it is the default pawn
+    BotClass = AFPSCharacter::StaticClass();
+    if (GameMode->DefaultPawnClass && GameMode->DefaultPawnClass->IsChildOf(AFPSCharacter::StaticClass()))
+    {
+        BotClass = GameMode->DefaultPawnClass.Get();
+    }
+    const AActor *PlayerStart = GameMode->FindPlayerStart(nullptr);
+    SpawnOrigin = PlayerStart ? PlayerStart->GetActorTransform() : FTransform::Identity;
+
+    MaxBots = FMath::Max(InMaxBots, 1);
+    StepDuration = FMath::Max(StepSeconds, 1.f);
+    StepBots = 1;
+    Results.Reset();
+    bRunning = true;
+    LastMovementCycles = FPSMovementFrameStats::MovementCycles;
+#if !FPS_MOVEMENT_FRAME_STATS
+    UE_LOG(LogFPSMovement, Warning, TEXT("Movement frame stats are compiled out, movement time will read zero"));
+#endif
+    UE_LOG(LogFPSMovement, Display, TEXT("Movement load test started with up to %d %s, %.1f s per step"), MaxBots,
+           *BotClass->GetName(), StepDuration);
+    BeginStep();
+}
+
+// Spawns bots until there are StepBots and restarts the measurement
+void UFPSMovementLoadTest::BeginStep()
+{
+    UWorld *World = GetWorld();
+    // The grid is sized for the last step so bots keep their places as more are added
+    const int32 GridSize = FMath::CeilToInt(FMath::Sqrt(float(MaxBots)));
+    FActorSpawnParameters SpawnParams;
+    SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
+    for (int32 Index = Bots.Num(); Index < StepBots; Index++)
+    {
+        const FVector Offset((Index / GridSize - GridSize / 2) * SpawnSpacing,
+                             (Index % GridSize - GridSize / 2) * SpawnSpacing, 0.f);
+        AFPSCharacter *Bot = World->SpawnActor<AFPSCharacter>(BotClass, SpawnOrigin.TransformPosition(Offset),
+                                                              SpawnOrigin.Rotator(), SpawnParams);
+        if (Bot)
+        {
+            Bot->SpawnDefaultController();
+            Bots.Add(Bot);
+            FBot &State = BotStates.AddDefaulted_GetRef();
+            // Seeded by index so every run drives the same bots the same way
+            State.Random.Initialize(Index + 1);
+        }
+    }
+
+    StepTime = 0.f;
+    MeasuredTime = 0.f;
+    bMeasuring = false;
+    StepMovementCycles = 0;
+    TickMs.Reset();
+}
+
+void UFPSMovementLoadTest::FinishStep()
+{
+    FStepResult &Result = Results.AddDefaulted_GetRef();
+    Result.NumBots = Bots.Num();
+    Result.NumFrames = TickMs.Num();
+    Result.TickMsP50 = FPSMovementFrameStats::Percentile(TickMs, .5f);
+    Result.TickMsP95 = FPSMovementFrameStats::Percentile(TickMs, .95f);
+    Result.TickMsP99 = FPSMovementFrameStats::Percentile(TickMs, .99f);
+    Result.MovementUsPerBot = FPlatformTime::ToMilliseconds64(StepMovementCycles) * 1000.0 /
+                              FMath::Max(Result.NumFrames * Result.NumBots, 1);
+    Result.ReplicationBytesPerSecond = MeasuredTime > 0.f ? (GetSentBytes() - StepStartBytes) / MeasuredTime : 0.f;
+    UE_LOG(LogFPSMovement, Display,
+           TEXT("Movement load test %d bots: tick p50 %.2f p95 %.2f p99 %.2f ms, movement %.1f us per bot, "
+                "replication %.0f bytes/s"),
+           Result.NumBots, Result.TickMsP50, Result.TickMsP95, Result.TickMsP99, Result.MovementUsPerBot,
+           Result.ReplicationBytesPerSecond);
+}
+
+// Writes the CSV file and removes the bots
+void UFPSMovementLoadTest::FinishLoadTest()
+{
+    bRunning = false;
+    DestroyBots();
+
+    // The scaling limit is the largest step whose tick stayed within budget
+    int32 MaxBotsWithinBudget = 0;
+    FString Csv = TEXT("Bots,Frames,TickMsP50,TickMsP95,TickMsP99,MovementUsPerBot,ReplicationBytesPerSecond,"
+                       "ReplicationBytesPerBotPerSecond,Result\n");
+    for (const FStepResult &Result : Results)
+    {
+        const bool bWithinBudget = Result.NumFrames > 0 && Result.TickMsP95 <= GTickBudgetMs;
+        if (bWithinBudget)
+        {
+            MaxBotsWithinBudget = Result.NumBots;
+        }
+        Csv += FString::Printf(TEXT("%d,%d,%.4f,%.4f,%.4f,%.4f,%.1f,%.1f,%s\n"), Result.NumBots, Result.NumFrames,
+                               Result.TickMsP50, Result.TickMsP95, Result.TickMsP99, Result.MovementUsPerBot,
+                               Result.ReplicationBytesPerSecond,
+                               Result.ReplicationBytesPerSecond / FMath::Max(Result.NumBots, 1),
+                               bWithinBudget ? TEXT("Pass") : TEXT("Fail"));
+    }
+
+    const FString Path = FPaths::ProjectSavedDir() / TEXT("Profiling") / TEXT("MovementLoadTest") /
+                         FString::Printf(TEXT("MovementLoadTest-%s.csv"), *FDateTime::Now().ToString());
+    FFileHelper::SaveStringToFile(Csv, *Path);
+    UE_LOG(LogFPSMovement, Display,
+           TEXT("Movement load test finished, tick p95 stays within %.1f ms up to %d bots, results in %s"),
+           GTickBudgetMs, MaxBotsWithinBudget, *Path);
+
+    if (FParse::Param(FCommandLine::Get(), TEXT("MovementLoadTestExit")))
+    {
+        FPlatformMisc::RequestExit(false);
+    }
+}
+
+// Feeds this frame's input to every bot, picking a new action for bots whose action ran out
+void UFPSMovementLoadTest::DriveBots(float DeltaTime)
+{
+    for (int32 Index = 0; Index < Bots.Num(); Index++)
+    {
+        AFPSCharacter *Bot = Bots[Index];
+        if (!IsValid(Bot))
+        {
+            continue;
+        }
+        FBot &State = BotStates[Index];
+        State.ActionTimeLeft -= DeltaTime;
+        if (State.ActionTimeLeft <= 0.f)
+        {
+            StartAction(*Bot, State);
+        }
+        Bot->WalkInput(FVector2D(State.Strafe, 1.f));
+    }
+}
+
+void UFPSMovementLoadTest::StartAction(AFPSCharacter &Bot, FBot &State)
+{
+    if (State.bCrouchHeld)
+    {
+        Bot.SetCrouchInput(false);
+        State.bCrouchHeld = false;
+    }
+
+    const float Roll = State.Random.FRand();
+    if (Roll < .4f)
+    {
+        // Turns to a new heading and walks
+        State.ActionTimeLeft = State.Random.FRandRange(1.f, 3.f);
+        State.Strafe = State.Random.FRandRange(-.3f, .3f);
+        if (AController *Controller = Bot.GetController())
+        {
+            Controller->SetControlRotation(FRotator(0.f, State.Random.FRandRange(-180.f, 180.f), 0.f));
+        }
+    }
+    else if (Roll < .65f)
+    {
+        // Slides out of the walk
+        State.ActionTimeLeft = State.Random.FRandRange(.5f, 1.2f);
+        State.Strafe = 0.f;
+        Bot.SetCrouchInput(true);
+        State.bCrouchHeld = true;
+    }
+    else if (Roll < .85f)
+    {
+        // Jumps sideways, a wall run starts when a wall is on that side
+        State.ActionTimeLeft = State.Random.FRandRange(1.f, 2.f);
+        State.Strafe = State.Random.RandRange(0, 1) == 0 ? -1.f : 1.f;
+        Bot.JumpInput();
+    }
+    else
+    {
+        // Jumps off the wall when wall running, a plain jump otherwise
+        State.ActionTimeLeft = State.Random.FRandRange(.3f, .6f);
+        Bot.JumpInput();
+    }
+}
+
+void UFPSMovementLoadTest::DestroyBots()
+{
+    for (AFPSCharacter *Bot : Bots)
+    {
+        if (IsValid(Bot))
+        {
+            if (AController *Controller = Bot->GetController())
+            {
+                Controller->Destroy();
+            }
+            Bot->Destroy();
+        }
+    }
+    Bots.Reset();
+    BotStates.Reset();
+}
+
+// Bytes the server has sent to all clients since it started listening
+uint64 UFPSMovementLoadTest::GetSentBytes() const
+{
+    const UNetDriver *NetDriver = GetWorld()->GetNetDriver();
+    return NetDriver ? uint64(NetDriver->OutTotalBytes) : 0;
+}
@@ -0,0 +1,94 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "FPSMovementLoadTest.generated.h"
+
+class AFPSCharacter;
+
+/**
+ * Server load test. Spawns bot controlled characters in steps of 1, 2, 4 and so on up to a maximum. The bots
+ * walk, slide, wall run and wall jump at random. Every step reports server tick time percentiles, movement cost
+ * per bot and replication bytes to one CSV row, so the bot count where the tick leaves its budget can be read off.
+ * Replication is only measured for clients that are connected, for example a few -nullrhi clients.
+ *
+ * Start it on a dedicated server with the game mode option, or headless with the load test commandlet:
+ *   UnrealServer Movement_Remake /Game/TestMap?LoadTest=256?LoadTestStepSeconds=20 -log -MovementLoadTestExit
+ *   UnrealEditor-Cmd Movement_Remake.uproject -run=FPSMovementLoadTest -Map=/Game/TestMap -MaxBots=256
+ */
+UCLASS()
+class MOVEMENT_REMAKE_API UFPSMovementLoadTest : public UTickableWorldSubsystem
+{
+    GENERATED_BODY()
+
+public:
+    virtual void Tick(float DeltaTime) override;
+    virtual TStatId GetStatId() const override;
+    virtual void Deinitialize() override;
+
+    // Spawns the first bot and starts the ramp, does nothing while a load test is running
+    void StartLoadTest(int32 InMaxBots, float StepSeconds);
+    bool IsRunning() const
+    {
+        return bRunning;
+    }
+
+private:
+    struct FBot
+    {
+        FRandomStream Random;
+        float ActionTimeLeft = 0.f;
+        // Sideways input held during the action, wall runs lean into a wall on one side
+        float Strafe = 0.f;
+        bool bCrouchHeld = false;
+    };
+
+    struct FStepResult
+    {
+        int32 NumBots;
+        int32 NumFrames;
+        float TickMsP50;
+        float TickMsP95;
+        float TickMsP99;
+        float MovementUsPerBot;
+        float ReplicationBytesPerSecond;
+    };
+
+    // Spawns bots until there are StepBots and restarts the measurement
+    void BeginStep();
+    void FinishStep();
+    // Writes the CSV file and removes the bots
+    void FinishLoadTest();
+    // Feeds this frame's input to every bot, picking a new action for bots whose action ran out
+    void DriveBots(float DeltaTime);
+    void StartAction(AFPSCharacter &Bot, FBot &State);
+    void DestroyBots();
+    // Bytes the server has sent to all clients since it started listening
+    uint64 GetSentBytes() const;
+
+    // Bots spawned for the load test
+    UPROPERTY(Transient)
+    TArray<AFPSCharacter *> Bots;
+    TArray<FBot> BotStates;
+    TSubclassOf<AFPSCharacter> BotClass;
+    // Bots are spawned on a grid around the player start
+    FTransform SpawnOrigin;
+
+    TArray<FStepResult> Results;
+    // Server tick time of every measured frame of the current step
+    TArray<float> TickMs;
+
+    bool bRunning = false;
+    bool bMeasuring = false;
+    int32 MaxBots = 0;
+    int32 StepBots = 0;
+    float StepDuration = 0.f;
+    float StepTime = 0.f;
+    float MeasuredTime = 0.f;
+    // Movement cycles of the measured frames, and the totals at the previous frame
+    uint64 StepMovementCycles = 0;
+    uint64 LastMovementCycles = 0;
+    uint64 StepStartBytes = 0;
+};
@@ -0,0 +1,93 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "FPSMovementLoadTestCommandlet.h"
+#include "FPSMovementLoadTest.h"
+#include "FPSMovementStats.h"
+#include "Containers/Ticker.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "HAL/PlatformProcess.h"
+#include "RenderCore.h"
+#include "UObject/Package.h"
+
+UFPSMovementLoadTestCommandlet::UFPSMovementLoadTestCommandlet()
+{
+    IsClient = false;
+    IsServer = true;
+    IsEditor = false;
+    LogToConsole = true;
+}
+
+int32 UFPSMovementLoadTestCommandlet::Main(const FString &Params)
+{
+    TArray<FString> Tokens;
+    TArray<FString> Switches;
+    TMap<FString, FString> ParamValues;
+    ParseCommandLine(*Params, Tokens, Switches, ParamValues);
+    const FString MapName = ParamValues.FindRef(TEXT("Map"));
+    const FString *MaxBots = ParamValues.Find(TEXT("MaxBots"));
+    const FString *StepSeconds = ParamValues.Find(TEXT("StepSeconds"));
+    const FString *TickRate = ParamValues.Find(TEXT("TickRate"));
+    const float DeltaTime = 1.f / FMath::Max(TickRate ? FCString::Atof(**TickRate) : 30.f, 1.f);
+    if (MapName.IsEmpty())
+    {
+        UE_LOG(LogFPSMovement, Error, TEXT("Usage: -run=FPSMovementLoadTest -Map=<Map> [-MaxBots=256] "
+                                           "[-StepSeconds=20] [-TickRate=30]"));
+        return 1;
+    }
+
+    UPackage *Package = LoadPackage(nullptr, *MapName, LOAD_None);
+    UWorld *World = Package ? UWorld::FindWorldInPackage(Package) : nullptr;
+    if (!World)
+    {
+        UE_LOG(LogFPSMovement, Error, TEXT("Could not load map %s"), *MapName);
+        return 1;
+    }
+
+    // Sets the map up the way a dedicated server opens it, listening so clients can connect
+    World->AddToRoot();
+    World->WorldType = EWorldType::Game;
+    FWorldContext &WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+    WorldContext.SetCurrentWorld(World);
+    if (!World->bIsWorldInitialized)
+    {
+        World->InitWorld();
+    }
+    World->UpdateWorldComponents(true, false);
+    FURL URL;
+    URL.Map = MapName;
+    URL.AddOption(TEXT("listen"));
+    World->SetGameMode(URL);
+    World->Listen(URL);
+    World->InitializeActorsForPlay(URL);
+    World->BeginPlay();
+
+    int32 Result = 1;
+    if (UFPSMovementLoadTest *LoadTest = World->GetSubsystem<UFPSMovementLoadTest>())
+    {
+        LoadTest->StartLoadTest(MaxBots ? FCString::Atoi(**MaxBots) : 256,
+                                StepSeconds ? FCString::Atof(**StepSeconds) : 20.f);
+        while (LoadTest->IsRunning() && !IsEngineExitRequested())
+        {
+            const uint64 StartCycles = FPlatformTime::Cycles64();
+            GFrameCounter++;
+            FTSTicker::GetCoreTicker().Tick(DeltaTime);
+            World->Tick(LEVELTICK_All, DeltaTime);
+            // The load test reads the tick time the engine loop records, which does not run in a commandlet
+            const uint64 TickCycles = FPlatformTime::Cycles64() - StartCycles;
+            GGameThreadTime = uint32(TickCycles);
+            // Idles out the rest of the tick like a dedicated server at its tick rate
+            const double IdleSeconds = DeltaTime - FPlatformTime::ToSeconds64(TickCycles);
+            if (IdleSeconds > 0.0)
+            {
+                FPlatformProcess::Sleep(float(IdleSeconds));
+            }
+        }
+        Result = LoadTest->IsRunning() ? 1 : 0;
+    }
+
+    World->DestroyWorld(false);
+    GEngine->DestroyWorldContext(World);
+    World->RemoveFromRoot();
+    return Result;
+}
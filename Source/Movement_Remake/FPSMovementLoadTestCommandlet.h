@@ -0,0 +1,25 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "FPSMovementLoadTestCommandlet.generated.h"
+
+/**
+ * Runs the movement load test headless, without starting a server process. Loads the map as a listening game
+ * world and ticks it at the server tick rate until the load test has measured every step:
+ *   UnrealEditor-Cmd Movement_Remake.uproject -run=FPSMovementLoadTest -Map=/Game/TestMap -MaxBots=256
+ *       [-StepSeconds=20] [-TickRate=30]
+ * Clients can connect to the commandlet's port while it runs to measure replication.
+ */
+UCLASS()
+class MOVEMENT_REMAKE_API UFPSMovementLoadTestCommandlet : public UCommandlet
+{
+    GENERATED_BODY()
+
+public:
+    UFPSMovementLoadTestCommandlet();
+
+    virtual int32 Main(const FString &Params) override;
+};
@@ -0,0 +1,397 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "FPSMovementPerfCapture.h"
+#include "FPSCharacter.h"
+#include "FPSCharacterMovementComponent.h"
+#include "FPSMovementStats.h"
+#include "Engine/World.h"
+#include "GameFramework/Controller.h"
+#include "GameFramework/GameModeBase.h"
+#include "HAL/FileManager.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/AutomationTest.h"
+#include "Misc/DateTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/PackageName.h"
+#include "Misc/Paths.h"
+#include "RenderCore.h"
+#include "Tests/AutomationCommon.h"
+
+namespace
+{
+    // Length of one scripted walk, slide, wall run and wall jump loop, same as the movement benchmark
+    constexpr float ScriptLength = 4.f;
+    // Frames at the start of a capture that are recorded but left out of the budget checks
+    constexpr float WarmupTime = 1.f;
+    // Spacing of the spawn grid
+    constexpr float SpawnSpacing = 250.f;
+    // Capture the automation test runs, and the console command when it is given no arguments
+    constexpr int32 DefaultCharacters = 64;
+    constexpr float DefaultDuration = 30.f;
+    // Frames every character is rolled back and resimulated once per RollbackInterval seconds of capture
+    constexpr int32 RollbackFrames = 10;
+    constexpr float RollbackInterval = 1.f;
+
+    float GMovementBudgetMs = 2.f;
+    FAutoConsoleVariableRef CVarMovementBudgetMs(TEXT("fps.Movement.PerfBudget.MovementMs"), GMovementBudgetMs,
+                                                 TEXT("95th percentile movement time per frame in milliseconds"));
+    float GGameThreadBudgetMs = 16.6f;
+    FAutoConsoleVariableRef CVarGameThreadBudgetMs(TEXT("fps.Movement.PerfBudget.GameThreadMs"), GGameThreadBudgetMs,
+                                                   TEXT("95th percentile game thread time in milliseconds"));
+    float GQueriesPerCharacterBudget = 12.f;
+    FAutoConsoleVariableRef CVarQueriesPerCharacterBudget(
+        TEXT("fps.Movement.PerfBudget.QueriesPerCharacter"), GQueriesPerCharacterBudget,
+        TEXT("95th percentile movement physics queries per character per frame"));
+    float GRollbackBudgetMs = .5f;
+    FAutoConsoleVariableRef CVarRollbackBudgetMs(
+        TEXT("fps.Movement.PerfBudget.RollbackMs"), GRollbackBudgetMs,
+        TEXT("95th percentile time to roll every character back and resimulate 10 frames, in milliseconds"));
+
+    FAutoConsoleCommandWithWorldAndArgs GPerfCaptureCommand(
+        TEXT("fps.Movement.PerfCapture"),
+        TEXT("Spawns scripted characters on the current map and records movement cost to CSV. Args: "
+             "[Characters=64] [Seconds=30]"),
+        FConsoleCommandWithWorldAndArgsDelegate::CreateLambda(
+            [](const TArray<FString> &Args, UWorld *World)
+            {
+                UFPSMovementPerfCapture *Capture = World ? World->GetSubsystem<UFPSMovementPerfCapture>() : nullptr;
+                if (!Capture)
+                {
+                    UE_LOG(LogFPSMovement, Error, TEXT("Movement perf capture needs a game world"));
+                    return;
+                }
+                const int32 NumCharacters = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : DefaultCharacters;
+                const float Duration = Args.Num() > 1 ? FCString::Atof(*Args[1]) : DefaultDuration;
+                Capture->StartCapture(FMath::Max(NumCharacters, 1), FMath::Max(Duration, WarmupTime + 1.f));
+            }));
+
+#if WITH_DEV_AUTOMATION_TESTS
+    // Time the map gets to finish streaming and startup work before the capture starts
+    constexpr float MapSettleTime = 2.f;
+    // Real time a capture may take before the test gives up on it, headless frames can run slower than game time
+    constexpr float MaxCaptureRealTime = DefaultDuration * 4.f + 60.f;
+
+    UFPSMovementPerfCapture *FindPerfCapture()
+    {
+        UWorld *World = AutomationCommon::GetAnyGameWorld();
+        return World ? World->GetSubsystem<UFPSMovementPerfCapture>() : nullptr;
+    }
+
+    DEFINE_LATENT_AUTOMATION_COMMAND_ONE_PARAMETER(FStartMovementPerfCaptureCommand, FAutomationTestBase *, Test);
+    bool FStartMovementPerfCaptureCommand::Update()
+    {
+        UFPSMovementPerfCapture *Capture = FindPerfCapture();
+        if (!Capture || !Capture->StartCapture(DefaultCharacters, DefaultDuration))
+        {
+            Test->AddError(TEXT("Could not start the movement perf capture, it needs a game world with authority"));
+        }
+        return true;
+    }
+
+    // Waits for the capture to finish and reports every budget it exceeded
+    DEFINE_LATENT_AUTOMATION_COMMAND_ONE_PARAMETER(FWaitForMovementPerfCaptureCommand, FAutomationTestBase *, Test);
+    bool FWaitForMovementPerfCaptureCommand::Update()
+    {
+        const UFPSMovementPerfCapture *Capture = FindPerfCapture();
+        if (!Capture)
+        {
+            Test->AddError(TEXT("The game world went away during the movement perf capture"));
+            return true;
+        }
+        if (Capture->IsCapturing())
+        {
+            if (GetCurrentRunTime() > MaxCaptureRealTime)
+            {
+                Test->AddError(FString::Printf(TEXT("Movement perf capture did not finish in %.0f s"),
+                                               MaxCaptureRealTime));
+                return true;
+            }
+            return false;
+        }
+        if (Capture->GetBudgetResults().IsEmpty())
+        {
+            Test->AddError(TEXT("Movement perf capture recorded no frames past the warmup"));
+        }
+        for (const UFPSMovementPerfCapture::FBudgetResult &Result : Capture->GetBudgetResults())
+        {
+            if (!Result.IsWithinBudget())
+            {
+                Test->AddError(FString::Printf(TEXT("%s p95 %.4f exceeds the budget of %.4f"), Result.Metric,
+                                               Result.Value, Result.Budget));
+            }
+        }
+        return true;
+    }
+#endif
+} // namespace
+
+#if WITH_DEV_AUTOMATION_TESTS
+IMPLEMENT_COMPLEX_AUTOMATION_TEST(FFPSMovementPerfCaptureTest, "FPSMovement.PerfCapture",
+                                  EAutomationTestFlags::ClientContext | EAutomationTestFlags::PerfFilter)
+
+// One test per project map
+void FFPSMovementPerfCaptureTest::GetTests(TArray<FString> &OutBeautifiedNames, TArray<FString> &OutTestCommands) const
+{
+    TArray<FString> MapFiles;
+    IFileManager::Get().FindFilesRecursive(MapFiles, *FPaths::ProjectContentDir(),
+                                           *(TEXT("*") + FPackageName::GetMapPackageExtension()), true, false);
+    for (const FString &MapFile : MapFiles)
+    {
+        FString PackageName;
+        // The starter content maps have no walls to run on
+        if (FPackageName::TryConvertFilenameToLongPackageName(MapFile, PackageName) &&
+            !PackageName.StartsWith(TEXT("/Game/StarterContent/")))
+        {
+            OutBeautifiedNames.Add(FPaths::GetBaseFilename(MapFile));
+            OutTestCommands.Add(PackageName);
+        }
+    }
+}
+
+bool FFPSMovementPerfCaptureTest::RunTest(const FString &Parameters)
+{
+    ADD_LATENT_AUTOMATION_COMMAND(FLoadGameMapCommand(Parameters));
+    ADD_LATENT_AUTOMATION_COMMAND(FWaitForMapToLoadCommand());
+    ADD_LATENT_AUTOMATION_COMMAND(FEngineWaitLatentCommand(MapSettleTime));
+    ADD_LATENT_AUTOMATION_COMMAND(FStartMovementPerfCaptureCommand(this));
+    ADD_LATENT_AUTOMATION_COMMAND(FWaitForMovementPerfCaptureCommand(this));
+    return true;
+}
+#endif
+
+void UFPSMovementPerfCapture::Tick(float DeltaTime)
+{
+    Super::Tick(DeltaTime);
+    if (!bCapturing)
+    {
+        return;
+    }
+
+    // Movement done since the previous frame, which ran with last frame's input
+    FFrameSample &Sample = Samples.AddDefaulted_GetRef();
+    Sample.FrameMs = DeltaTime * 1000.f;
+    Sample.GameThreadMs = FPlatformTime::ToMilliseconds(GGameThreadTime);
+    Sample.MovementMs = FPlatformTime::ToMilliseconds64(FPSMovementFrameStats::MovementCycles - LastMovementCycles);
+    Sample.PhysicsQueries = FPSMovementFrameStats::PhysicsQueries - LastPhysicsQueries;
+    LastMovementCycles = FPSMovementFrameStats::MovementCycles;
+    LastPhysicsQueries = FPSMovementFrameStats::PhysicsQueries;
+
+    CaptureTime += DeltaTime;
+    if (CaptureTime >= CaptureDuration)
+    {
+        FinishCapture();
+        return;
+    }
+    if (CaptureTime >= NextRollbackTime)
+    {
+        MeasureRollback(DeltaTime);
+        NextRollbackTime += RollbackInterval;
+    }
+    DriveCharacters(DeltaTime);
+}
+
+TStatId UFPSMovementPerfCapture::GetStatId() const
+{
+    RETURN_QUICK_DECLARE_CYCLE_STAT(UFPSMovementPerfCapture, STATGROUP_Tickables);
+}
+
+void UFPSMovementPerfCapture::Deinitialize()
+{
+    DestroyCharacters();
+    Super::Deinitialize();
+}
+
+bool UFPSMovementPerfCapture::StartCapture(int32 NumCharacters, float Duration)
+{
+    if (bCapturing)
+    {
+        UE_LOG(LogFPSMovement, Warning, TEXT("Movement perf capture already running"));
+        return false;
+    }
+    UWorld *World = GetWorld();
+    AGameModeBase *GameMode = World->GetAuthGameMode();
+    if (!GameMode)
+    {
+        UE_LOG(LogFPSMovement, Error, TEXT("Movement perf capture needs to run on the server"));
+        return false;
+    }
+
+    // Uses the project's character blueprint when it is the default pawn
+    TSubclassOf<AFPSCharacter> CharacterClass = AFPSCharacter::StaticClass();
+    if (GameMode->DefaultPawnClass && GameMode->DefaultPawnClass->IsChildOf(AFPSCharacter::StaticClass()))
+    {
+        CharacterClass = GameMode->DefaultPawnClass.Get();
+    }
+    const AActor *PlayerStart = GameMode->FindPlayerStart(nullptr);
+    const FTransform Origin = PlayerStart ? PlayerStart->GetActorTransform() : FTransform::Identity;
+
+    // Spawns the characters on a grid around the player start
+    const int32 GridSize = FMath::CeilToInt(FMath::Sqrt(float(NumCharacters)));
+    FActorSpawnParameters SpawnParams;
+    SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
+    for (int32 Index = 0; Index < NumCharacters; Index++)
+    {
+        const FVector Offset((Index / GridSize - GridSize / 2) * SpawnSpacing,
+                             (Index % GridSize - GridSize / 2) * SpawnSpacing, 0.f);
+        AFPSCharacter *Character = World->SpawnActor<AFPSCharacter>(
+            CharacterClass, Origin.TransformPosition(Offset), Origin.Rotator(), SpawnParams);
+        if (Character)
+        {
+            Character->SpawnDefaultController();
+            Characters.Add(Character);
+        }
+    }
+    CrouchHeld.Init(false, Characters.Num());
+
+    Samples.Reset();
+    RollbackSamplesMs.Reset();
+    NextRollbackTime = WarmupTime;
+    BudgetResults.Reset();
+    bCapturing = true;
+    CaptureTime = 0.f;
+    CaptureDuration = Duration;
+    LastMovementCycles = FPSMovementFrameStats::MovementCycles;
+    LastPhysicsQueries = FPSMovementFrameStats::PhysicsQueries;
+#if !FPS_MOVEMENT_FRAME_STATS
+    UE_LOG(LogFPSMovement, Warning, TEXT("Movement frame stats are compiled out, movement time will read zero"));
+#endif
+    UE_LOG(LogFPSMovement, Display, TEXT("Movement perf capture started with %d %s for %.1f s"), Characters.Num(),
+           *CharacterClass->GetName(), Duration);
+    return true;
+}
+
+void UFPSMovementPerfCapture::DriveCharacters(float DeltaTime)
+{
+    for (int32 Index = 0; Index < Characters.Num(); Index++)
+    {
+        AFPSCharacter *Character = Characters[Index];
+        if (!IsValid(Character))
+        {
+            continue;
+        }
+        // Offsets each character along the script so they do not all change state together
+        const float Offset = ScriptLength * float(Index % 97) / 97.f;
+        const float Time = FMath::Fmod(CaptureTime + Offset, ScriptLength);
+        const float PreviousTime = Time - DeltaTime;
+
+        // Walks forward, slides, jumps towards the wall on the right, runs along it and jumps off
+        Character->WalkInput(FVector2D(Time >= 1.6f && Time < 3.f ? 1.f : 0.f, 1.f));
+        const bool bCrouch = Time >= 1.f && Time < 1.6f;
+        if (bCrouch != CrouchHeld[Index])
+        {
+            Character->SetCrouchInput(bCrouch);
+            CrouchHeld[Index] = bCrouch;
+        }
+        if ((PreviousTime < 1.6f && Time >= 1.6f) || (PreviousTime < 3.f && Time >= 3.f))
+        {
+            Character->JumpInput();
+        }
+    }
+}
+
+void UFPSMovementPerfCapture::MeasureRollback(float DeltaTime)
+{
+    // Every frame is resimulated with this frame's time step, the capture's frames vary a little around it
+    int32 NumSimulated = 0;
+    const uint64 StartCycles = FPlatformTime::Cycles64();
+    for (AFPSCharacter *Character : Characters)
+    {
+        if (IsValid(Character))
+        {
+            const int32 Frame = Character->GetFPSMovement()->GetMovementFrame() - RollbackFrames;
+            NumSimulated += Character->Resimulate(Frame, RollbackFrames, DeltaTime);
+        }
+    }
+    const float RollbackMs = FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - StartCycles);
+    // Characters without enough saved frames yet would make the rollback look cheaper than it is
+    if (NumSimulated == Characters.Num() * RollbackFrames)
+    {
+        RollbackSamplesMs.Add(RollbackMs);
+    }
+}
+
+void UFPSMovementPerfCapture::FinishCapture()
+{
+    bCapturing = false;
+    DestroyCharacters();
+
+    const int32 NumCharacters = CrouchHeld.Num();
+    const FString BaseName = FPaths::ProjectSavedDir() / TEXT("Profiling") / TEXT("MovementPerf") /
+                             FString::Printf(TEXT("MovementPerf-%s"), *FDateTime::Now().ToString());
+
+    // One row per frame
+    TArray<float> MovementMs;
+    TArray<float> GameThreadMs;
+    TArray<float> QueriesPerCharacter;
+    FString FramesCsv = TEXT("Frame,Time,FrameMs,GameThreadMs,MovementMs,PhysicsQueries\n");
+    float Time = 0.f;
+    for (int32 Frame = 0; Frame < Samples.Num(); Frame++)
+    {
+        const FFrameSample &Sample = Samples[Frame];
+        FramesCsv += FString::Printf(TEXT("%d,%.4f,%.4f,%.4f,%.4f,%u\n"), Frame, Time, Sample.FrameMs,
+                                     Sample.GameThreadMs, Sample.MovementMs, Sample.PhysicsQueries);
+        if (Time >= WarmupTime)
+        {
+            MovementMs.Add(Sample.MovementMs);
+            GameThreadMs.Add(Sample.GameThreadMs);
+            QueriesPerCharacter.Add(float(Sample.PhysicsQueries) / FMath::Max(NumCharacters, 1));
+        }
+        Time += Sample.FrameMs / 1000.f;
+    }
+
+    // 95th percentile of each metric against its budget
+    if (!MovementMs.IsEmpty())
+    {
+        BudgetResults = {
+            {TEXT("MovementMs"), FPSMovementFrameStats::Percentile(MovementMs, .95f), GMovementBudgetMs},
+            {TEXT("GameThreadMs"), FPSMovementFrameStats::Percentile(GameThreadMs, .95f), GGameThreadBudgetMs},
+            {TEXT("PhysicsQueriesPerCharacter"), FPSMovementFrameStats::Percentile(QueriesPerCharacter, .95f),
+             GQueriesPerCharacterBudget},
+        };
+        if (!RollbackSamplesMs.IsEmpty())
+        {
+            BudgetResults.Add({TEXT("RollbackMs"), FPSMovementFrameStats::Percentile(RollbackSamplesMs, .95f),
+                               GRollbackBudgetMs});
+        }
+    }
+    bool bPassed = !BudgetResults.IsEmpty();
+    FString SummaryCsv = TEXT("Metric,P95,Budget,Result\n");
+    for (const FBudgetResult &Result : BudgetResults)
+    {
+        const bool bWithinBudget = Result.IsWithinBudget();
+        bPassed &= bWithinBudget;
+        SummaryCsv += FString::Printf(TEXT("%s,%.4f,%.4f,%s\n"), Result.Metric, Result.Value, Result.Budget,
+                                      bWithinBudget ? TEXT("Pass") : TEXT("Fail"));
+        UE_LOG(LogFPSMovement, Display, TEXT("%s p95 %.4f budget %.4f %s"), Result.Metric, Result.Value,
+               Result.Budget, bWithinBudget ? TEXT("Pass") : TEXT("Fail"));
+    }
+    SummaryCsv += FString::Printf(TEXT("Characters,%d,,\nFrames,%d,,\nRollbacks,%d,,\n"), NumCharacters,
+                                  Samples.Num(), RollbackSamplesMs.Num());
+
+    FFileHelper::SaveStringToFile(FramesCsv, *(BaseName + TEXT("-Frames.csv")));
+    FFileHelper::SaveStringToFile(SummaryCsv, *(BaseName + TEXT("-Summary.csv")));
+    if (bPassed)
+    {
+        UE_LOG(LogFPSMovement, Display, TEXT("Movement perf capture passed, results in %s-*.csv"), *BaseName);
+    }
+    else
+    {
+        UE_LOG(LogFPSMovement, Error, TEXT("Movement perf capture failed, results in %s-*.csv"), *BaseName);
+    }
+}
+
+void UFPSMovementPerfCapture::DestroyCharacters()
+{
+    for (AFPSCharacter *Character : Characters)
+    {
+        if (IsValid(Character))
+        {
+            if (AController *Controller = Character->GetController())
+            {
+                Controller->Destroy();
+            }
+            Character->Destroy();
+        }
+    }
+    Characters.Reset();
+}
@@ -0,0 +1,93 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "FPSMovementPerfCapture.generated.h"
+
+class AFPSCharacter;
+
+/**
+ * Headless movement performance capture. Spawns characters on the current map and drives them through a
+ * scripted walk, slide, wall run and wall jump loop with the same input handlers the action bindings use.
+ * One CSV row is written per frame, and the run fails when the 95th percentile exceeds the budgets. Once a
+ * second every character is also rolled back and resimulated, which is budgeted the same way.
+ *
+ * The FPSMovement.PerfCapture automation test loads each project map, captures it and reports every budget
+ * it exceeds as an error. Run it on Linux without rendering:
+ *   UnrealEditor-Cmd Movement_Remake.uproject -game -nullrhi -nosound -unattended
+ *       -ExecCmds="Automation RunTests FPSMovement.PerfCapture; Quit"
+ * Capture the current map by hand with:
+ *   fps.Movement.PerfCapture [Characters=64] [Seconds=30]
+ */
+UCLASS()
+class MOVEMENT_REMAKE_API UFPSMovementPerfCapture : public UTickableWorldSubsystem
+{
+    GENERATED_BODY()
+
+public:
+    virtual void Tick(float DeltaTime) override;
+    virtual TStatId GetStatId() const override;
+    virtual void Deinitialize() override;
+
+    // 95th percentile of one metric of the last capture against its budget
+    struct FBudgetResult
+    {
+        const TCHAR *Metric;
+        float Value;
+        float Budget;
+
+        bool IsWithinBudget() const
+        {
+            return Value <= Budget;
+        }
+    };
+
+    // Spawns the characters and starts recording, returns false when a capture is running or this is no server
+    bool StartCapture(int32 NumCharacters, float Duration);
+    bool IsCapturing() const
+    {
+        return bCapturing;
+    }
+    // Results of the last finished capture, empty when it recorded no frames past the warmup
+    const TArray<FBudgetResult> &GetBudgetResults() const
+    {
+        return BudgetResults;
+    }
+
+private:
+    struct FFrameSample
+    {
+        float FrameMs;
+        float GameThreadMs;
+        float MovementMs;
+        uint32 PhysicsQueries;
+    };
+
+    // Feeds this frame's scripted input to every character
+    void DriveCharacters(float DeltaTime);
+    // Rolls every character back and resimulates its last frames, and records how long that took
+    void MeasureRollback(float DeltaTime);
+    // Writes the CSV files, checks the budgets and removes the characters
+    void FinishCapture();
+    void DestroyCharacters();
+
+    // Characters spawned for the capture
+    UPROPERTY(Transient)
+    TArray<AFPSCharacter *> Characters;
+    // Crouch input currently held by each character
+    TArray<bool> CrouchHeld;
+    TArray<FFrameSample> Samples;
+    // Time of each rollback of all characters
+    TArray<float> RollbackSamplesMs;
+    TArray<FBudgetResult> BudgetResults;
+
+    bool bCapturing = false;
+    float CaptureTime = 0.f;
+    float CaptureDuration = 0.f;
+    float NextRollbackTime = 0.f;
+    // Movement totals at the previous frame
+    uint64 LastMovementCycles = 0;
+    uint32 LastPhysicsQueries = 0;
+};
@@ -0,0 +1,44 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "FPSMovementKernel.h"
+#include <type_traits>
+
+// Input that produced a frame, replayed when the frames after a rollback are resimulated
+struct FFPSMovementInput
+{
+    // Acceleration the movement component moved with
+    FVector Acceleration;
+    // Launch applied at the start of the move, set by wall jumps
+    FVector LaunchVelocity;
+    // Ledge the move climbs onto when bWantsToMantle is set
+    FVector MantleTarget;
+    bool bPressedJump;
+    bool bWantsToCrouch;
+    bool bWantsToSlide;
+    bool bWantsToMantle;
+};
+
+// Everything needed to put a character back to the end of a frame
+struct FFPSMovementSnapshot
+{
+    FVector Location;
+    FQuat Rotation;
+    FVector Velocity;
+    FPSMovementKernel::FMovementState MoveState;
+    FPSMovementKernel::FViewState ViewState;
+    uint8 MovementMode;
+    uint8 CustomMovementMode;
+    // Capsule crouch of the movement component, and the character's crouch that picks the crouch tuning
+    bool bIsCrouched;
+    bool bIsCrouching;
+    FFPSMovementInput Input;
+};
+
+static_assert(std::is_trivially_copyable_v<FFPSMovementInput>);
+static_assert(std::is_trivially_copyable_v<FFPSMovementSnapshot>);
+
+// Frames of history kept per character, about a second at 60 Hz
+using FFPSMovementSnapshotRing = FPSMovementKernel::TSnapshotRing<FFPSMovementSnapshot, 64>;
@@ -0,0 +1,80 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "FPSMovementStats.h"
+#include "Engine/Engine.h"
+#include "HAL/IConsoleManager.h"
+
+DEFINE_STAT(STAT_FPSMovementTick);
+DEFINE_STAT(STAT_FPSCharacterTick);
+DEFINE_STAT(STAT_FPSHitHandling);
+DEFINE_STAT(STAT_FPSWallContactProbe);
+DEFINE_STAT(STAT_FPSSlide);
+DEFINE_STAT(STAT_FPSWallRun);
+DEFINE_STAT(STAT_FPSMantle);
+DEFINE_STAT(STAT_FPSLedgeProbes);
+DEFINE_STAT(STAT_FPSCrouch);
+DEFINE_STAT(STAT_FPSCameraEffects);
+DEFINE_STAT(STAT_FPSBatchMovement);
+DEFINE_STAT(STAT_FPSMoveValidation);
+DEFINE_STAT(STAT_FPSMovementLOD);
+DEFINE_STAT(STAT_FPSTraversalPath);
+DEFINE_STAT(STAT_FPSHits);
+DEFINE_STAT(STAT_FPSWallProbes);
+DEFINE_STAT(STAT_FPSPhysicsQueries);
+DEFINE_STAT(STAT_FPSLedgeProbeQueries);
+DEFINE_STAT(STAT_FPSStateTransitions);
+DEFINE_STAT(STAT_FPSTransformWrites);
+DEFINE_STAT(STAT_FPSMoveViolations);
+DEFINE_STAT(STAT_FPSTelemetryRecords);
+DEFINE_STAT(STAT_FPSCharactersFullLOD);
+DEFINE_STAT(STAT_FPSCharactersReducedLOD);
+DEFINE_STAT(STAT_FPSCharactersMinimalLOD);
+
+DEFINE_LOG_CATEGORY(LogFPSMovement);
+
+namespace FPSMovementFrameStats
+{
+#if FPS_MOVEMENT_FRAME_STATS
+    uint64 MovementCycles = 0;
+    uint32 PhysicsQueries = 0;
+#endif
+
+    float Percentile(TArray<float> Values, float Fraction)
+    {
+        if (Values.IsEmpty())
+        {
+            return 0.f;
+        }
+        Values.Sort();
+        const int32 Index = FMath::Clamp(FMath::CeilToInt(Fraction * Values.Num()) - 1, 0, Values.Num() - 1);
+        return Values[Index];
+    }
+} // namespace FPSMovementFrameStats
+
+#if !UE_BUILD_SHIPPING
+namespace
+{
+    int32 GFPSMovementDebug = 0;
+    FAutoConsoleVariableRef CVarFPSMovementDebug(TEXT("fps.Movement.Debug"), GFPSMovementDebug,
+                                                 TEXT("Logs movement debug messages and shows them on screen.\n"
+                                                      "0: off (default), 1: on"),
+                                                 ECVF_Cheat);
+} // namespace
+
+namespace FPSMovementDebug
+{
+    bool IsEnabled()
+    {
+        return GFPSMovementDebug != 0;
+    }
+
+    void ShowMessage(int32 Key, const FColor &Color, const FString &Message)
+    {
+        UE_LOG(LogFPSMovement, Log, TEXT("%s"), *Message);
+        if (GEngine)
+        {
+            GEngine->AddOnScreenDebugMessage(Key, 5.f, Color, Message);
+        }
+    }
+} // namespace FPSMovementDebug
+#endif
@@ -0,0 +1,129 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+
+// Movement instrumentation, shown with "stat FPSMovement" and in Unreal Insights
+DECLARE_STATS_GROUP(TEXT("FPS Movement"), STATGROUP_FPSMovement, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Movement Component Tick"), STAT_FPSMovementTick, STATGROUP_FPSMovement, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Character Tick"), STAT_FPSCharacterTick, STATGROUP_FPSMovement, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Hit Handling"), STAT_FPSHitHandling, STATGROUP_FPSMovement, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Wall Contact Probe"), STAT_FPSWallContactProbe, STATGROUP_FPSMovement, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Slide"), STAT_FPSSlide, STATGROUP_FPSMovement, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Wall Run"), STAT_FPSWallRun, STATGROUP_FPSMovement, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Mantle"), STAT_FPSMantle, STATGROUP_FPSMovement, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Ledge Probes"), STAT_FPSLedgeProbes, STATGROUP_FPSMovement, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Crouch"), STAT_FPSCrouch, STATGROUP_FPSMovement, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Camera Effects"), STAT_FPSCameraEffects, STATGROUP_FPSMovement, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Batch Movement"), STAT_FPSBatchMovement, STATGROUP_FPSMovement, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Move Validation"), STAT_FPSMoveValidation, STATGROUP_FPSMovement, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Movement LOD"), STAT_FPSMovementLOD, STATGROUP_FPSMovement, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Traversal Path Search"), STAT_FPSTraversalPath, STATGROUP_FPSMovement, );
+
+// Per frame counters, reset every frame
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Hits"), STAT_FPSHits, STATGROUP_FPSMovement, );
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Wall Probes"), STAT_FPSWallProbes, STATGROUP_FPSMovement, );
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Physics Queries"), STAT_FPSPhysicsQueries, STATGROUP_FPSMovement, );
+// Async traces, run off the game thread and not counted as physics queries
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Ledge Probe Queries"), STAT_FPSLedgeProbeQueries, STATGROUP_FPSMovement, );
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("State Transitions"), STAT_FPSStateTransitions, STATGROUP_FPSMovement, );
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Transform Writes"), STAT_FPSTransformWrites, STATGROUP_FPSMovement, );
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Move Violations"), STAT_FPSMoveViolations, STATGROUP_FPSMovement, );
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Telemetry Records"), STAT_FPSTelemetryRecords, STATGROUP_FPSMovement, );
+
+// Characters in each movement level of detail, kept until the next ranking
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Characters at Full LOD"), STAT_FPSCharactersFullLOD,
+                                      STATGROUP_FPSMovement, );
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Characters at Reduced LOD"), STAT_FPSCharactersReducedLOD,
+                                      STATGROUP_FPSMovement, );
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Characters at Minimal LOD"), STAT_FPSCharactersMinimalLOD,
+                                      STATGROUP_FPSMovement, );
+
+DECLARE_LOG_CATEGORY_EXTERN(LogFPSMovement, Log, All);
+
+// Times a scope as a stat and as an Insights CPU event
+#define FPS_MOVEMENT_SCOPE(Stat)                                                                                        \
+    SCOPE_CYCLE_COUNTER(Stat);                                                                                         \
+    TRACE_CPUPROFILER_EVENT_SCOPE(Stat)
+
+// Frame totals are kept outside shipping builds, define FPS_MOVEMENT_FRAME_STATS to 1 to keep them there too
+#ifndef FPS_MOVEMENT_FRAME_STATS
+#define FPS_MOVEMENT_FRAME_STATS !UE_BUILD_SHIPPING
+#endif
+
+// Game thread totals since startup, sampled every frame by the movement perf capture
+namespace FPSMovementFrameStats
+{
+#if FPS_MOVEMENT_FRAME_STATS
+    // Cycles spent in movement component ticks, character ticks and the batch movement tick
+    extern uint64 MovementCycles;
+    // Sweeps issued by movement, counting moves, floor checks and wall probes
+    extern uint32 PhysicsQueries;
+
+    // Adds the cycles spent in a scope to MovementCycles
+    struct FScopedMovementTimer
+    {
+        FScopedMovementTimer() : StartCycles(FPlatformTime::Cycles64())
+        {
+        }
+        ~FScopedMovementTimer()
+        {
+            MovementCycles += FPlatformTime::Cycles64() - StartCycles;
+        }
+        uint64 StartCycles;
+    };
+
+    inline void CountPhysicsQuery()
+    {
+        PhysicsQueries++;
+        INC_DWORD_STAT(STAT_FPSPhysicsQueries);
+    }
+#else
+    // Compiled out, the perf capture and load test read zero movement time and queries
+    constexpr uint64 MovementCycles = 0;
+    constexpr uint32 PhysicsQueries = 0;
+
+    struct FScopedMovementTimer
+    {
+        // User provided so the unused timers do not warn
+        FScopedMovementTimer()
+        {
+        }
+    };
+
+    inline void CountPhysicsQuery()
+    {
+    }
+#endif
+
+    // Value below which the given fraction of the samples lie, used by the perf capture and load test reports
+    float Percentile(TArray<float> Values, float Fraction);
+} // namespace FPSMovementFrameStats
+
+#if !UE_BUILD_SHIPPING
+namespace FPSMovementDebug
+{
+    // True when fps.Movement.Debug is set, messages are then logged and shown on screen
+    bool IsEnabled();
+    void ShowMessage(int32 Key, const FColor &Color, const FString &Message);
+} // namespace FPSMovementDebug
+
+// Logs a movement debug message when fps.Movement.Debug is set, the arguments are not evaluated otherwise
+#define FPS_MOVEMENT_DEBUG(Key, Color, Format, ...)                                                                    \
+    do                                                                                                                 \
+    {                                                                                                                  \
+        if (FPSMovementDebug::IsEnabled())                                                                             \
+        {                                                                                                              \
+            FPSMovementDebug::ShowMessage(Key, Color, FString::Printf(Format, ##__VA_ARGS__));                         \
+        }                                                                                                              \
+    } while (0)
+#else
+#define FPS_MOVEMENT_DEBUG(Key, Color, Format, ...)                                                                    \
+    do                                                                                                                 \
+    {                                                                                                                  \
+    } while (0)
+#endif
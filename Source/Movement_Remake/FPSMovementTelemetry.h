@@ -0,0 +1,135 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+// File format and recording ring of movement telemetry. Only standard headers are included so the decoder in
+// Source/Programs can read the files without the engine.
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+// A telemetry file is a header followed by fixed size records, in time order per character. The writer starts
+// a new file when one grows past its size limit, every file has its own header.
+namespace FPSMovementTelemetry
+{
+    constexpr uint32_t Magic = 0x54535046; // "FPST"
+    constexpr uint16_t Version = 1;
+
+    // Movement state transitions that are recorded
+    enum class EEvent : uint8_t
+    {
+        StartCrouch,
+        StopCrouch,
+        SlideImpulse,
+        StartWallRun,
+        StopWallRun,
+        WallJump,
+        StartMantle,
+        Land,
+        Count,
+    };
+
+    inline const char *GetEventName(EEvent Event)
+    {
+        static const char *const Names[] = {"StartCrouch", "StopCrouch", "SlideImpulse", "StartWallRun",
+                                            "StopWallRun", "WallJump",   "StartMantle",  "Land"};
+        static_assert(sizeof(Names) / sizeof(Names[0]) == std::size_t(EEvent::Count));
+        return Event < EEvent::Count ? Names[std::size_t(Event)] : "Unknown";
+    }
+
+    struct FHeader
+    {
+        uint32_t Magic;
+        uint16_t Version;
+        // Size of one record, lets readers reject files written with a different layout
+        uint16_t RecordSize;
+    };
+
+    struct FRecord
+    {
+        // Game time in seconds
+        double Time;
+        // Id the recording character was given when it started recording, logged with the character's name
+        uint32_t CharacterId;
+        EEvent Event;
+        // EMovementMode and EFPSCustomMovementMode after the transition
+        uint8_t MovementMode;
+        uint8_t CustomMovementMode;
+        uint8_t Padding;
+        float Velocity[3];
+        // Normal of the floor the character stands on, zero when it is not on a floor
+        float FloorNormal[3];
+    };
+
+    static_assert(std::is_trivially_copyable_v<FHeader> && sizeof(FHeader) == 8);
+    static_assert(std::is_trivially_copyable_v<FRecord> && sizeof(FRecord) == 40);
+
+    // Fixed size queue for exactly one producer thread and one consumer thread. Neither side locks or
+    // allocates, the producer drops items when the consumer has fallen a whole ring behind.
+    template <typename T, uint32_t Capacity> class TSpscRing
+    {
+        static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+        static_assert(std::is_trivially_copyable_v<T>);
+
+    public:
+        // Producer only. Returns false when the ring is full and the item was dropped.
+        bool Push(const T &Item)
+        {
+            const uint32_t Write = WriteIndex.load(std::memory_order_relaxed);
+            // The consumer's index is only read again when the ring looks full from the last time it was read
+            if (Write - CachedReadIndex >= Capacity)
+            {
+                CachedReadIndex = ReadIndex.load(std::memory_order_acquire);
+                if (Write - CachedReadIndex >= Capacity)
+                {
+                    return false;
+                }
+            }
+            Items[Write & (Capacity - 1)] = Item;
+            WriteIndex.store(Write + 1, std::memory_order_release);
+            return true;
+        }
+
+        // Consumer only. Moves up to MaxItems into Out, returns the number moved.
+        uint32_t Pop(T *Out, uint32_t MaxItems)
+        {
+            const uint32_t Read = ReadIndex.load(std::memory_order_relaxed);
+            const uint32_t Available = WriteIndex.load(std::memory_order_acquire) - Read;
+            const uint32_t Count = Available < MaxItems ? Available : MaxItems;
+            for (uint32_t Index = 0; Index < Count; Index++)
+            {
+                Out[Index] = Items[(Read + Index) & (Capacity - 1)];
+            }
+            ReadIndex.store(Read + Count, std::memory_order_release);
+            return Count;
+        }
+
+        // Either side, exact only when the other side is idle
+        bool IsEmpty() const
+        {
+            return WriteIndex.load(std::memory_order_acquire) == ReadIndex.load(std::memory_order_acquire);
+        }
+
+    private:
+        // Each side's index sits on its own cache line so pushing and popping do not contend
+        alignas(64) std::atomic<uint32_t> WriteIndex{0};
+        uint32_t CachedReadIndex = 0;
+        alignas(64) std::atomic<uint32_t> ReadIndex{0};
+        alignas(64) T Items[Capacity];
+    };
+
+    // Records buffered per character, far more transitions than a character makes between two drains
+    constexpr uint32_t RingCapacity = 256;
+
+    // One character's recording, written by the game thread and drained by the writer thread
+    struct FChannel
+    {
+        TSpscRing<FRecord, RingCapacity> Ring;
+        uint32_t CharacterId = 0;
+        // Records the producer could not push
+        std::atomic<uint32_t> NumDropped{0};
+        // Set by the producer when it stops recording, the writer drains what is left and lets go
+        std::atomic<bool> bClosed{false};
+    };
+} // namespace FPSMovementTelemetry
@@ -0,0 +1,201 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "FPSMovementTelemetrySubsystem.h"
+#include "FPSMovementStats.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformFileManager.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/RunnableThread.h"
+#include "Misc/CommandLine.h"
+#include "Misc/DateTime.h"
+#include "Misc/Parse.h"
+#include "Misc/Paths.h"
+
+namespace
+{
+    int32 TelemetryEnabled = 0;
+    FAutoConsoleVariableRef CVarTelemetryEnabled(
+        TEXT("fps.Movement.Telemetry.Enabled"), TelemetryEnabled,
+        TEXT("Records movement state transitions to Saved/Telemetry, characters spawned after a change follow it"));
+
+    int32 TelemetryMaxFileMB = 64;
+    FAutoConsoleVariableRef CVarTelemetryMaxFileMB(TEXT("fps.Movement.Telemetry.MaxFileMB"), TelemetryMaxFileMB,
+                                                   TEXT("Size in MB a telemetry file grows to before the next one "
+                                                        "is started"));
+
+    int32 TelemetryMaxFiles = 8;
+    FAutoConsoleVariableRef CVarTelemetryMaxFiles(TEXT("fps.Movement.Telemetry.MaxFiles"), TelemetryMaxFiles,
+                                                  TEXT("Telemetry files kept per session, older ones are deleted"));
+
+    // Milliseconds the writer sleeps between drains, rings hold a few seconds of records
+    constexpr uint32 DrainIntervalMs = 100;
+    // Records moved out of a ring at a time
+    constexpr int32 DrainBatchSize = 256;
+} // namespace
+
+FFPSMovementTelemetryWriter::FFPSMovementTelemetryWriter(const FString &InBasePath, int64 InMaxFileSize,
+                                                         int32 InMaxFiles)
+    : BasePath(InBasePath), MaxFileSize(InMaxFileSize), MaxFiles(InMaxFiles)
+{
+    Records.SetNumUninitialized(DrainBatchSize);
+    WakeEvent = FPlatformProcess::GetSynchEventFromPool();
+    FPlatformFileManager::Get().GetPlatformFile().CreateDirectoryTree(*FPaths::GetPath(BasePath));
+    OpenNextFile();
+    Thread = FRunnableThread::Create(this, TEXT("FPSMovementTelemetry"), 0, TPri_BelowNormal);
+}
+
+FFPSMovementTelemetryWriter::~FFPSMovementTelemetryWriter()
+{
+    if (Thread)
+    {
+        Stop();
+        Thread->WaitForCompletion();
+        delete Thread;
+    }
+    FPlatformProcess::ReturnSynchEventToPool(WakeEvent);
+    File.Reset();
+    UE_LOG(LogFPSMovement, Display, TEXT("Wrote %llu movement telemetry records to %s-*, dropped %llu"),
+           NumWritten, *BasePath, NumDropped);
+}
+
+void FFPSMovementTelemetryWriter::AddChannel(const FFPSMovementTelemetryChannelRef &Channel)
+{
+    FScopeLock Lock(&ChannelsLock);
+    Channels.Add(Channel);
+}
+
+uint32 FFPSMovementTelemetryWriter::Run()
+{
+    while (!bStopping.load(std::memory_order_relaxed))
+    {
+        WakeEvent->Wait(DrainIntervalMs);
+        Drain();
+    }
+    // Picks up what was recorded while stopping
+    Drain();
+    return 0;
+}
+
+void FFPSMovementTelemetryWriter::Stop()
+{
+    bStopping.store(true, std::memory_order_relaxed);
+    WakeEvent->Trigger();
+}
+
+// Moves everything recorded so far into the file and lets go of closed channels
+void FFPSMovementTelemetryWriter::Drain()
+{
+    {
+        FScopeLock Lock(&ChannelsLock);
+        DrainChannels = Channels;
+    }
+    bool bReleasedChannel = false;
+    for (const FFPSMovementTelemetryChannelRef &Channel : DrainChannels)
+    {
+        // Read before draining, a channel closed after this still gets its last records drained next time
+        const bool bClosed = Channel->bClosed.load(std::memory_order_acquire);
+        while (const uint32 NumRecords = Channel->Ring.Pop(Records.GetData(), DrainBatchSize))
+        {
+            Write(Records.GetData(), int32(NumRecords));
+        }
+        NumDropped += Channel->NumDropped.exchange(0, std::memory_order_relaxed);
+        bReleasedChannel |= bClosed;
+    }
+    if (bReleasedChannel)
+    {
+        FScopeLock Lock(&ChannelsLock);
+        Channels.RemoveAll([](const FFPSMovementTelemetryChannelRef &Channel)
+                           { return Channel->bClosed.load(std::memory_order_acquire) && Channel->Ring.IsEmpty(); });
+    }
+    DrainChannels.Reset();
+    if (File)
+    {
+        File->Flush();
+    }
+}
+
+void FFPSMovementTelemetryWriter::Write(const FPSMovementTelemetry::FRecord *InRecords, int32 NumRecords)
+{
+    const int64 Size = int64(NumRecords) * sizeof(FPSMovementTelemetry::FRecord);
+    if (File && FileSize + Size > MaxFileSize)
+    {
+        OpenNextFile();
+    }
+    if (File && File->Write(reinterpret_cast<const uint8 *>(InRecords), Size))
+    {
+        FileSize += Size;
+        NumWritten += NumRecords;
+    }
+    else
+    {
+        NumDropped += NumRecords;
+    }
+}
+
+// Closes the current file and starts the next part, deleting the part that falls out of MaxFiles
+void FFPSMovementTelemetryWriter::OpenNextFile()
+{
+    IPlatformFile &PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+    File.Reset();
+    if (NumParts >= MaxFiles)
+    {
+        PlatformFile.DeleteFile(*GetPartPath(NumParts - MaxFiles));
+    }
+    const FString Path = GetPartPath(NumParts++);
+    File.Reset(PlatformFile.OpenWrite(*Path));
+    if (!File)
+    {
+        UE_LOG(LogFPSMovement, Error, TEXT("Could not open movement telemetry file %s"), *Path);
+        return;
+    }
+    const FPSMovementTelemetry::FHeader Header = {FPSMovementTelemetry::Magic, FPSMovementTelemetry::Version,
+                                                  uint16(sizeof(FPSMovementTelemetry::FRecord))};
+    File->Write(reinterpret_cast<const uint8 *>(&Header), sizeof(Header));
+    FileSize = sizeof(Header);
+}
+
+FString FFPSMovementTelemetryWriter::GetPartPath(int32 Part) const
+{
+    return FString::Printf(TEXT("%s-%03d.fpstelemetry"), *BasePath, Part);
+}
+
+void UFPSMovementTelemetrySubsystem::Deinitialize()
+{
+    Writer.Reset();
+    Super::Deinitialize();
+}
+
+bool UFPSMovementTelemetrySubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+    return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+// Starts recording a character, null when telemetry is off
+FFPSMovementTelemetryChannelPtr UFPSMovementTelemetrySubsystem::OpenChannel(const FString &OwnerName)
+{
+    if (!Writer)
+    {
+        static const bool bTelemetryParam = FParse::Param(FCommandLine::Get(), TEXT("MovementTelemetry"));
+        if ((TelemetryEnabled == 0 && !bTelemetryParam) || !FPlatformProcess::SupportsMultithreading())
+        {
+            return nullptr;
+        }
+        const UWorld *World = GetWorld();
+        const TCHAR *NetModeName = World->GetNetMode() == NM_Client
+                                       ? TEXT("Client")
+                                       : (World->GetNetMode() == NM_Standalone ? TEXT("Standalone") : TEXT("Server"));
+        const FString BasePath =
+            FPaths::ProjectSavedDir() / TEXT("Telemetry") /
+            FString::Printf(TEXT("%s-%s-%s"), *UWorld::RemovePIEPrefix(World->GetMapName()), NetModeName,
+                            *FDateTime::Now().ToString());
+        Writer = MakeUnique<FFPSMovementTelemetryWriter>(BasePath, int64(FMath::Max(TelemetryMaxFileMB, 1)) << 20,
+                                                         FMath::Max(TelemetryMaxFiles, 1));
+        UE_LOG(LogFPSMovement, Display, TEXT("Recording movement telemetry to %s-*"), *BasePath);
+    }
+    FFPSMovementTelemetryChannelRef Channel = MakeShared<FPSMovementTelemetry::FChannel, ESPMode::ThreadSafe>();
+    Channel->CharacterId = NextCharacterId++;
+    Writer->AddChannel(Channel);
+    UE_LOG(LogFPSMovement, Log, TEXT("Movement telemetry id %u is %s"), Channel->CharacterId, *OwnerName);
+    return Channel;
+}
@@ -0,0 +1,85 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/Runnable.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "FPSMovementTelemetry.h"
+#include <atomic>
+#include "FPSMovementTelemetrySubsystem.generated.h"
+
+class FRunnableThread;
+class IFileHandle;
+
+using FFPSMovementTelemetryChannelRef = TSharedRef<FPSMovementTelemetry::FChannel, ESPMode::ThreadSafe>;
+using FFPSMovementTelemetryChannelPtr = TSharedPtr<FPSMovementTelemetry::FChannel, ESPMode::ThreadSafe>;
+
+/** Drains telemetry channels on its own thread into files that rotate once they reach a size limit. */
+class FFPSMovementTelemetryWriter : public FRunnable
+{
+public:
+    // Starts the thread, files are named <BasePath>-<Part>.fpstelemetry and at most MaxFiles are kept
+    FFPSMovementTelemetryWriter(const FString &InBasePath, int64 InMaxFileSize, int32 InMaxFiles);
+    // Drains what is left, then stops the thread and closes the file
+    virtual ~FFPSMovementTelemetryWriter() override;
+
+    void AddChannel(const FFPSMovementTelemetryChannelRef &Channel);
+
+    virtual uint32 Run() override;
+    virtual void Stop() override;
+
+private:
+    // Moves everything recorded so far into the file and lets go of closed channels
+    void Drain();
+    void Write(const FPSMovementTelemetry::FRecord *InRecords, int32 NumRecords);
+    // Closes the current file and starts the next part, deleting the part that falls out of MaxFiles
+    void OpenNextFile();
+    FString GetPartPath(int32 Part) const;
+
+    FString BasePath;
+    int64 MaxFileSize;
+    int32 MaxFiles;
+    int32 NumParts = 0;
+    TUniquePtr<IFileHandle> File;
+    int64 FileSize = 0;
+
+    // Channels added by the game thread, copied by the writer thread before each drain
+    FCriticalSection ChannelsLock;
+    TArray<FFPSMovementTelemetryChannelRef> Channels;
+    // Writer thread only
+    TArray<FFPSMovementTelemetryChannelRef> DrainChannels;
+    TArray<FPSMovementTelemetry::FRecord> Records;
+    uint64 NumWritten = 0;
+    uint64 NumDropped = 0;
+
+    std::atomic<bool> bStopping{false};
+    FEvent *WakeEvent = nullptr;
+    FRunnableThread *Thread = nullptr;
+};
+
+/**
+ * Records movement state transitions of every character to Saved/Telemetry when fps.Movement.Telemetry.Enabled
+ * is set or the game runs with -MovementTelemetry.
+ * Characters push fixed size records into their own lock free ring and never wait on the file, a writer thread
+ * drains the rings. Convert the files to CSV with Source/Programs/MovementTelemetryDecoder.
+ */
+UCLASS()
+class MOVEMENT_REMAKE_API UFPSMovementTelemetrySubsystem : public UWorldSubsystem
+{
+    GENERATED_BODY()
+
+public:
+    virtual void Deinitialize() override;
+
+    // Starts recording a character, null when telemetry is off. Close the channel when the character stops.
+    FFPSMovementTelemetryChannelPtr OpenChannel(const FString &OwnerName);
+
+protected:
+    virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+    // Started with the first channel
+    TUniquePtr<FFPSMovementTelemetryWriter> Writer;
+    uint32 NextCharacterId = 1;
+};
@@ -0,0 +1,460 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+// Predicts where a character will be during a fall, wall jump, wall run or slide without stepping the movement
+// component, for bots and aim assist. Built on the movement kernel and the same tuning values, only standard
+// headers may be included.
+#include "FPSMovementKernel.h"
+
+#include <cmath>
+#include <cstdint>
+#include <type_traits>
+
+// Arcs assume nothing is in the way: wall runs keep their wall and slides keep their floor plane. Input held
+// during a fall or wall run is ignored, air control barely changes those arcs.
+namespace FPSMovementTrajectory
+{
+    using FPSMovementKernel::FVec3;
+
+    enum class EArcType : uint8_t
+    {
+        // Constant acceleration, falls, jumps and wall runs
+        Ballistic,
+        // Horizontal movement along a floor plane, slowed by braking and pulled down the slope
+        Slide,
+    };
+
+    struct FArc
+    {
+        FVec3 Start;
+        FVec3 Velocity;
+        // Gravity for falls, gravity and the wall forces along the wall for wall runs, the slope pull for slides
+        FVec3 Acceleration;
+        EArcType Type;
+        // Slides only. Braking slows the slide down to MinSpeed, which is the crouch speed while input is held.
+        FVec3 FloorNormal;
+        float Friction;
+        float BrakingDeceleration;
+        float MinSpeed;
+    };
+
+    struct FArcPoint
+    {
+        FVec3 Position;
+        FVec3 Velocity;
+    };
+
+    struct FArcSummary
+    {
+        // Highest point and when it is reached, slides report their start
+        FVec3 Apex;
+        float ApexTime;
+        // Where a ballistic arc comes down through the landing height or where a slide comes to rest, the point at
+        // the time limit when neither happens before it
+        FVec3 End;
+        float EndTime;
+        bool bEnds;
+    };
+
+    static_assert(std::is_trivial_v<FArc> && std::is_trivial_v<FArcPoint> && std::is_trivial_v<FArcSummary>);
+
+    // Step of the integrator used for slides on slopes, the only arcs without a closed form. The slide physics
+    // steps once per frame the same way, so this predicts a 60 Hz game.
+    constexpr float SlopeSlideStep = 1.f / 60.f;
+
+    // Arc of a character falling freely
+    inline FArc MakeFallArc(const FVec3 &Location, const FVec3 &Velocity, float GravityZ)
+    {
+        FArc Arc = {};
+        Arc.Start = Location;
+        Arc.Velocity = Velocity;
+        Arc.Acceleration = {0.f, 0.f, GravityZ};
+        Arc.Type = EArcType::Ballistic;
+        return Arc;
+    }
+
+    // Arc after jumping off the wall the state is running along
+    inline FArc MakeWallJumpArc(const FPSMovementKernel::FMovementState &State,
+                                const FPSMovementKernel::FMovementParams &Params, const FVec3 &Location,
+                                float GravityZ)
+    {
+        FPSMovementKernel::FMovementState JumpState = State;
+        return MakeFallArc(Location, FPSMovementKernel::WallJump(JumpState, Params), GravityZ);
+    }
+
+    // Arc along the wall the state is touching, with the entry boost when the wall run has not started yet
+    inline FArc MakeWallRunArc(const FPSMovementKernel::FMovementState &State,
+                               const FPSMovementKernel::FMovementParams &Params, const FVec3 &Location,
+                               float GravityZ)
+    {
+        FVec3 Velocity = State.Velocity;
+        if (!State.bIsWallrunning)
+        {
+            Velocity.Z = Params.WallRunEntrySpeed;
+        }
+        const FVec3 Gravity = {0.f, 0.f, GravityZ};
+        const FVec3 Acceleration =
+            Gravity + FPSMovementKernel::WallRunAcceleration(State, Params, FPSMovementKernel::GetSafeNormal(Gravity));
+        // The wall takes out everything pointing into it, including the force that keeps the player on it
+        FArc Arc = MakeFallArc(Location, FPSMovementKernel::VectorPlaneProject(Velocity, State.WallNormal), GravityZ);
+        Arc.Acceleration = FPSMovementKernel::VectorPlaneProject(Acceleration, State.WallNormal);
+        return Arc;
+    }
+
+    // Arc of a slide along the floor, with the slide impulse when it has not been applied yet. BrakingDeceleration
+    // is the movement component's walking braking deceleration.
+    inline FArc MakeSlideArc(const FPSMovementKernel::FMovementState &State,
+                             const FPSMovementKernel::FMovementParams &Params, const FVec3 &Location,
+                             const FVec3 &FloorNormal, float BrakingDeceleration, bool bHoldingInput)
+    {
+        FPSMovementKernel::FMovementState SlideState = State;
+        FPSMovementKernel::TryApplySlideImpulse(SlideState, Params);
+        // Slides keep their velocity horizontal and follow the floor height, like walking
+        FVec3 SlopePull = FPSMovementKernel::SlopeSlideAcceleration(FloorNormal, Params);
+        SlopePull.Z = 0.f;
+        FArc Arc = {};
+        Arc.Start = Location;
+        Arc.Velocity = {SlideState.Velocity.X, SlideState.Velocity.Y, 0.f};
+        Arc.Acceleration = SlopePull;
+        Arc.Type = EArcType::Slide;
+        Arc.FloorNormal = FloorNormal;
+        Arc.Friction = Params.SlideFriction * Params.SlideBrakingFrictionFactor;
+        Arc.BrakingDeceleration = BrakingDeceleration;
+        // Held input stops braking once the slide is down to the crouch speed
+        Arc.MinSpeed = bHoldingInput ? Params.CrouchSpeed : 0.f;
+        return Arc;
+    }
+
+    // Arc of walking along the floor without turning. Friction and BrakingDeceleration are the movement
+    // component's walking braking values, and held input keeps the speed up at MaxSpeed.
+    inline FArc MakeWalkArc(const FVec3 &Location, const FVec3 &Velocity, const FVec3 &FloorNormal, float Friction,
+                            float BrakingDeceleration, float MaxSpeed, bool bHoldingInput)
+    {
+        FArc Arc = {};
+        Arc.Start = Location;
+        Arc.Velocity = {Velocity.X, Velocity.Y, 0.f};
+        Arc.Type = EArcType::Slide;
+        Arc.FloorNormal = FloorNormal;
+        Arc.Friction = Friction;
+        Arc.BrakingDeceleration = BrakingDeceleration;
+        Arc.MinSpeed = bHoldingInput ? MaxSpeed : 0.f;
+        return Arc;
+    }
+
+    // Height change on the floor plane for a horizontal move
+    inline float FloorDeltaZ(const FVec3 &FloorNormal, const FVec3 &Delta)
+    {
+        return FloorNormal.Z > 1.e-4f ? -(FloorNormal.X * Delta.X + FloorNormal.Y * Delta.Y) / FloorNormal.Z : 0.f;
+    }
+
+    // Time a flat slide brakes for before reaching its minimum speed, infinite when it never does
+    inline float GetSlideBrakingTime(const FArc &Arc, float Speed)
+    {
+        if (Speed <= Arc.MinSpeed)
+        {
+            return 0.f;
+        }
+        if (Arc.Friction > 0.f)
+        {
+            const float Ratio = Arc.BrakingDeceleration / Arc.Friction;
+            return Arc.MinSpeed + Ratio > 0.f ? std::log((Speed + Ratio) / (Arc.MinSpeed + Ratio)) / Arc.Friction
+                                              : INFINITY;
+        }
+        return Arc.BrakingDeceleration > 0.f ? (Speed - Arc.MinSpeed) / Arc.BrakingDeceleration : INFINITY;
+    }
+
+    // Flat slide in closed form. Speed follows dv/dt = -Friction * v - BrakingDeceleration along a fixed direction.
+    inline FArcPoint EvaluateFlatSlide(const FArc &Arc, float Time)
+    {
+        const float Speed = std::sqrt(FPSMovementKernel::SizeSquared(Arc.Velocity));
+        if (Speed < 1.e-4f)
+        {
+            return {Arc.Start, {0.f, 0.f, 0.f}};
+        }
+        const FVec3 Direction = Arc.Velocity * (1.f / Speed);
+        const float BrakingTime = std::fmin(GetSlideBrakingTime(Arc, Speed), Time);
+        float Distance;
+        float NewSpeed;
+        if (Arc.Friction > 0.f)
+        {
+            const float Ratio = Arc.BrakingDeceleration / Arc.Friction;
+            const float Decay = std::exp(-Arc.Friction * BrakingTime);
+            Distance = (Speed + Ratio) * (1.f - Decay) / Arc.Friction - Ratio * BrakingTime;
+            NewSpeed = (Speed + Ratio) * Decay - Ratio;
+        }
+        else
+        {
+            Distance = Speed * BrakingTime - .5f * Arc.BrakingDeceleration * BrakingTime * BrakingTime;
+            NewSpeed = Speed - Arc.BrakingDeceleration * BrakingTime;
+        }
+        // Carries on at the minimum speed once braking has brought it there
+        if (Speed > Arc.MinSpeed)
+        {
+            NewSpeed = std::fmax(NewSpeed, Arc.MinSpeed);
+        }
+        Distance += NewSpeed * (Time - BrakingTime);
+        FVec3 Delta = Direction * Distance;
+        Delta.Z = FloorDeltaZ(Arc.FloorNormal, Delta);
+        return {Arc.Start + Delta, Direction * NewSpeed};
+    }
+
+    // Slides on slopes stepped together, one per lane. The lanes are stored as arrays of floats so each step
+    // vectorizes across them. Slides stay horizontal, so only X and Y are stepped.
+    template <int NumLanes> struct TSlopeSlideLanes
+    {
+        float DeltaX[NumLanes];
+        float DeltaY[NumLanes];
+        float VelocityX[NumLanes];
+        float VelocityY[NumLanes];
+        float AccelerationX[NumLanes];
+        float AccelerationY[NumLanes];
+        float Friction[NumLanes];
+        float BrakingDeceleration[NumLanes];
+        float MinSpeed[NumLanes];
+        // Seconds still to step, and seconds stepped
+        float TimeLeft[NumLanes];
+        float Elapsed[NumLanes];
+        // One for slides that can come to rest, they stop stepping once at rest. Floats keep the lanes vectorized.
+        float CanStop[NumLanes];
+        float AtRest[NumLanes];
+
+        void SetLane(int Lane, const FArc &Arc, float Time)
+        {
+            DeltaX[Lane] = 0.f;
+            DeltaY[Lane] = 0.f;
+            VelocityX[Lane] = Arc.Velocity.X;
+            VelocityY[Lane] = Arc.Velocity.Y;
+            AccelerationX[Lane] = Arc.Acceleration.X;
+            AccelerationY[Lane] = Arc.Acceleration.Y;
+            Friction[Lane] = Arc.Friction;
+            BrakingDeceleration[Lane] = Arc.BrakingDeceleration;
+            MinSpeed[Lane] = Arc.MinSpeed;
+            TimeLeft[Lane] = Time;
+            Elapsed[Lane] = 0.f;
+            AtRest[Lane] = 0.f;
+            // Without held input a slope that pulls less than braking holds the slide once it stops
+            CanStop[Lane] = Arc.MinSpeed <= 0.f && FPSMovementKernel::SizeSquared(Arc.Acceleration) <=
+                                                           Arc.BrakingDeceleration * Arc.BrakingDeceleration
+                                ? 1.f
+                                : 0.f;
+        }
+
+        // Steps every lane until its time runs out, in the same order as the slide physics
+        void Run()
+        {
+            float MaxTime = 0.f;
+            for (int Lane = 0; Lane < NumLanes; Lane++)
+            {
+                MaxTime = std::fmax(MaxTime, TimeLeft[Lane]);
+            }
+            const int NumSteps = int(std::ceil(MaxTime / SlopeSlideStep));
+            for (int Step = 0; Step < NumSteps; Step++)
+            {
+                for (int Lane = 0; Lane < NumLanes; Lane++)
+                {
+                    // Plain comparisons instead of fmin and fmax, they compile to vector min and max
+                    const float TimeLeftInLane = TimeLeft[Lane] > 0.f ? TimeLeft[Lane] : 0.f;
+                    const float DeltaTime = TimeLeftInLane < SlopeSlideStep ? TimeLeftInLane : SlopeSlideStep;
+                    const float VelX = VelocityX[Lane] + AccelerationX[Lane] * DeltaTime;
+                    const float VelY = VelocityY[Lane] + AccelerationY[Lane] * DeltaTime;
+                    const float Speed = std::sqrt(VelX * VelX + VelY * VelY);
+                    // Braking only applies above the minimum speed and does not take the slide below it
+                    const float Braking = Friction[Lane] * Speed + BrakingDeceleration[Lane];
+                    const float BrakedSpeed = Speed - Braking * DeltaTime;
+                    const float NewSpeed = BrakedSpeed > MinSpeed[Lane] ? BrakedSpeed : MinSpeed[Lane];
+                    const float SpeedRatio = NewSpeed / (Speed + 1.e-6f);
+                    const float Scale = Speed > MinSpeed[Lane] ? SpeedRatio : 1.f;
+                    VelocityX[Lane] = VelX * Scale;
+                    VelocityY[Lane] = VelY * Scale;
+                    DeltaX[Lane] += VelocityX[Lane] * DeltaTime;
+                    DeltaY[Lane] += VelocityY[Lane] * DeltaTime;
+                    Elapsed[Lane] += DeltaTime;
+                    const float Stepped = DeltaTime > 0.f ? CanStop[Lane] : 0.f;
+                    const float Stopped = NewSpeed > 0.f ? 0.f : Stepped;
+                    AtRest[Lane] = AtRest[Lane] > Stopped ? AtRest[Lane] : Stopped;
+                    TimeLeft[Lane] = AtRest[Lane] > 0.f ? 0.f : TimeLeft[Lane] - DeltaTime;
+                }
+            }
+        }
+
+        FArcPoint GetPoint(int Lane, const FArc &Arc) const
+        {
+            FVec3 Delta = {DeltaX[Lane], DeltaY[Lane], 0.f};
+            Delta.Z = FloorDeltaZ(Arc.FloorNormal, Delta);
+            FVec3 Velocity = {VelocityX[Lane], VelocityY[Lane], 0.f};
+            Velocity.Z = FloorDeltaZ(Arc.FloorNormal, Velocity);
+            return {Arc.Start + Delta, Velocity};
+        }
+    };
+
+    // Lanes stepped together by the batch queries, eight floats fill a 256 bit register
+    constexpr int SlopeSlideBatchLanes = 8;
+
+    inline bool IsSlopeSlide(const FArc &Arc)
+    {
+        return Arc.Type == EArcType::Slide && FPSMovementKernel::SizeSquared(Arc.Acceleration) > 0.f;
+    }
+
+    // Position and velocity Time seconds along the arc. Slides on slopes are stepped at SlopeSlideStep, batches
+    // of them are cheaper through EvaluateBatch.
+    inline FArcPoint Evaluate(const FArc &Arc, float Time)
+    {
+        if (Arc.Type == EArcType::Ballistic)
+        {
+            return {Arc.Start + Arc.Velocity * Time + Arc.Acceleration * (.5f * Time * Time),
+                    Arc.Velocity + Arc.Acceleration * Time};
+        }
+        if (IsSlopeSlide(Arc))
+        {
+            TSlopeSlideLanes<1> Lanes;
+            Lanes.SetLane(0, Arc, Time);
+            Lanes.Run();
+            return Lanes.GetPoint(0, Arc);
+        }
+        return EvaluateFlatSlide(Arc, Time);
+    }
+
+    // Apex and end of an arc, slides on slopes excluded. Sets the end from the landing or stop time.
+    inline FArcSummary SummarizeClosedForm(const FArc &Arc, float LandingZ, float MaxTime)
+    {
+        FArcSummary Summary = {};
+        Summary.Apex = Arc.Start;
+        if (Arc.Type == EArcType::Ballistic)
+        {
+            // Rises until the vertical velocity runs out
+            const float Rise = Arc.Velocity.Z;
+            const float AccelerationZ = Arc.Acceleration.Z;
+            if (Rise > 0.f)
+            {
+                Summary.ApexTime = AccelerationZ < 0.f ? std::fmin(-Rise / AccelerationZ, MaxTime) : MaxTime;
+                Summary.Apex = Evaluate(Arc, Summary.ApexTime).Position;
+            }
+            // Solves Start.Z + Rise * t + AccelerationZ / 2 * t^2 = LandingZ for the crossing on the way down
+            const float Height = Arc.Start.Z - LandingZ;
+            float LandingTime = -1.f;
+            if (AccelerationZ != 0.f)
+            {
+                // The root where the vertical velocity is -sqrt(Discriminant), the downwards crossing
+                const float Discriminant = Rise * Rise - 2.f * AccelerationZ * Height;
+                if (Discriminant >= 0.f)
+                {
+                    LandingTime = (-Rise - std::sqrt(Discriminant)) / AccelerationZ;
+                }
+            }
+            else if (Rise < 0.f && Height >= 0.f)
+            {
+                LandingTime = -Height / Rise;
+            }
+            Summary.bEnds = LandingTime >= 0.f && LandingTime <= MaxTime;
+            Summary.EndTime = Summary.bEnds ? LandingTime : MaxTime;
+        }
+        else
+        {
+            // Flat slides without held input brake to a stop
+            const float Speed = std::sqrt(FPSMovementKernel::SizeSquared(Arc.Velocity));
+            const float StopTime = Arc.MinSpeed > 0.f ? INFINITY : GetSlideBrakingTime(Arc, Speed);
+            Summary.bEnds = StopTime <= MaxTime;
+            Summary.EndTime = Summary.bEnds ? StopTime : MaxTime;
+        }
+        Summary.End = Evaluate(Arc, Summary.EndTime).Position;
+        return Summary;
+    }
+
+    // Summary of a slide on a slope from its stepped lane, the slide ends when it comes to rest
+    template <int NumLanes>
+    inline FArcSummary SummarizeSlopeSlide(const TSlopeSlideLanes<NumLanes> &Lanes, int Lane, const FArc &Arc)
+    {
+        FArcSummary Summary = {};
+        Summary.Apex = Arc.Start;
+        Summary.End = Lanes.GetPoint(Lane, Arc).Position;
+        Summary.EndTime = Lanes.Elapsed[Lane];
+        Summary.bEnds = Lanes.AtRest[Lane] > 0.f;
+        return Summary;
+    }
+
+    // Apex and end of the arc, looking at most MaxTime seconds ahead. Ballistic arcs end where they come down
+    // through LandingZ, slides where they come to rest.
+    inline FArcSummary Summarize(const FArc &Arc, float LandingZ, float MaxTime)
+    {
+        if (IsSlopeSlide(Arc))
+        {
+            TSlopeSlideLanes<1> Lanes;
+            Lanes.SetLane(0, Arc, MaxTime);
+            Lanes.Run();
+            return SummarizeSlopeSlide(Lanes, 0, Arc);
+        }
+        return SummarizeClosedForm(Arc, LandingZ, MaxTime);
+    }
+
+    // Evaluates each arc at its own time. Closed forms are evaluated straight away, slides on slopes are
+    // collected and stepped SlopeSlideBatchLanes at a time.
+    inline void EvaluateBatch(const FArc *Arcs, const float *Times, FArcPoint *OutPoints, int Count)
+    {
+        TSlopeSlideLanes<SlopeSlideBatchLanes> Lanes;
+        int LaneArcs[SlopeSlideBatchLanes];
+        int NumLanes = 0;
+        for (int Index = 0; Index <= Count; Index++)
+        {
+            if (Index < Count && !IsSlopeSlide(Arcs[Index]))
+            {
+                OutPoints[Index] = Evaluate(Arcs[Index], Times[Index]);
+                continue;
+            }
+            if (Index < Count)
+            {
+                Lanes.SetLane(NumLanes, Arcs[Index], Times[Index]);
+                LaneArcs[NumLanes++] = Index;
+            }
+            // Steps when the lanes are full and for the partly filled lanes left at the end
+            if (NumLanes == SlopeSlideBatchLanes || (Index == Count && NumLanes > 0))
+            {
+                for (int Lane = NumLanes; Lane < SlopeSlideBatchLanes; Lane++)
+                {
+                    Lanes.SetLane(Lane, Arcs[LaneArcs[0]], 0.f);
+                }
+                Lanes.Run();
+                for (int Lane = 0; Lane < NumLanes; Lane++)
+                {
+                    OutPoints[LaneArcs[Lane]] = Lanes.GetPoint(Lane, Arcs[LaneArcs[Lane]]);
+                }
+                NumLanes = 0;
+            }
+        }
+    }
+
+    // Summarizes each arc against its own landing height, slides on slopes are stepped like in EvaluateBatch
+    inline void SummarizeBatch(const FArc *Arcs, const float *LandingZ, float MaxTime, FArcSummary *OutSummaries,
+                               int Count)
+    {
+        TSlopeSlideLanes<SlopeSlideBatchLanes> Lanes;
+        int LaneArcs[SlopeSlideBatchLanes];
+        int NumLanes = 0;
+        for (int Index = 0; Index <= Count; Index++)
+        {
+            if (Index < Count && !IsSlopeSlide(Arcs[Index]))
+            {
+                OutSummaries[Index] = SummarizeClosedForm(Arcs[Index], LandingZ[Index], MaxTime);
+                continue;
+            }
+            if (Index < Count)
+            {
+                Lanes.SetLane(NumLanes, Arcs[Index], MaxTime);
+                LaneArcs[NumLanes++] = Index;
+            }
+            if (NumLanes == SlopeSlideBatchLanes || (Index == Count && NumLanes > 0))
+            {
+                for (int Lane = NumLanes; Lane < SlopeSlideBatchLanes; Lane++)
+                {
+                    Lanes.SetLane(Lane, Arcs[LaneArcs[0]], 0.f);
+                }
+                Lanes.Run();
+                for (int Lane = 0; Lane < NumLanes; Lane++)
+                {
+                    OutSummaries[LaneArcs[Lane]] = SummarizeSlopeSlide(Lanes, Lane, Arcs[LaneArcs[Lane]]);
+                }
+                NumLanes = 0;
+            }
+        }
+    }
+} // namespace FPSMovementTrajectory
@@ -0,0 +1,104 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "FPSMovementTuning.h"
+#include "FPSMovementStats.h"
+#include "HAL/IConsoleManager.h"
+#include "UObject/UObjectIterator.h"
+
+namespace
+{
+    FAutoConsoleCommand GTuningSetCommand(
+        TEXT("fps.Movement.Tuning.Set"),
+        TEXT("Changes a movement tuning value on the running game without respawning characters. "
+             "Args: <Property> <Value> [Asset], every loaded tuning and the class defaults when no asset is named"),
+        FConsoleCommandWithArgsDelegate::CreateLambda(
+            [](const TArray<FString> &Args)
+            {
+                if (Args.Num() < 2)
+                {
+                    UE_LOG(LogFPSMovement, Error, TEXT("Usage: fps.Movement.Tuning.Set <Property> <Value> [Asset]"));
+                    return;
+                }
+                int32 NumChanged = 0;
+                for (TObjectIterator<UFPSMovementTuning> It(RF_NoFlags); It; ++It)
+                {
+                    if ((Args.Num() < 3 || It->GetName() == Args[2]) && It->SetValue(Args[0], Args[1]))
+                    {
+                        NumChanged++;
+                    }
+                }
+                UE_LOG(LogFPSMovement, Display, TEXT("Set %s to %s on %d movement tunings"), *Args[0], *Args[1],
+                       NumChanged);
+            }));
+} // namespace
+
+void UFPSMovementTuning::PostInitProperties()
+{
+    Super::PostInitProperties();
+    Rebuild();
+}
+
+void UFPSMovementTuning::PostLoad()
+{
+    Super::PostLoad();
+    Rebuild();
+}
+
+#if WITH_EDITOR
+void UFPSMovementTuning::PostEditChangeProperty(FPropertyChangedEvent &PropertyChangedEvent)
+{
+    Super::PostEditChangeProperty(PropertyChangedEvent);
+    // Characters in a running play session pick the change up straight away
+    Rebuild();
+}
+#endif
+
+// Packs the values into the parameter block and notifies the characters using this tuning
+void UFPSMovementTuning::Rebuild()
+{
+    Params.WalkSpeed = WalkSpeed;
+    Params.CrouchSpeed = CrouchSpeed;
+    Params.GroundFriction = GroundFriction;
+    Params.BrakingFrictionFactor = BrakingFrictionFactor;
+    Params.SlideForce = SlideForce;
+    Params.SlideFriction = SlideFriction;
+    Params.SlideBrakingFrictionFactor = SlideBrakingFrictionFactor;
+    Params.MinSlideImpulseSpeed = MinSlideImpulseSpeed;
+    Params.SlideSlopeAcceleration = SlideSlopeAcceleration;
+    Params.WallRunCounterGravity = WallRunCounterGravity;
+    Params.WallRunSpeed = WallRunSpeed;
+    Params.WallRunEntrySpeed = WallRunEntrySpeed;
+    Params.WallJumpForce = WallJumpForce;
+    Params.JumpZVelocity = JumpZVelocity;
+    Params.WallContactProbeInterval = WallContactProbeInterval;
+    Params.WallProbeDistance = WallProbeDistance;
+    Params.MinLedgeHeight = MinLedgeHeight;
+    Params.MaxVaultHeight = MaxVaultHeight;
+    Params.MaxMantleHeight = MaxMantleHeight;
+    Params.LedgeReachDistance = LedgeReachDistance;
+    Params.VaultDuration = VaultDuration;
+    Params.MantleDuration = MantleDuration;
+    Params.Mass = Mass;
+    Params.SlideCameraTiltAngle = SlideCameraTiltAngle;
+    Params.SlideCameraTiltSpeed = SlideCameraTiltSpeed;
+    Params.CrouchTransitionSpeed = CrouchTransitionSpeed;
+    Params.WallRunTransitionSpeed = WallRunTransitionSpeed;
+    Params.WallRunCameraTiltAngle = WallRunCameraTiltAngle;
+    Params.CrouchScaleZ = CrouchScale.Z;
+    Params.NormalScaleZ = NormalScale.Z;
+    Params.bCapsuleCrouch = CrouchMode == EFPSCrouchMode::Capsule;
+    OnChanged.Broadcast(this);
+}
+
+// Sets a value by property name from text
+bool UFPSMovementTuning::SetValue(const FString &Name, const FString &Value)
+{
+    FProperty *Property = FindFProperty<FProperty>(GetClass(), *Name);
+    if (!Property || !Property->HasAnyPropertyFlags(CPF_Edit) ||
+        !Property->ImportText_InContainer(*Value, this, this, PPF_None))
+    {
+        return false;
+    }
+    Rebuild();
+    return true;
+}
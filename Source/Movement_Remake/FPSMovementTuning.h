@@ -0,0 +1,161 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "FPSMovementKernel.h"
+#include "FPSMovementTuning.generated.h"
+
+// How the character crouches
+UENUM()
+enum class EFPSCrouchMode : uint8
+{
+    // Scales the whole actor towards CrouchScale
+    ActorScale,
+    // Shrinks the capsule through the movement component and eases the camera to its new height
+    Capsule,
+};
+
+class UFPSMovementTuning;
+
+DECLARE_MULTICAST_DELEGATE_OneParam(FOnFPSMovementTuningChanged, const UFPSMovementTuning *);
+
+/**
+ * Movement tuning shared by every character that references it.
+ * The values are packed into one kernel parameter block that the movement components read in place, so a crowd
+ * of bots shares a single copy. Editing the asset, or fps.Movement.Tuning.Set on a running game, rebuilds the
+ * block and notifies the characters using it without respawning them. Characters without an asset use the
+ * class defaults.
+ */
+UCLASS(BlueprintType)
+class MOVEMENT_REMAKE_API UFPSMovementTuning : public UPrimaryDataAsset
+{
+    GENERATED_BODY()
+
+public:
+    virtual void PostInitProperties() override;
+    virtual void PostLoad() override;
+#if WITH_EDITOR
+    virtual void PostEditChangeProperty(FPropertyChangedEvent &PropertyChangedEvent) override;
+#endif
+
+    // Parameter block read by the movement kernel, lives as long as the asset
+    const FPSMovementKernel::FMovementParams &GetParams() const
+    {
+        return Params;
+    }
+    // Packs the values into the parameter block and notifies the characters using this tuning
+    void Rebuild();
+    // Sets a value by property name from text, returns false if there is no such value or the text is invalid
+    bool SetValue(const FString &Name, const FString &Value);
+
+    // Called after the values changed, characters reapply the parts the movement component keeps itself
+    FOnFPSMovementTuningChanged OnChanged;
+
+    // Crouch
+
+    // Whether crouching scales the actor or shrinks the capsule
+    UPROPERTY(EditAnywhere, Category = "Crouch")
+    EFPSCrouchMode CrouchMode = EFPSCrouchMode::Capsule;
+    // Scale when crouching
+    UPROPERTY(EditAnywhere, Category = "Crouch")
+    FVector CrouchScale = {1, 1, .5f};
+    // Scale in normal state
+    UPROPERTY(EditAnywhere, Category = "Crouch")
+    FVector NormalScale = {1, 1, 1};
+
+    // Movement Physics
+
+    // Normal Walkspeed
+    UPROPERTY(EditAnywhere, Category = "Movement")
+    float WalkSpeed = 600.f;
+    // Crouched Walkspeed
+    UPROPERTY(EditAnywhere, Category = "Movement")
+    float CrouchSpeed = 300.f;
+    // Upwards speed of a jump from the ground
+    UPROPERTY(EditAnywhere, Category = "Movement", meta = (ClampMin = "0"))
+    float JumpZVelocity = 420.f;
+    // Ground friction and braking friction factor when standing
+    UPROPERTY(EditAnywhere, Category = "Movement", meta = (ClampMin = "0"))
+    float GroundFriction = 8.f;
+    UPROPERTY(EditAnywhere, Category = "Movement", meta = (ClampMin = "0"))
+    float BrakingFrictionFactor = 2.f;
+    // Mass pushed by wall jumps
+    UPROPERTY(EditAnywhere, Category = "Movement", meta = (ClampMin = "0.01"))
+    float Mass = 100.f;
+    // Slide force impulse applied when character slides
+    UPROPERTY(EditAnywhere, Category = "Movement")
+    float SlideForce = 1000.f;
+    // Ground friction and braking friction factor when sliding
+    UPROPERTY(EditAnywhere, Category = "Movement")
+    float SlideFriction = .2f;
+    UPROPERTY(EditAnywhere, Category = "Movement", meta = (ClampMin = "0"))
+    float SlideBrakingFrictionFactor = .1f;
+    // Minimum speed needed for the slide impulse to be applied
+    UPROPERTY(EditAnywhere, Category = "Movement")
+    float MinSlideImpulseSpeed = 100.f;
+    // Acceleration towards the bottom of a slope when sliding
+    UPROPERTY(EditAnywhere, Category = "Movement")
+    float SlideSlopeAcceleration = 10000.f;
+    UPROPERTY(EditAnywhere, Category = "Movement")
+    float WallRunCounterGravity = 1;
+    UPROPERTY(EditAnywhere, Category = "Movement")
+    float WallRunSpeed = 1000;
+    UPROPERTY(EditAnywhere, Category = "Movement")
+    float WallJumpForce = 300.f;
+    // Vertical speed set when a wall run starts
+    UPROPERTY(EditAnywhere, Category = "Movement")
+    float WallRunEntrySpeed = 100.f;
+    // Seconds without a wall hit before a sweep checks the wall is still there
+    UPROPERTY(EditAnywhere, Category = "Movement", meta = (ClampMin = "0"))
+    float WallContactProbeInterval = .03f;
+    // Distance swept towards the wall to check it is still there
+    UPROPERTY(EditAnywhere, Category = "Movement", meta = (ClampMin = "0"))
+    float WallProbeDistance = 5.f;
+    // Lowest and highest ledges above the feet that can be climbed, ledges up to MaxVaultHeight are vaulted
+    UPROPERTY(EditAnywhere, Category = "Movement", meta = (ClampMin = "0"))
+    float MinLedgeHeight = 50.f;
+    UPROPERTY(EditAnywhere, Category = "Movement", meta = (ClampMin = "0"))
+    float MaxVaultHeight = 110.f;
+    UPROPERTY(EditAnywhere, Category = "Movement", meta = (ClampMin = "0"))
+    float MaxMantleHeight = 200.f;
+    // Distance in front of the capsule checked for a ledge
+    UPROPERTY(EditAnywhere, Category = "Movement", meta = (ClampMin = "0"))
+    float LedgeReachDistance = 50.f;
+    // Seconds a vault and a mantle take
+    UPROPERTY(EditAnywhere, Category = "Movement", meta = (ClampMin = "0.01"))
+    float VaultDuration = .25f;
+    UPROPERTY(EditAnywhere, Category = "Movement", meta = (ClampMin = "0.01"))
+    float MantleDuration = .5f;
+
+    // Transition Speeds
+
+    // Camera tilt angle and transition speed when sliding
+    UPROPERTY(EditAnywhere, Category = "Transitions")
+    float SlideCameraTiltAngle = -3.f;
+    UPROPERTY(EditAnywhere, Category = "Transitions")
+    float SlideCameraTiltSpeed = 7.f;
+    // Transition speed of crouching
+    UPROPERTY(EditAnywhere, Category = "Transitions")
+    float CrouchTransitionSpeed = 25.f;
+    // Wall running camera tilt speed
+    UPROPERTY(EditAnywhere, Category = "Transitions")
+    float WallRunTransitionSpeed = 10.f;
+    // Angle camera tilts at when wall running
+    UPROPERTY(EditAnywhere, Category = "Transitions")
+    float WallRunCameraTiltAngle = 10.f;
+    // Camera pitch dip when landing at MaxLandingShakeSpeed, scaled down to nothing at MinLandingShakeSpeed
+    UPROPERTY(EditAnywhere, Category = "Transitions", meta = (ClampMin = "0"))
+    float LandingShakeAngle = 3.f;
+    UPROPERTY(EditAnywhere, Category = "Transitions", meta = (ClampMin = "0"))
+    float MinLandingShakeSpeed = 400.f;
+    UPROPERTY(EditAnywhere, Category = "Transitions", meta = (ClampMin = "0"))
+    float MaxLandingShakeSpeed = 1200.f;
+    // Seconds the landing camera dip takes to recover
+    UPROPERTY(EditAnywhere, Category = "Transitions", meta = (ClampMin = "0.01"))
+    float LandingShakeDuration = .25f;
+
+private:
+    FPSMovementKernel::FMovementParams Params = FPSMovementKernel::MakeDefaultParams();
+};
@@ -0,0 +1,112 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "FPSMovementValidationSubsystem.h"
+#include "FPSCharacterMovementComponent.h"
+#include "FPSMovementStats.h"
+#include "Async/ParallelFor.h"
+#include "HAL/IConsoleManager.h"
+
+namespace
+{
+    // Moves checked per ParallelFor task
+    constexpr int32 MovesPerTask = 256;
+
+    bool bValidationEnabled = true;
+    FAutoConsoleVariableRef CVarValidationEnabled(TEXT("fps.Movement.Validation.Enabled"), bValidationEnabled,
+                                                  TEXT("Checks client reported movement on the server"));
+
+    float ValidationTolerance = 1.15f;
+    FAutoConsoleVariableRef CVarValidationTolerance(
+        TEXT("fps.Movement.Validation.Tolerance"), ValidationTolerance,
+        TEXT("Scale on every movement speed limit, absorbs jitter in client timestamps"));
+} // namespace
+
+void UFPSMovementValidationSubsystem::Tick(float DeltaTime)
+{
+    FPS_MOVEMENT_SCOPE(STAT_FPSMoveValidation);
+    Super::Tick(DeltaTime);
+    if (!bValidationEnabled || Movements.IsEmpty())
+    {
+        return;
+    }
+
+    // Gathers the moves reported since last frame into a flat batch
+    Samples.Reset();
+    Params.Reset();
+    Owners.Reset();
+    for (int32 Index = 0; Index < Movements.Num(); Index++)
+    {
+        FPSMovementKernel::FMoveSample Sample;
+        if (Movements[Index] && Movements[Index]->ConsumeMoveSample(Sample))
+        {
+            Samples.Add(Sample);
+            Params.Add(&Movements[Index]->GetMovementParams());
+            Owners.Add(Index);
+        }
+    }
+    if (Samples.IsEmpty())
+    {
+        return;
+    }
+
+    Checks.SetNumUninitialized(Samples.Num(), EAllowShrinking::No);
+    const float Tolerance = FMath::Max(ValidationTolerance, 1.f);
+    const int32 NumTasks = FMath::DivideAndRoundUp(Samples.Num(), MovesPerTask);
+    ParallelFor(
+        NumTasks,
+        [this, Tolerance](int32 TaskIndex)
+        {
+            const int32 FirstMove = TaskIndex * MovesPerTask;
+            CheckMoves(FirstMove, FMath::Min(FirstMove + MovesPerTask, Samples.Num()), Tolerance);
+        },
+        NumTasks > 1 ? EParallelForFlags::None : EParallelForFlags::ForceSingleThread);
+
+    // Stores the carried momentum and reports violations on the game thread
+    for (int32 Move = 0; Move < Samples.Num(); Move++)
+    {
+        const FPSMovementKernel::FMoveCheck &Check = Checks[Move];
+        CarriedSpeeds[Owners[Move]] = Check.CarriedSpeed;
+        if (Check.Violations != 0)
+        {
+            NumViolations++;
+            INC_DWORD_STAT(STAT_FPSMoveViolations);
+            UFPSCharacterMovementComponent *Movement = Movements[Owners[Move]];
+            UE_LOG(LogFPSMovement, Verbose, TEXT("%s moved at %.0f, limit %.0f (violations 0x%x)"),
+                   *GetNameSafe(Movement->GetOwner()), Check.Speed, Check.SpeedLimit, Check.Violations);
+            OnMoveViolation.Broadcast(Movement, Check);
+        }
+    }
+}
+
+TStatId UFPSMovementValidationSubsystem::GetStatId() const
+{
+    RETURN_QUICK_DECLARE_CYCLE_STAT(UFPSMovementValidationSubsystem, STATGROUP_Tickables);
+}
+
+void UFPSMovementValidationSubsystem::RegisterMovement(UFPSCharacterMovementComponent *Movement)
+{
+    if (Movement && !Movements.Contains(Movement))
+    {
+        Movements.Add(Movement);
+        CarriedSpeeds.Add(0.f);
+    }
+}
+
+void UFPSMovementValidationSubsystem::UnregisterMovement(UFPSCharacterMovementComponent *Movement)
+{
+    const int32 Index = Movements.Find(Movement);
+    if (Index != INDEX_NONE)
+    {
+        Movements.RemoveAtSwap(Index);
+        CarriedSpeeds.RemoveAtSwap(Index);
+    }
+}
+
+void UFPSMovementValidationSubsystem::CheckMoves(int32 FirstMove, int32 LastMove, float Tolerance)
+{
+    for (int32 Move = FirstMove; Move < LastMove; Move++)
+    {
+        Checks[Move] =
+            FPSMovementKernel::CheckMove(Samples[Move], *Params[Move], CarriedSpeeds[Owners[Move]], Tolerance);
+    }
+}
@@ -0,0 +1,61 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "FPSMovementKernel.h"
+#include "FPSMovementValidationSubsystem.generated.h"
+
+class UFPSCharacterMovementComponent;
+
+// Called on the game thread for every player whose moves left the envelope this frame
+DECLARE_MULTICAST_DELEGATE_TwoParams(FOnFPSMoveViolation, UFPSCharacterMovementComponent * /*Movement*/,
+                                     const FPSMovementKernel::FMoveCheck & /*Check*/);
+
+/**
+ * Checks client reported movement on the server against the speeds the character's tuning allows.
+ * Each movement component accumulates its player's reported moves, and once a frame, after movement,
+ * they are gathered into a flat batch and checked in one ParallelFor pass.
+ * Violations increment the Move Violations stat and are broadcast through OnMoveViolation.
+ */
+UCLASS()
+class MOVEMENT_REMAKE_API UFPSMovementValidationSubsystem : public UTickableWorldSubsystem
+{
+    GENERATED_BODY()
+
+public:
+    virtual void Tick(float DeltaTime) override;
+    virtual TStatId GetStatId() const override;
+
+    // Adds a server side movement component to the validated set
+    void RegisterMovement(UFPSCharacterMovementComponent *Movement);
+    void UnregisterMovement(UFPSCharacterMovementComponent *Movement);
+
+    // Violations since the world started
+    int32 GetNumViolations() const
+    {
+        return NumViolations;
+    }
+
+    FOnFPSMoveViolation OnMoveViolation;
+
+private:
+    // Checks batch entries [FirstMove, LastMove)
+    void CheckMoves(int32 FirstMove, int32 LastMove, float Tolerance);
+
+    // Validated movement components, and the momentum each may carry into its next sample
+    UPROPERTY(Transient)
+    TArray<UFPSCharacterMovementComponent *> Movements;
+    TArray<float> CarriedSpeeds;
+
+    // Batch gathered this frame, reused between frames
+    TArray<FPSMovementKernel::FMoveSample> Samples;
+    // Shared tuning of each sample, bots using the same tuning point at the same block
+    TArray<const FPSMovementKernel::FMovementParams *> Params;
+    // Index into Movements of each sample
+    TArray<int32> Owners;
+    TArray<FPSMovementKernel::FMoveCheck> Checks;
+
+    int32 NumViolations = 0;
+};
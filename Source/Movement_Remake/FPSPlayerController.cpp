@@ -1,7 +1,7 @@
 // Fill out your copyright notice in the Description page of Project Settings.
 
 #include "FPSPlayerController.h"
-#include "Engine/Engine.h"
+#include "FPSMovementStats.h"
 #include "Engine/LocalPlayer.h"
 #include "EnhancedInputSubsystems.h"
 #include "Math/Color.h"
@@ -13,8 +13,8 @@ void AFPSPlayerController::BeginPlay()
             GetLocalPlayer()->GetSubsystem<UEnhancedInputLocalPlayerSubsystem>())
     {
         Subsystem->AddMappingContext(InputMapping, 1);
-        GEngine->AddOnScreenDebugMessage(0, 5.0f, FColor::Green, TEXT("Subsystem found"));
+        FPS_MOVEMENT_DEBUG(0, FColor::Green, TEXT("Subsystem found"));
         return;
     }
-    GEngine->AddOnScreenDebugMessage(1, 5.f, FColor::Red, TEXT("Subsystem not found"));
+    UE_LOG(LogFPSMovement, Warning, TEXT("Enhanced input subsystem not found, input mapping was not added"));
 }
\ No newline at end of file
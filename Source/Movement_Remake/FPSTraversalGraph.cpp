@@ -0,0 +1,329 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "FPSTraversalGraph.h"
+#include "FPSMovementStats.h"
+#include "Algo/Reverse.h"
+#include "HAL/PlatformFileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+namespace FPSTraversal
+{
+    void FPathSearch::Begin(int32 NumNodes)
+    {
+        // A different graph starts over with clear stamps, as does a wrapped generation counter
+        if (Generations.Num() != NumNodes || Generation == MAX_uint32)
+        {
+            Generations.Init(0, NumNodes);
+            ClosedGenerations.Init(0, NumNodes);
+            Costs.SetNumUninitialized(NumNodes);
+            Parents.SetNumUninitialized(NumNodes);
+            ParentLinks.SetNumUninitialized(NumNodes);
+            Generation = 0;
+        }
+        Generation++;
+        Open.Reset();
+    }
+
+    FTraversalGraph::~FTraversalGraph()
+    {
+        // The region has to be unmapped before the file handle is closed
+        MappedRegion.Reset();
+        MappedFile.Reset();
+    }
+
+    TUniquePtr<FTraversalGraph> FTraversalGraph::Load(const FString &Path)
+    {
+        IPlatformFile &PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+        if (!PlatformFile.FileExists(*Path))
+        {
+            return nullptr;
+        }
+        TUniquePtr<FTraversalGraph> Graph(new FTraversalGraph());
+        Graph->MappedFile.Reset(PlatformFile.OpenMapped(*Path));
+        if (Graph->MappedFile && Graph->MappedFile->GetFileSize() >= int64(sizeof(FHeader)))
+        {
+            Graph->MappedRegion.Reset(Graph->MappedFile->MapRegion(0, Graph->MappedFile->GetFileSize()));
+        }
+        if (!Graph->MappedRegion)
+        {
+            UE_LOG(LogFPSMovement, Error, TEXT("Could not map traversal graph %s"), *Path);
+            return nullptr;
+        }
+
+        const uint8 *Read = Graph->MappedRegion->GetMappedPtr();
+        FMemory::Memcpy(&Graph->Header, Read, sizeof(FHeader));
+        const FHeader &Header = Graph->Header;
+        const int64 NumCells = int64(Header.NumCellsX) * Header.NumCellsY;
+        const int64 ExpectedSize = sizeof(FHeader) + int64(Header.NumNodes) * sizeof(FNode) +
+                                   int64(Header.NumLinks) * sizeof(FLink) +
+                                   (int64(Header.NumNodes) + 1 + NumCells + 1 + Header.NumCellEntries) * sizeof(uint32);
+        if (Header.Magic != Magic || Header.Version != Version || Header.NodeSize != sizeof(FNode) ||
+            Header.LinkSize != sizeof(FLink) || Header.MaxSpeed <= 0.f ||
+            Graph->MappedRegion->GetMappedSize() != ExpectedSize)
+        {
+            UE_LOG(LogFPSMovement, Error, TEXT("%s is not a version %d traversal graph"), *Path, Version);
+            return nullptr;
+        }
+
+        // The arrays are used where they are mapped
+        Read += sizeof(FHeader);
+        auto View = [&Read](auto &Array, int64 Num)
+        {
+            using FView = std::decay_t<decltype(Array)>;
+            Array = FView(reinterpret_cast<typename FView::ElementType *>(Read), int32(Num));
+            Read += Num * sizeof(typename FView::ElementType);
+        };
+        View(Graph->Nodes, Header.NumNodes);
+        View(Graph->LinkStarts, int64(Header.NumNodes) + 1);
+        View(Graph->Links, Header.NumLinks);
+        View(Graph->CellStarts, NumCells + 1);
+        View(Graph->CellEntries, Header.NumCellEntries);
+
+        // Path queries index the arrays with what the file says without checking, so a damaged file is
+        // rejected here
+        const TConstArrayView<uint32> LinkStarts = Graph->LinkStarts;
+        const TConstArrayView<uint32> CellStarts = Graph->CellStarts;
+        bool bValid = LinkStarts[0] == 0 && LinkStarts.Last() == Header.NumLinks && CellStarts[0] == 0 &&
+                      CellStarts.Last() == Header.NumCellEntries;
+        for (int32 Node = 1; bValid && Node < LinkStarts.Num(); Node++)
+        {
+            bValid = LinkStarts[Node - 1] <= LinkStarts[Node];
+        }
+        for (int32 Cell = 1; bValid && Cell < CellStarts.Num(); Cell++)
+        {
+            bValid = CellStarts[Cell - 1] <= CellStarts[Cell];
+        }
+        for (int32 Link = 0; bValid && Link < Graph->Links.Num(); Link++)
+        {
+            bValid = Graph->Links[Link].Target < Header.NumNodes;
+        }
+        for (int32 Entry = 0; bValid && Entry < Graph->CellEntries.Num(); Entry++)
+        {
+            bValid = Graph->CellEntries[Entry] < Header.NumNodes;
+        }
+        if (!bValid)
+        {
+            UE_LOG(LogFPSMovement, Error, TEXT("%s has links or cell lists outside its nodes"), *Path);
+            return nullptr;
+        }
+        return Graph;
+    }
+
+    bool FTraversalGraph::Save(const FString &Path, const TArray<FNode> &Nodes, const TArray<TArray<FLink>> &NodeLinks,
+                               float InCellSize)
+    {
+        check(NodeLinks.Num() == Nodes.Num());
+        const float CellSize = FMath::Max(InCellSize, 1.f);
+        auto GetNodeLocation = [&Nodes](uint32 Index) { return GetLocation(Nodes[Index]); };
+
+        // Flattens the link lists, and finds the fastest link for the search heuristic
+        TArray<uint32> LinkStarts;
+        TArray<FLink> Links;
+        LinkStarts.Reserve(Nodes.Num() + 1);
+        LinkStarts.Add(0);
+        float MaxSpeed = 1.f;
+        for (int32 Node = 0; Node < Nodes.Num(); Node++)
+        {
+            for (const FLink &Link : NodeLinks[Node])
+            {
+                Links.Add(Link);
+                if (Link.Cost > 0.f)
+                {
+                    const float Distance = FVector::Dist(GetNodeLocation(Node), GetNodeLocation(Link.Target));
+                    MaxSpeed = FMath::Max(MaxSpeed, Distance / Link.Cost);
+                }
+            }
+            LinkStarts.Add(uint32(Links.Num()));
+        }
+
+        // Buckets the floor nodes in a grid, counting each cell's nodes before filling the cell lists
+        FBox2f Bounds(ForceInit);
+        for (const FNode &Node : Nodes)
+        {
+            if (Node.Type == ENodeType::Floor)
+            {
+                Bounds += FVector2f(Node.X, Node.Y);
+            }
+        }
+        FVector2f Origin = FVector2f::ZeroVector;
+        int32 NumCellsX = 0;
+        int32 NumCellsY = 0;
+        if (Bounds.bIsValid)
+        {
+            Origin = Bounds.Min;
+            NumCellsX = FMath::Max(FMath::CeilToInt32((Bounds.Max.X - Origin.X) / CellSize), 1);
+            NumCellsY = FMath::Max(FMath::CeilToInt32((Bounds.Max.Y - Origin.Y) / CellSize), 1);
+        }
+        auto GetCell = [&](const FNode &Node)
+        {
+            const int32 X = FMath::Clamp(int32((Node.X - Origin.X) / CellSize), 0, NumCellsX - 1);
+            const int32 Y = FMath::Clamp(int32((Node.Y - Origin.Y) / CellSize), 0, NumCellsY - 1);
+            return Y * NumCellsX + X;
+        };
+        TArray<uint32> CellStarts;
+        CellStarts.SetNumZeroed(NumCellsX * NumCellsY + 1);
+        for (const FNode &Node : Nodes)
+        {
+            if (Node.Type == ENodeType::Floor)
+            {
+                CellStarts[GetCell(Node) + 1]++;
+            }
+        }
+        for (int32 Cell = 1; Cell < CellStarts.Num(); Cell++)
+        {
+            CellStarts[Cell] += CellStarts[Cell - 1];
+        }
+        TArray<uint32> CellEntries;
+        CellEntries.SetNumUninitialized(CellStarts.Last());
+        TArray<uint32> NextEntry(CellStarts.GetData(), CellStarts.Num() - 1);
+        for (int32 Index = 0; Index < Nodes.Num(); Index++)
+        {
+            if (Nodes[Index].Type == ENodeType::Floor)
+            {
+                CellEntries[NextEntry[GetCell(Nodes[Index])]++] = uint32(Index);
+            }
+        }
+
+        const FHeader Header = {Magic,
+                                Version,
+                                uint16(sizeof(FNode)),
+                                uint16(sizeof(FLink)),
+                                0,
+                                uint32(Nodes.Num()),
+                                uint32(Links.Num()),
+                                uint32(NumCellsX),
+                                uint32(NumCellsY),
+                                uint32(CellEntries.Num()),
+                                Origin.X,
+                                Origin.Y,
+                                CellSize,
+                                MaxSpeed};
+        TArray<uint8> Bytes;
+        auto Append = [&Bytes](const auto &Array)
+        { Bytes.Append(reinterpret_cast<const uint8 *>(Array.GetData()), Array.Num() * Array.GetTypeSize()); };
+        Bytes.Append(reinterpret_cast<const uint8 *>(&Header), sizeof(Header));
+        Append(Nodes);
+        Append(LinkStarts);
+        Append(Links);
+        Append(CellStarts);
+        Append(CellEntries);
+        FPlatformFileManager::Get().GetPlatformFile().CreateDirectoryTree(*FPaths::GetPath(Path));
+        return FFileHelper::SaveArrayToFile(Bytes, *Path);
+    }
+
+    int32 FTraversalGraph::FindNearestNode(const FVector &Location, float MaxDistance) const
+    {
+        if (CellEntries.IsEmpty())
+        {
+            return INDEX_NONE;
+        }
+        const int32 NumCellsX = int32(Header.NumCellsX);
+        const int32 NumCellsY = int32(Header.NumCellsY);
+        const float CellSize = Header.CellSize;
+        const FVector3f Query(Location);
+        const int32 MinX = FMath::Clamp(int32((Query.X - MaxDistance - Header.OriginX) / CellSize), 0, NumCellsX - 1);
+        const int32 MinY = FMath::Clamp(int32((Query.Y - MaxDistance - Header.OriginY) / CellSize), 0, NumCellsY - 1);
+        const int32 MaxX = FMath::Clamp(int32((Query.X + MaxDistance - Header.OriginX) / CellSize), 0, NumCellsX - 1);
+        const int32 MaxY = FMath::Clamp(int32((Query.Y + MaxDistance - Header.OriginY) / CellSize), 0, NumCellsY - 1);
+
+        float BestDistanceSquared = FMath::Square(MaxDistance);
+        int32 Best = INDEX_NONE;
+        for (int32 Y = MinY; Y <= MaxY; Y++)
+        {
+            for (int32 X = MinX; X <= MaxX; X++)
+            {
+                const int32 Cell = Y * NumCellsX + X;
+                for (uint32 Entry = CellStarts[Cell]; Entry < CellStarts[Cell + 1]; Entry++)
+                {
+                    const FNode &Node = Nodes[CellEntries[Entry]];
+                    const float DistanceSquared = FVector3f::DistSquared(FVector3f(Node.X, Node.Y, Node.Z), Query);
+                    if (DistanceSquared < BestDistanceSquared)
+                    {
+                        BestDistanceSquared = DistanceSquared;
+                        Best = int32(CellEntries[Entry]);
+                    }
+                }
+            }
+        }
+        return Best;
+    }
+
+    bool FTraversalGraph::FindPath(const FVector &Start, const FVector &Goal, float MaxSnapDistance,
+                                   FPathSearch &Search, TArray<FPathStep> &OutPath) const
+    {
+        OutPath.Reset();
+        const int32 StartNode = FindNearestNode(Start, MaxSnapDistance);
+        const int32 GoalNode = FindNearestNode(Goal, MaxSnapDistance);
+        if (StartNode == INDEX_NONE || GoalNode == INDEX_NONE)
+        {
+            return false;
+        }
+
+        // A* on travel time. No link is faster than MaxSpeed, so the straight line at that speed never
+        // overestimates and a node's first expansion is its fastest.
+        const FVector3f GoalLocation(GetLocation(Nodes[GoalNode]));
+        const float InvMaxSpeed = 1.f / Header.MaxSpeed;
+        auto Estimate = [this, &GoalLocation, InvMaxSpeed](uint32 Node)
+        {
+            const FNode &Target = Nodes[Node];
+            return FVector3f::Dist(FVector3f(Target.X, Target.Y, Target.Z), GoalLocation) * InvMaxSpeed;
+        };
+        auto ByCost = [](const TPair<float, uint32> &A, const TPair<float, uint32> &B) { return A.Key < B.Key; };
+
+        Search.Begin(Nodes.Num());
+        const uint32 Generation = Search.Generation;
+        Search.Generations[StartNode] = Generation;
+        Search.Costs[StartNode] = 0.f;
+        Search.Parents[StartNode] = uint32(StartNode);
+        // The bot walks to the first node by itself
+        Search.ParentLinks[StartNode] = ELinkType::Walk;
+        Search.Open.HeapPush(TPair<float, uint32>(Estimate(StartNode), uint32(StartNode)), ByCost);
+        bool bFound = false;
+        while (!Search.Open.IsEmpty())
+        {
+            TPair<float, uint32> Item;
+            Search.Open.HeapPop(Item, ByCost, EAllowShrinking::No);
+            const uint32 Node = Item.Value;
+            if (Search.ClosedGenerations[Node] == Generation)
+            {
+                continue;
+            }
+            Search.ClosedGenerations[Node] = Generation;
+            if (Node == uint32(GoalNode))
+            {
+                bFound = true;
+                break;
+            }
+            const float Cost = Search.Costs[Node];
+            for (const FLink &Link : GetLinks(Node))
+            {
+                const float NewCost = Cost + Link.Cost;
+                if (Search.Generations[Link.Target] == Generation && Search.Costs[Link.Target] <= NewCost)
+                {
+                    continue;
+                }
+                Search.Generations[Link.Target] = Generation;
+                Search.Costs[Link.Target] = NewCost;
+                Search.Parents[Link.Target] = Node;
+                Search.ParentLinks[Link.Target] = Link.Type;
+                Search.Open.HeapPush(TPair<float, uint32>(NewCost + Estimate(Link.Target), Link.Target), ByCost);
+            }
+        }
+        if (!bFound)
+        {
+            return false;
+        }
+
+        for (uint32 Node = uint32(GoalNode);; Node = Search.Parents[Node])
+        {
+            OutPath.Add({GetLocation(Nodes[Node]), Search.ParentLinks[Node]});
+            if (Node == uint32(StartNode))
+            {
+                break;
+            }
+        }
+        Algo::Reverse(OutPath);
+        return true;
+    }
+} // namespace FPSTraversal
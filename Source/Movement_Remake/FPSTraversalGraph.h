@@ -0,0 +1,178 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Async/MappedFileHandle.h"
+#include "GenericPlatform/GenericPlatformFile.h"
+#include <type_traits>
+
+// Graph of the parkour moves a level allows: floor nodes at the foot of walls, wall nodes where a runner holds
+// on to them, and links for walking, wall running, jumping onto walls, wall jumping and dropping down. Built
+// offline from the wall index and saved next to the content. The file is the in-memory layout, so loading maps it
+// and checks the header, and path queries only read the mapped arrays.
+namespace FPSTraversal
+{
+    constexpr uint32 Magic = 0x47535046; // "FPSG"
+    constexpr uint16 Version = 1;
+
+    // Size of a grid cell of the floor node lookup
+    constexpr float DefaultCellSize = 1024.f;
+
+    enum class ENodeType : uint8
+    {
+        // Standing on the floor in front of a wall
+        Floor,
+        // Running along a wall
+        Wall,
+    };
+
+    // How a link is crossed
+    enum class ELinkType : uint8
+    {
+        Walk,
+        WallRun,
+        // Jumps from the floor onto a wall
+        Jump,
+        WallJump,
+        // Lets go of a wall and falls to the floor
+        Drop,
+        Count,
+    };
+
+    inline const TCHAR *GetLinkName(ELinkType Type)
+    {
+        static const TCHAR *const Names[] = {TEXT("Walk"), TEXT("WallRun"), TEXT("Jump"), TEXT("WallJump"),
+                                             TEXT("Drop")};
+        static_assert(UE_ARRAY_COUNT(Names) == int32(ELinkType::Count));
+        return Type < ELinkType::Count ? Names[int32(Type)] : TEXT("Unknown");
+    }
+
+    // Capsule center of a character at the node
+    struct FNode
+    {
+        float X;
+        float Y;
+        float Z;
+        ENodeType Type;
+        uint8 Padding[3];
+    };
+
+    struct FLink
+    {
+        uint32 Target;
+        // Seconds the move takes
+        float Cost;
+        ELinkType Type;
+        uint8 Padding[3];
+    };
+
+    // The file is the header followed by the nodes, the link starts, the links, the cell starts and the cell
+    // entries. Every section is a multiple of four bytes, so each array is aligned where the file is mapped.
+    struct FHeader
+    {
+        uint32 Magic;
+        uint16 Version;
+        // Sizes of one node and one link, let readers reject files written with a different layout
+        uint16 NodeSize;
+        uint16 LinkSize;
+        uint16 Padding;
+        uint32 NumNodes;
+        uint32 NumLinks;
+        uint32 NumCellsX;
+        uint32 NumCellsY;
+        // Entries in the cell lists, only floor nodes are listed
+        uint32 NumCellEntries;
+        float OriginX;
+        float OriginY;
+        float CellSize;
+        // Fastest any link crosses ground, keeps the path search heuristic from overestimating
+        float MaxSpeed;
+    };
+
+    static_assert(std::is_trivially_copyable_v<FNode> && sizeof(FNode) == 16);
+    static_assert(std::is_trivially_copyable_v<FLink> && sizeof(FLink) == 12);
+    static_assert(std::is_trivially_copyable_v<FHeader> && sizeof(FHeader) == 48);
+
+    // One step of a path, the location reached and the move that reaches it
+    struct FPathStep
+    {
+        FVector Location;
+        ELinkType Link;
+    };
+
+    // Working memory of path searches, kept between queries so they do not allocate. One per thread.
+    class FPathSearch
+    {
+        friend class FTraversalGraph;
+
+        // Grows the arrays to the graph and starts a new search generation
+        void Begin(int32 NumNodes);
+
+        // Nodes not stamped with the current generation have not been reached, or not expanded yet
+        TArray<uint32> Generations;
+        TArray<uint32> ClosedGenerations;
+        TArray<float> Costs;
+        TArray<uint32> Parents;
+        TArray<ELinkType> ParentLinks;
+        // Open nodes by estimated total cost
+        TArray<TPair<float, uint32>> Open;
+        uint32 Generation = 0;
+    };
+
+    /** Traversal graph read from a mapped file, immutable once loaded. */
+    class MOVEMENT_REMAKE_API FTraversalGraph
+    {
+    public:
+        ~FTraversalGraph();
+
+        // Maps a graph written by Save, returns null when the file is missing or not a graph
+        static TUniquePtr<FTraversalGraph> Load(const FString &Path);
+        // Writes the nodes and the links leaving each node, and the floor node lookup with cells of CellSize
+        static bool Save(const FString &Path, const TArray<FNode> &Nodes, const TArray<TArray<FLink>> &NodeLinks,
+                         float CellSize = DefaultCellSize);
+
+        // Closest floor node within MaxDistance of Location, INDEX_NONE when there is none
+        int32 FindNearestNode(const FVector &Location, float MaxDistance) const;
+        // Fastest path from the floor node nearest Start to the floor node nearest Goal, starting with the node
+        // nearest Start. Returns false when either has no node within MaxSnapDistance or the goal is unreachable.
+        bool FindPath(const FVector &Start, const FVector &Goal, float MaxSnapDistance, FPathSearch &Search,
+                      TArray<FPathStep> &OutPath) const;
+
+        int32 Num() const
+        {
+            return Nodes.Num();
+        }
+        int32 NumLinks() const
+        {
+            return Links.Num();
+        }
+        const FNode &GetNode(int32 Index) const
+        {
+            return Nodes[Index];
+        }
+        TConstArrayView<FLink> GetLinks(int32 Index) const
+        {
+            return Links.Slice(LinkStarts[Index], LinkStarts[Index + 1] - LinkStarts[Index]);
+        }
+        static FVector GetLocation(const FNode &Node)
+        {
+            return FVector(Node.X, Node.Y, Node.Z);
+        }
+
+    private:
+        FTraversalGraph() = default;
+
+        TUniquePtr<IMappedFileHandle> MappedFile;
+        TUniquePtr<IMappedFileRegion> MappedRegion;
+
+        FHeader Header = {};
+        TConstArrayView<FNode> Nodes;
+        // Links of node N are Links[LinkStarts[N]] up to Links[LinkStarts[N + 1]]
+        TConstArrayView<uint32> LinkStarts;
+        TConstArrayView<FLink> Links;
+        // Floor nodes of cell C are CellEntries[CellStarts[C]] up to CellEntries[CellStarts[C + 1]]
+        TConstArrayView<uint32> CellStarts;
+        TConstArrayView<uint32> CellEntries;
+    };
+} // namespace FPSTraversal
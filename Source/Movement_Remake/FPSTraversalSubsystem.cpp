@@ -0,0 +1,578 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "FPSTraversalSubsystem.h"
+#include "FPSCharacter.h"
+#include "FPSCharacterMovementComponent.h"
+#include "FPSMovementStats.h"
+#include "FPSMovementTrajectory.h"
+#include "FPSMovementTuning.h"
+#include "FPSWallIndexSubsystem.h"
+#include "Components/CapsuleComponent.h"
+#include "DrawDebugHelpers.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/Paths.h"
+
+namespace
+{
+    // Furthest a path may start or end from its first and last floor node
+    constexpr float MaxSnapDistance = 1000.f;
+    // Seconds fps.Traversal.Path draws a path for
+    constexpr float PathDrawTime = 10.f;
+
+    FColor GetLinkColor(FPSTraversal::ELinkType Type)
+    {
+        switch (Type)
+        {
+        case FPSTraversal::ELinkType::WallRun:
+            return FColor::Blue;
+        case FPSTraversal::ELinkType::Jump:
+            return FColor::Yellow;
+        case FPSTraversal::ELinkType::WallJump:
+            return FColor::Orange;
+        case FPSTraversal::ELinkType::Drop:
+            return FColor::Red;
+        default:
+            return FColor::Green;
+        }
+    }
+
+    FAutoConsoleCommandWithWorldAndArgs GTraversalBuildCommand(
+        TEXT("fps.Traversal.Build"),
+        TEXT("Builds the traversal graph from the geometry loaded in the editor and saves it for the map, with the "
+             "wall index. Args: [TuningAsset], the tuning defaults when left out"),
+        FConsoleCommandWithWorldAndArgsDelegate::CreateLambda(
+            [](const TArray<FString> &Args, UWorld *World)
+            {
+                UFPSTraversalSubsystem *Traversal = World ? World->GetSubsystem<UFPSTraversalSubsystem>() : nullptr;
+                if (!Traversal)
+                {
+                    return;
+                }
+                const UFPSMovementTuning *Tuning = Args.Num() > 0 ? LoadObject<UFPSMovementTuning>(nullptr, *Args[0])
+                                                                  : GetDefault<UFPSMovementTuning>();
+                if (!Tuning)
+                {
+                    UE_LOG(LogFPSMovement, Error, TEXT("No movement tuning %s"), *Args[0]);
+                    return;
+                }
+                Traversal->BuildAndSave(Tuning->GetParams());
+            }));
+
+    FAutoConsoleCommandWithWorldAndArgs GTraversalPathCommand(
+        TEXT("fps.Traversal.Path"),
+        TEXT("Logs and draws the traversal path from the first player to a location. Args: X Y Z"),
+        FConsoleCommandWithWorldAndArgsDelegate::CreateLambda(
+            [](const TArray<FString> &Args, UWorld *World)
+            {
+                UFPSTraversalSubsystem *Traversal = World ? World->GetSubsystem<UFPSTraversalSubsystem>() : nullptr;
+                const APlayerController *Player = World ? World->GetFirstPlayerController() : nullptr;
+                if (!Traversal || !Player || !Player->GetPawn() || Args.Num() < 3)
+                {
+                    UE_LOG(LogFPSMovement, Error, TEXT("fps.Traversal.Path needs a player and a location"));
+                    return;
+                }
+                const FVector Goal(FCString::Atod(*Args[0]), FCString::Atod(*Args[1]), FCString::Atod(*Args[2]));
+                TArray<FPSTraversal::FPathStep> Path;
+                const double StartTime = FPlatformTime::Seconds();
+                const bool bFound = Traversal->FindPath(Player->GetPawn()->GetActorLocation(), Goal, Path);
+                const double Microseconds = (FPlatformTime::Seconds() - StartTime) * 1.e6;
+                if (!bFound)
+                {
+                    UE_LOG(LogFPSMovement, Display, TEXT("No traversal path to %s, searched in %.1f us"),
+                           *Goal.ToCompactString(), Microseconds);
+                    return;
+                }
+                UE_LOG(LogFPSMovement, Display, TEXT("Traversal path of %d steps found in %.1f us"), Path.Num(),
+                       Microseconds);
+                for (int32 Step = 1; Step < Path.Num(); Step++)
+                {
+                    UE_LOG(LogFPSMovement, Display, TEXT("  %s to %s"), FPSTraversal::GetLinkName(Path[Step].Link),
+                           *Path[Step].Location.ToCompactString());
+                    DrawDebugLine(World, Path[Step - 1].Location, Path[Step].Location, GetLinkColor(Path[Step].Link),
+                                  false, PathDrawTime, 0, 3.f);
+                }
+            }));
+
+#if WITH_EDITOR
+    // Spacing of the nodes along a wall
+    constexpr float NodeSpacing = 200.f;
+    // Gap between a wall and the capsule of a character at one of its nodes
+    constexpr float WallGap = 2.f;
+    // How far past the wall's plane a column looks for the wall, covers the rounding of the packed normal
+    constexpr float WallCheckDepth = 10.f;
+    // How far below a wall the floor in front of it is looked for
+    constexpr float MaxFloorDepth = 1000.f;
+    // How close a wall run or a jump has to pass a node, to the side and up or down, to reach it
+    constexpr float CaptureRadius = 100.f;
+    // Longest a wall jump may stay in the air
+    constexpr float MaxAirTime = 2.f;
+    // Floor nodes further apart are not linked by walking
+    constexpr float MaxWalkDistance = 800.f;
+    // Spacing of the floor checks along a walk link
+    constexpr float WalkCheckSpacing = 100.f;
+    // Segments a jump arc is traced in
+    constexpr int32 ArcTraceSegments = 8;
+
+    // Nodes in front of one spot of a wall: the wall node a runner passes and the floor node below it
+    struct FColumn
+    {
+        int32 WallNode;
+        int32 FloorNode;
+        // Patch of the wall and the distance of the column along its tangent
+        int32 Patch;
+        float Offset;
+        FVector Normal;
+        FVector Tangent;
+        // Heights a capsule center can be at and touch the wall
+        float BottomZ;
+        float TopZ;
+        // False over a gap in the wall, where the column has no nodes and wall runs stop
+        bool bHasWall;
+    };
+
+    // Works out the traversal graph of a level offline. Walls come from the wall index, floors, clearance and
+    // obstacles from traces against the loaded level, and wall runs and jumps follow the movement's arcs.
+    class FGraphBuilder
+    {
+    public:
+        FGraphBuilder(UWorld &InWorld, const FPSMovementKernel::FMovementParams &InParams)
+            : World(InWorld), Params(InParams), QueryParams(SCENE_QUERY_STAT(TraversalBuild), false)
+        {
+            const AFPSCharacter *Character = GetDefault<AFPSCharacter>();
+            Radius = Character->GetCapsuleComponent()->GetScaledCapsuleRadius();
+            HalfHeight = Character->GetCapsuleComponent()->GetScaledCapsuleHalfHeight();
+            WalkableFloorZ = Character->GetCharacterMovement()->GetWalkableFloorZ();
+            MaxStepHeight = Character->GetCharacterMovement()->MaxStepHeight;
+            GravityZ = World.GetGravityZ();
+            JumpHeight = FMath::Square(Params.JumpZVelocity) / (-2.f * GravityZ);
+        }
+
+        // Places columns along every wall, where a character fits beside it
+        void AddColumns(const TArray<FPSWallIndex::FPatch> &Patches)
+        {
+            for (int32 PatchIndex = 0; PatchIndex < Patches.Num(); PatchIndex++)
+            {
+                const FPSWallIndex::FPatch &Patch = Patches[PatchIndex];
+                const FPSMovementKernel::FVec3 Unpacked = FPSMovementKernel::UnpackWallNormal(Patch.Normal);
+                const FVector3f Normal(Unpacked.X, Unpacked.Y, Unpacked.Z);
+                FVector3f Tangent;
+                FVector3f Bitangent;
+                FPSWallIndex::GetPatchAxes(Normal, Tangent, Bitangent);
+                const FVector Center(Patch.CenterX, Patch.CenterY, Patch.CenterZ);
+                const float HalfSpanZ = Patch.HalfHeight * Bitangent.Z;
+
+                // Columns keep a capsule radius away from the ends of the wall
+                const float Reach = FMath::Max(Patch.HalfWidth - Radius, 0.f);
+                const int32 NumColumns = FMath::FloorToInt32(2.f * Reach / NodeSpacing) + 1;
+                const float Spacing = NumColumns > 1 ? 2.f * Reach / (NumColumns - 1) : 0.f;
+                for (int32 Index = 0; Index < NumColumns; Index++)
+                {
+                    FColumn Column = {INDEX_NONE,
+                                      INDEX_NONE,
+                                      PatchIndex,
+                                      -Reach + Index * Spacing,
+                                      FVector(Normal),
+                                      FVector(Tangent),
+                                      float(Center.Z) - HalfSpanZ,
+                                      float(Center.Z) + HalfSpanZ,
+                                      true};
+                    const FVector Beside =
+                        Center + Column.Tangent * Column.Offset + Column.Normal * (Radius + WallGap);
+                    // Patches are rectangles around the wall's triangles, columns over a gap in it get no nodes
+                    FHitResult Hit;
+                    if (!World.LineTraceSingleByChannel(
+                            Hit, Beside, Beside - Column.Normal * (Radius + WallGap + WallCheckDepth), ECC_Pawn,
+                            QueryParams) ||
+                        !FPSMovementKernel::IsWall(
+                            {float(Hit.ImpactNormal.X), float(Hit.ImpactNormal.Y), float(Hit.ImpactNormal.Z)}))
+                    {
+                        Column.bHasWall = false;
+                        Columns.Add(Column);
+                        continue;
+                    }
+                    float WallZ = float(Center.Z);
+                    if (World.LineTraceSingleByChannel(Hit, FVector(Beside.X, Beside.Y, Column.TopZ),
+                                                       FVector(Beside.X, Beside.Y, Column.BottomZ - MaxFloorDepth),
+                                                       ECC_Pawn, QueryParams) &&
+                        Hit.ImpactNormal.Z >= WalkableFloorZ)
+                    {
+                        const FVector Floor(Beside.X, Beside.Y, Hit.ImpactPoint.Z + HalfHeight + WallGap);
+                        Column.FloorNode = AddNode(Floor, FPSTraversal::ENodeType::Floor, Columns.Num());
+                        // Runners from the floor catch the wall at the top of their jump
+                        if (Column.FloorNode != INDEX_NONE)
+                        {
+                            WallZ = Floor.Z + JumpHeight;
+                        }
+                    }
+                    if (WallZ >= Column.BottomZ && WallZ <= Column.TopZ)
+                    {
+                        Column.WallNode =
+                            AddNode(FVector(Beside.X, Beside.Y, WallZ), FPSTraversal::ENodeType::Wall, Columns.Num());
+                    }
+                    Columns.Add(Column);
+                }
+            }
+        }
+
+        void AddJumpAndDropLinks()
+        {
+            for (const FColumn &Column : Columns)
+            {
+                if (Column.WallNode == INDEX_NONE || Column.FloorNode == INDEX_NONE)
+                {
+                    continue;
+                }
+                const float DropHeight = FMath::Max(Nodes[Column.WallNode].Z - Nodes[Column.FloorNode].Z, 0.f);
+                AddLink(Column.FloorNode, Column.WallNode, FPSTraversal::ELinkType::Jump,
+                        Params.JumpZVelocity / -GravityZ);
+                AddLink(Column.WallNode, Column.FloorNode, FPSTraversal::ELinkType::Drop,
+                        FMath::Sqrt(2.f * DropHeight / -GravityZ));
+            }
+        }
+
+        // Links the wall nodes along each wall that a run in either direction reaches before it slides off
+        void AddWallRunLinks()
+        {
+            for (int32 Index = 0; Index < Columns.Num(); Index++)
+            {
+                const FColumn &From = Columns[Index];
+                if (From.WallNode == INDEX_NONE)
+                {
+                    continue;
+                }
+                const FVector Start = GetNodeLocation(From.WallNode);
+                for (const int32 Direction : {-1, 1})
+                {
+                    FPSMovementKernel::FMovementState State = {};
+                    State.Velocity = ToKernelVector(From.Tangent * (Direction * Params.WalkSpeed));
+                    State.WallNormal = ToKernelVector(From.Normal);
+                    const FPSMovementTrajectory::FArc Arc =
+                        FPSMovementTrajectory::MakeWallRunArc(State, Params, ToKernelVector(Start), GravityZ);
+                    // The columns of a wall are next to each other
+                    FVector Previous = Start;
+                    for (int32 To = Index + Direction; Columns.IsValidIndex(To) && Columns[To].Patch == From.Patch;
+                         To += Direction)
+                    {
+                        const FColumn &Target = Columns[To];
+                        if (!Target.bHasWall)
+                        {
+                            break;
+                        }
+                        const float Time = FMath::Abs(Target.Offset - From.Offset) / Params.WalkSpeed;
+                        const FVector Reached =
+                            FromKernelVector(FPSMovementTrajectory::Evaluate(Arc, Time).Position);
+                        if (Reached.Z < Target.BottomZ || Reached.Z > Target.TopZ || !IsClear(Previous, Reached))
+                        {
+                            break;
+                        }
+                        Previous = Reached;
+                        if (Target.WallNode != INDEX_NONE &&
+                            FMath::Abs(Reached.Z - Nodes[Target.WallNode].Z) <= CaptureRadius)
+                        {
+                            AddLink(From.WallNode, Target.WallNode, FPSTraversal::ELinkType::WallRun, Time);
+                        }
+                    }
+                }
+            }
+        }
+
+        // Links every wall node to the nodes a wall jump lands on, running either way along the wall
+        void AddWallJumpLinks()
+        {
+            for (const FColumn &From : Columns)
+            {
+                if (From.WallNode == INDEX_NONE)
+                {
+                    continue;
+                }
+                const FVector Start = GetNodeLocation(From.WallNode);
+                FPSMovementTrajectory::FArc Arcs[2];
+                float MaxDistanceSquared = 0.f;
+                for (int32 Direction = 0; Direction < 2; Direction++)
+                {
+                    FPSMovementKernel::FMovementState State = {};
+                    State.Velocity =
+                        ToKernelVector(From.Tangent * ((Direction == 0 ? -1.f : 1.f) * Params.WalkSpeed));
+                    State.WallNormal = ToKernelVector(From.Normal);
+                    State.bIsWallrunning = true;
+                    Arcs[Direction] =
+                        FPSMovementTrajectory::MakeWallJumpArc(State, Params, ToKernelVector(Start), GravityZ);
+                    const float Speed2D = FVector2f(Arcs[Direction].Velocity.X, Arcs[Direction].Velocity.Y).Size();
+                    MaxDistanceSquared =
+                        FMath::Max(MaxDistanceSquared, FMath::Square(Speed2D * MaxAirTime + CaptureRadius));
+                }
+
+                for (int32 Target = 0; Target < Nodes.Num(); Target++)
+                {
+                    if (NodeColumns[Target] == NodeColumns[From.WallNode] ||
+                        FVector::DistSquared2D(Start, GetNodeLocation(Target)) > MaxDistanceSquared)
+                    {
+                        continue;
+                    }
+                    float BestTime = MAX_flt;
+                    for (const FPSMovementTrajectory::FArc &Arc : Arcs)
+                    {
+                        float Time;
+                        if (Reaches(Arc, Target, Time) && Time < BestTime && IsArcClear(Arc, Time))
+                        {
+                            BestTime = Time;
+                        }
+                    }
+                    if (BestTime < MAX_flt)
+                    {
+                        AddLink(From.WallNode, Target, FPSTraversal::ELinkType::WallJump, BestTime);
+                    }
+                }
+            }
+        }
+
+        // Links floor nodes that can walk to each other over unbroken floor. Every pair is tried, which is fine
+        // offline for the few thousand nodes of a level.
+        void AddWalkLinks()
+        {
+            for (int32 From = 0; From < Nodes.Num(); From++)
+            {
+                if (Nodes[From].Type != FPSTraversal::ENodeType::Floor)
+                {
+                    continue;
+                }
+                for (int32 To = From + 1; To < Nodes.Num(); To++)
+                {
+                    if (Nodes[To].Type != FPSTraversal::ENodeType::Floor)
+                    {
+                        continue;
+                    }
+                    const FVector Start = GetNodeLocation(From);
+                    const FVector End = GetNodeLocation(To);
+                    const float Distance = FVector::Dist(Start, End);
+                    if (Distance > MaxWalkDistance || !IsClear(Start, End) || !HasFloorBetween(Start, End))
+                    {
+                        continue;
+                    }
+                    AddLink(From, To, FPSTraversal::ELinkType::Walk, Distance / Params.WalkSpeed);
+                    AddLink(To, From, FPSTraversal::ELinkType::Walk, Distance / Params.WalkSpeed);
+                }
+            }
+        }
+
+        TArray<FPSTraversal::FNode> Nodes;
+        TArray<TArray<FPSTraversal::FLink>> NodeLinks;
+
+    private:
+        // Adds a node where the capsule fits, returns INDEX_NONE where it does not
+        int32 AddNode(const FVector &Location, FPSTraversal::ENodeType Type, int32 Column)
+        {
+            if (World.OverlapBlockingTestByChannel(Location, FQuat::Identity, ECC_Pawn,
+                                                   FCollisionShape::MakeCapsule(Radius, HalfHeight), QueryParams))
+            {
+                return INDEX_NONE;
+            }
+            FPSTraversal::FNode &Node = Nodes.AddZeroed_GetRef();
+            Node.X = float(Location.X);
+            Node.Y = float(Location.Y);
+            Node.Z = float(Location.Z);
+            Node.Type = Type;
+            NodeLinks.AddDefaulted();
+            NodeColumns.Add(Column);
+            return Nodes.Num() - 1;
+        }
+
+        void AddLink(int32 From, int32 To, FPSTraversal::ELinkType Type, float Cost)
+        {
+            NodeLinks[From].Add({uint32(To), Cost, Type, {}});
+        }
+
+        FVector GetNodeLocation(int32 Node) const
+        {
+            return FPSTraversal::FTraversalGraph::GetLocation(Nodes[Node]);
+        }
+
+        // Whether a jump along Arc catches the target's wall close to the node or lands close to it on the floor
+        bool Reaches(const FPSMovementTrajectory::FArc &Arc, int32 Target, float &OutTime) const
+        {
+            const FVector End = GetNodeLocation(Target);
+            if (Nodes[Target].Type == FPSTraversal::ENodeType::Floor)
+            {
+                const FPSMovementTrajectory::FArcSummary Landing =
+                    FPSMovementTrajectory::Summarize(Arc, float(End.Z), MaxAirTime);
+                OutTime = Landing.EndTime;
+                return Landing.bEnds &&
+                       FVector::DistSquared2D(FromKernelVector(Landing.End), End) <= FMath::Square(CaptureRadius);
+            }
+
+            // Walls are caught from the front, where the jump passes closest to the node
+            const FVector Velocity2D(Arc.Velocity.X, Arc.Velocity.Y, 0.f);
+            const double SpeedSquared = Velocity2D.SizeSquared();
+            if ((Velocity2D | Columns[NodeColumns[Target]].Normal) >= 0.0 || SpeedSquared < 1.0)
+            {
+                return false;
+            }
+            const FVector Offset = End - FromKernelVector(Arc.Start);
+            OutTime = float((Offset.X * Velocity2D.X + Offset.Y * Velocity2D.Y) / SpeedSquared);
+            if (OutTime <= 0.f || OutTime > MaxAirTime)
+            {
+                return false;
+            }
+            const FVector Reached = FromKernelVector(FPSMovementTrajectory::Evaluate(Arc, OutTime).Position);
+            return FVector::DistSquared2D(Reached, End) <= FMath::Square(CaptureRadius) &&
+                   FMath::Abs(Reached.Z - End.Z) <= CaptureRadius;
+        }
+
+        bool IsClear(const FVector &Start, const FVector &End) const
+        {
+            return !World.LineTraceTestByChannel(Start, End, ECC_Pawn, QueryParams);
+        }
+
+        // Traces the capsule center along the first Time seconds of the arc
+        bool IsArcClear(const FPSMovementTrajectory::FArc &Arc, float Time) const
+        {
+            FVector Previous = FromKernelVector(Arc.Start);
+            for (int32 Segment = 1; Segment <= ArcTraceSegments; Segment++)
+            {
+                const FVector Next = FromKernelVector(
+                    FPSMovementTrajectory::Evaluate(Arc, Time * Segment / ArcTraceSegments).Position);
+                if (!IsClear(Previous, Next))
+                {
+                    return false;
+                }
+                Previous = Next;
+            }
+            return true;
+        }
+
+        // Checks for walkable floor within a step of the straight line between two floor nodes
+        bool HasFloorBetween(const FVector &Start, const FVector &End) const
+        {
+            const int32 NumChecks = FMath::Max(FMath::CeilToInt32(FVector::Dist2D(Start, End) / WalkCheckSpacing), 1);
+            for (int32 Check = 1; Check < NumChecks; Check++)
+            {
+                const FVector Point = FMath::Lerp(Start, End, float(Check) / NumChecks);
+                FHitResult Hit;
+                if (!World.LineTraceSingleByChannel(Hit, Point, Point - FVector(0.f, 0.f, HalfHeight + MaxStepHeight),
+                                                    ECC_Pawn, QueryParams) ||
+                    Hit.ImpactNormal.Z < WalkableFloorZ)
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        UWorld &World;
+        const FPSMovementKernel::FMovementParams &Params;
+        FCollisionQueryParams QueryParams;
+        float Radius;
+        float HalfHeight;
+        float WalkableFloorZ;
+        float MaxStepHeight;
+        float GravityZ;
+        // Height of the capsule center above the floor at the top of a jump
+        float JumpHeight;
+        TArray<FColumn> Columns;
+        // Column each node was placed in
+        TArray<int32> NodeColumns;
+    };
+#endif
+} // namespace
+
+void UFPSTraversalSubsystem::OnWorldBeginPlay(UWorld &InWorld)
+{
+    Super::OnWorldBeginPlay(InWorld);
+    LoadGraph();
+}
+
+void UFPSTraversalSubsystem::Deinitialize()
+{
+    Graph.Reset();
+    Super::Deinitialize();
+}
+
+bool UFPSTraversalSubsystem::BuildAndSave(const FPSMovementKernel::FMovementParams &Params)
+{
+#if WITH_EDITOR
+    UWorld &World = *GetWorld();
+    UFPSWallIndexSubsystem *WallIndex = World.GetSubsystem<UFPSWallIndexSubsystem>();
+    if (!WallIndex || !WallIndex->BuildAndSave())
+    {
+        UE_LOG(LogFPSMovement, Error, TEXT("Could not build the wall index the traversal graph is built from"));
+        return false;
+    }
+    if (World.GetGravityZ() >= 0.f || Params.WalkSpeed <= 0.f)
+    {
+        UE_LOG(LogFPSMovement, Error, TEXT("Traversal graphs need gravity pulling down and a walk speed"));
+        return false;
+    }
+
+    const double StartTime = FPlatformTime::Seconds();
+    FGraphBuilder Builder(World, Params);
+    Builder.AddColumns(WallIndex->GetIndex()->GetPatches());
+    Builder.AddJumpAndDropLinks();
+    Builder.AddWallRunLinks();
+    Builder.AddWallJumpLinks();
+    Builder.AddWalkLinks();
+
+    // The mapped file has to be let go of before it can be written
+    Graph.Reset();
+    const FString Path = GetGraphPath();
+    if (!FPSTraversal::FTraversalGraph::Save(Path, Builder.Nodes, Builder.NodeLinks))
+    {
+        UE_LOG(LogFPSMovement, Error, TEXT("Could not save traversal graph %s"), *Path);
+        return false;
+    }
+    int32 NumLinks[int32(FPSTraversal::ELinkType::Count)] = {};
+    for (const TArray<FPSTraversal::FLink> &Links : Builder.NodeLinks)
+    {
+        for (const FPSTraversal::FLink &Link : Links)
+        {
+            NumLinks[int32(Link.Type)]++;
+        }
+    }
+    UE_LOG(LogFPSMovement, Display,
+           TEXT("Saved %d traversal nodes to %s in %.1f s, with %d walk, %d wall run, %d jump, %d wall jump and %d "
+                "drop links"),
+           Builder.Nodes.Num(), *Path, FPlatformTime::Seconds() - StartTime, NumLinks[0], NumLinks[1], NumLinks[2],
+           NumLinks[3], NumLinks[4]);
+    LoadGraph();
+    return Graph.IsValid();
+#else
+    UE_LOG(LogFPSMovement, Error, TEXT("Traversal graphs can only be built in the editor"));
+    return false;
+#endif
+}
+
+bool UFPSTraversalSubsystem::FindPath(const FVector &Start, const FVector &Goal,
+                                      TArray<FPSTraversal::FPathStep> &OutPath)
+{
+    FPS_MOVEMENT_SCOPE(STAT_FPSTraversalPath);
+    check(IsInGameThread());
+    if (!Graph)
+    {
+        OutPath.Reset();
+        return false;
+    }
+    return Graph->FindPath(Start, Goal, MaxSnapDistance, Search, OutPath);
+}
+
+FString UFPSTraversalSubsystem::GetGraphPath() const
+{
+    const FString MapName = UWorld::RemovePIEPrefix(GetWorld()->GetMapName());
+    return FPaths::ProjectContentDir() / TEXT("Traversal") / MapName + TEXT(".fpsgraph");
+}
+
+void UFPSTraversalSubsystem::LoadGraph()
+{
+    const FString Path = GetGraphPath();
+    const double StartTime = FPlatformTime::Seconds();
+    Graph = FPSTraversal::FTraversalGraph::Load(Path);
+    const double Microseconds = (FPlatformTime::Seconds() - StartTime) * 1.e6;
+    if (Graph)
+    {
+        UE_LOG(LogFPSMovement, Display, TEXT("Mapped %d traversal nodes and %d links from %s in %.0f us"),
+               Graph->Num(), Graph->NumLinks(), *Path, Microseconds);
+        return;
+    }
+    UE_LOG(LogFPSMovement, Display, TEXT("No usable traversal graph at %s, run fps.Traversal.Build to build one"),
+           *Path);
+}
@@ -0,0 +1,51 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "FPSMovementKernel.h"
+#include "FPSTraversalGraph.h"
+#include "FPSTraversalSubsystem.generated.h"
+
+/**
+ * Maps the traversal graph of the current map when play begins, so bots can plan routes over wall runs and wall
+ * jumps without probing the level. The graph is saved under Content/Traversal and staged as loose files, which
+ * can be mapped.
+ *
+ * Build and save the graph for a map with the whole map loaded in the editor. This rebuilds and saves the wall
+ * index too, the graph is built from its walls:
+ *   fps.Traversal.Build [TuningAsset]
+ * Draw the path from the first player to a location:
+ *   fps.Traversal.Path X Y Z
+ */
+UCLASS()
+class MOVEMENT_REMAKE_API UFPSTraversalSubsystem : public UWorldSubsystem
+{
+    GENERATED_BODY()
+
+public:
+    virtual void OnWorldBeginPlay(UWorld &InWorld) override;
+    virtual void Deinitialize() override;
+
+    // Builds the graph for movement with these tuning values and saves it for the map, editor only
+    bool BuildAndSave(const FPSMovementKernel::FMovementParams &Params);
+
+    // See FPSTraversal::FTraversalGraph::FindPath, game thread only. False when the map has no graph.
+    bool FindPath(const FVector &Start, const FVector &Goal, TArray<FPSTraversal::FPathStep> &OutPath);
+
+    // Graph of the current map, null when it has none
+    const FPSTraversal::FTraversalGraph *GetGraph() const
+    {
+        return Graph.Get();
+    }
+
+private:
+    // File the graph of the current map is saved to
+    FString GetGraphPath() const;
+    // Maps the saved graph and logs how long that took
+    void LoadGraph();
+
+    TUniquePtr<FPSTraversal::FTraversalGraph> Graph;
+    FPSTraversal::FPathSearch Search;
+};
@@ -0,0 +1,221 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "FPSWallIndex.h"
+#include "FPSMovementKernel.h"
+#include "FPSMovementStats.h"
+#include "HAL/PlatformFileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+namespace FPSWallIndex
+{
+    void GetPatchAxes(const FVector3f &Normal, FVector3f &OutTangent, FVector3f &OutBitangent)
+    {
+        OutTangent = FVector3f(-Normal.Y, Normal.X, 0.f).GetSafeNormal();
+        OutBitangent = FVector3f::CrossProduct(Normal, OutTangent);
+    }
+
+    FWallIndex::FWallIndex(TArray<FPatch> &&InPatches, float InCellSize) : Patches(MoveTemp(InPatches))
+    {
+        CellSize = FMath::Max(InCellSize, 1.f);
+        UnpackPatches();
+
+        // Horizontal extent of every patch, walls are close to vertical so this is their footprint
+        TArray<FBox2f> Footprints;
+        Footprints.Reserve(QueryPatches.Num());
+        FBox2f Bounds(ForceInit);
+        for (const FQueryPatch &Patch : QueryPatches)
+        {
+            const FVector3f Side = Patch.Tangent * Patch.HalfWidth;
+            const FVector3f Up = Patch.Bitangent * Patch.HalfHeight;
+            const FVector2f Extent(FMath::Abs(Side.X) + FMath::Abs(Up.X), FMath::Abs(Side.Y) + FMath::Abs(Up.Y));
+            const FBox2f &Footprint = Footprints.Emplace_GetRef(FVector2f(Patch.Center) - Extent,
+                                                                FVector2f(Patch.Center) + Extent);
+            Bounds += Footprint;
+        }
+        if (QueryPatches.IsEmpty())
+        {
+            CellStarts.Init(0, 1);
+            return;
+        }
+        Origin = Bounds.Min;
+        NumCellsX = FMath::Max(FMath::CeilToInt32((Bounds.Max.X - Origin.X) / CellSize), 1);
+        NumCellsY = FMath::Max(FMath::CeilToInt32((Bounds.Max.Y - Origin.Y) / CellSize), 1);
+
+        // Counts the patches of each cell, then fills the cell lists in one flat array
+        auto ForEachCell = [this](const FBox2f &Footprint, auto &&Function)
+        {
+            const int32 MinX = FMath::Clamp(int32((Footprint.Min.X - Origin.X) / CellSize), 0, NumCellsX - 1);
+            const int32 MinY = FMath::Clamp(int32((Footprint.Min.Y - Origin.Y) / CellSize), 0, NumCellsY - 1);
+            const int32 MaxX = FMath::Clamp(int32((Footprint.Max.X - Origin.X) / CellSize), 0, NumCellsX - 1);
+            const int32 MaxY = FMath::Clamp(int32((Footprint.Max.Y - Origin.Y) / CellSize), 0, NumCellsY - 1);
+            for (int32 Y = MinY; Y <= MaxY; Y++)
+            {
+                for (int32 X = MinX; X <= MaxX; X++)
+                {
+                    Function(Y * NumCellsX + X);
+                }
+            }
+        };
+        CellStarts.SetNumZeroed(NumCellsX * NumCellsY + 1);
+        for (const FBox2f &Footprint : Footprints)
+        {
+            ForEachCell(Footprint, [this](int32 Cell) { CellStarts[Cell + 1]++; });
+        }
+        for (int32 Cell = 1; Cell < CellStarts.Num(); Cell++)
+        {
+            CellStarts[Cell] += CellStarts[Cell - 1];
+        }
+        CellEntries.SetNumUninitialized(CellStarts.Last());
+        TArray<uint32> NextEntry(CellStarts.GetData(), CellStarts.Num() - 1);
+        for (int32 Index = 0; Index < Footprints.Num(); Index++)
+        {
+            ForEachCell(Footprints[Index], [this, &NextEntry, Index](int32 Cell)
+                        { CellEntries[NextEntry[Cell]++] = uint32(Index); });
+        }
+    }
+
+    TUniquePtr<FWallIndex> FWallIndex::Load(const FString &Path)
+    {
+        TArray<uint8> Bytes;
+        if (!FPlatformFileManager::Get().GetPlatformFile().FileExists(*Path) ||
+            !FFileHelper::LoadFileToArray(Bytes, *Path))
+        {
+            return nullptr;
+        }
+        if (Bytes.Num() < int32(sizeof(FHeader)))
+        {
+            UE_LOG(LogFPSMovement, Error, TEXT("%s is not a wall index"), *Path);
+            return nullptr;
+        }
+        FHeader Header;
+        FMemory::Memcpy(&Header, Bytes.GetData(), sizeof(Header));
+        const int64 NumCells = int64(Header.NumCellsX) * Header.NumCellsY;
+        const int64 ExpectedSize = sizeof(FHeader) + int64(Header.NumPatches) * sizeof(FPatch) +
+                                   (NumCells + 1 + Header.NumCellEntries) * sizeof(uint32);
+        if (Header.Magic != Magic || Header.Version != Version || Header.PatchSize != sizeof(FPatch) ||
+            Bytes.Num() != ExpectedSize)
+        {
+            UE_LOG(LogFPSMovement, Error, TEXT("%s is not a version %d wall index"), *Path, Version);
+            return nullptr;
+        }
+
+        TUniquePtr<FWallIndex> Index(new FWallIndex());
+        const uint8 *Read = Bytes.GetData() + sizeof(FHeader);
+        auto ReadArray = [&Read](auto &Array, int64 Num)
+        {
+            Array.SetNumUninitialized(int32(Num));
+            FMemory::Memcpy(Array.GetData(), Read, Num * Array.GetTypeSize());
+            Read += Num * Array.GetTypeSize();
+        };
+        ReadArray(Index->Patches, Header.NumPatches);
+        ReadArray(Index->CellStarts, NumCells + 1);
+        ReadArray(Index->CellEntries, Header.NumCellEntries);
+
+        // Queries index the arrays with what the file says without checking, so a damaged file is rejected here
+        bool bValidCells = Index->CellStarts[0] == 0 && Index->CellStarts.Last() == Header.NumCellEntries &&
+                           (Header.NumPatches == 0 || NumCells > 0);
+        for (int32 Cell = 1; bValidCells && Cell < Index->CellStarts.Num(); Cell++)
+        {
+            bValidCells = Index->CellStarts[Cell - 1] <= Index->CellStarts[Cell];
+        }
+        for (int32 Entry = 0; bValidCells && Entry < Index->CellEntries.Num(); Entry++)
+        {
+            bValidCells = Index->CellEntries[Entry] < Header.NumPatches;
+        }
+        if (!bValidCells)
+        {
+            UE_LOG(LogFPSMovement, Error, TEXT("%s has cell lists outside its patches"), *Path);
+            return nullptr;
+        }
+        Index->NumCellsX = int32(Header.NumCellsX);
+        Index->NumCellsY = int32(Header.NumCellsY);
+        Index->Origin = FVector2f(Header.OriginX, Header.OriginY);
+        Index->CellSize = Header.CellSize;
+        Index->UnpackPatches();
+        return Index;
+    }
+
+    bool FWallIndex::Save(const FString &Path) const
+    {
+        const FHeader Header = {Magic,
+                                Version,
+                                uint16(sizeof(FPatch)),
+                                uint32(Patches.Num()),
+                                uint32(NumCellsX),
+                                uint32(NumCellsY),
+                                uint32(CellEntries.Num()),
+                                Origin.X,
+                                Origin.Y,
+                                CellSize};
+        TArray<uint8> Bytes;
+        Bytes.Append(reinterpret_cast<const uint8 *>(&Header), sizeof(Header));
+        Bytes.Append(reinterpret_cast<const uint8 *>(Patches.GetData()), Patches.Num() * sizeof(FPatch));
+        Bytes.Append(reinterpret_cast<const uint8 *>(CellStarts.GetData()), CellStarts.Num() * sizeof(uint32));
+        Bytes.Append(reinterpret_cast<const uint8 *>(CellEntries.GetData()), CellEntries.Num() * sizeof(uint32));
+        FPlatformFileManager::Get().GetPlatformFile().CreateDirectoryTree(*FPaths::GetPath(Path));
+        return FFileHelper::SaveArrayToFile(Bytes, *Path);
+    }
+
+    bool FWallIndex::FindWall(const FVector &Location, float Radius, float HalfHeight, FWallHit &OutHit) const
+    {
+        if (QueryPatches.IsEmpty())
+        {
+            return false;
+        }
+        const FVector3f Query(Location);
+        const int32 MinX = FMath::Clamp(int32((Query.X - Radius - Origin.X) / CellSize), 0, NumCellsX - 1);
+        const int32 MinY = FMath::Clamp(int32((Query.Y - Radius - Origin.Y) / CellSize), 0, NumCellsY - 1);
+        const int32 MaxX = FMath::Clamp(int32((Query.X + Radius - Origin.X) / CellSize), 0, NumCellsX - 1);
+        const int32 MaxY = FMath::Clamp(int32((Query.Y + Radius - Origin.Y) / CellSize), 0, NumCellsY - 1);
+
+        // A patch listed in several of the visited cells is tested more than once, which is cheaper than
+        // remembering which were seen
+        float BestDistance = Radius;
+        const FQueryPatch *Best = nullptr;
+        for (int32 Y = MinY; Y <= MaxY; Y++)
+        {
+            for (int32 X = MinX; X <= MaxX; X++)
+            {
+                const int32 Cell = Y * NumCellsX + X;
+                for (uint32 Entry = CellStarts[Cell]; Entry < CellStarts[Cell + 1]; Entry++)
+                {
+                    const FQueryPatch &Patch = QueryPatches[CellEntries[Entry]];
+                    const FVector3f Offset = Query - Patch.Center;
+                    const float Distance = Offset | Patch.Normal;
+                    if (Distance < 0.f || Distance > BestDistance ||
+                        FMath::Abs(Offset | Patch.Tangent) > Patch.HalfWidth ||
+                        FMath::Abs(Offset | Patch.Bitangent) > Patch.HalfHeight + HalfHeight)
+                    {
+                        continue;
+                    }
+                    BestDistance = Distance;
+                    Best = &Patch;
+                }
+            }
+        }
+        if (!Best)
+        {
+            return false;
+        }
+        OutHit.Normal = FVector(Best->Normal);
+        OutHit.Distance = BestDistance;
+        return true;
+    }
+
+    void FWallIndex::UnpackPatches()
+    {
+        QueryPatches.SetNumUninitialized(Patches.Num());
+        for (int32 Index = 0; Index < Patches.Num(); Index++)
+        {
+            const FPatch &Patch = Patches[Index];
+            FQueryPatch &QueryPatch = QueryPatches[Index];
+            const FPSMovementKernel::FVec3 Normal = FPSMovementKernel::UnpackWallNormal(Patch.Normal);
+            QueryPatch.Center = FVector3f(Patch.CenterX, Patch.CenterY, Patch.CenterZ);
+            QueryPatch.Normal = FVector3f(Normal.X, Normal.Y, Normal.Z);
+            GetPatchAxes(QueryPatch.Normal, QueryPatch.Tangent, QueryPatch.Bitangent);
+            QueryPatch.HalfWidth = Patch.HalfWidth;
+            QueryPatch.HalfHeight = Patch.HalfHeight;
+        }
+    }
+} // namespace FPSWallIndex
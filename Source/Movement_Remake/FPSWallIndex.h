@@ -0,0 +1,114 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include <type_traits>
+
+// Index of the wall runnable surfaces of a level: flat patches of static geometry that pass IsWall, bucketed
+// in a uniform grid over the XY plane. Built from the level's static meshes, checked against their collision
+// and saved next to the content, so movement can find the walls around a character without physics queries.
+namespace FPSWallIndex
+{
+    constexpr uint32 Magic = 0x57535046; // "FPSW"
+    // Version 2 patches are checked against the level's collision
+    constexpr uint16 Version = 2;
+
+    // Size of a grid cell, about the distance a wall runner covers in half a second
+    constexpr float DefaultCellSize = 512.f;
+
+    // Wall patch as stored in the file
+    struct FPatch
+    {
+        float CenterX;
+        float CenterY;
+        float CenterZ;
+        // Normal packed with FPSMovementKernel::PackWallNormal
+        uint32 Normal;
+        // Half size along the wall horizontally and up the wall
+        float HalfWidth;
+        float HalfHeight;
+    };
+
+    struct FHeader
+    {
+        uint32 Magic;
+        uint16 Version;
+        // Size of one patch, lets readers reject files written with a different layout
+        uint16 PatchSize;
+        uint32 NumPatches;
+        uint32 NumCellsX;
+        uint32 NumCellsY;
+        // Entries in the cell lists, a patch is listed once in every cell it crosses
+        uint32 NumCellEntries;
+        float OriginX;
+        float OriginY;
+        float CellSize;
+    };
+
+    static_assert(std::is_trivially_copyable_v<FPatch> && sizeof(FPatch) == 24);
+    static_assert(std::is_trivially_copyable_v<FHeader> && sizeof(FHeader) == 36);
+
+    // Nearest wall found by a query
+    struct FWallHit
+    {
+        FVector Normal;
+        // Distance from the query location to the wall plane
+        float Distance;
+    };
+
+    /** Uniform grid of wall patches, immutable once built. */
+    class MOVEMENT_REMAKE_API FWallIndex
+    {
+    public:
+        // Buckets the patches into cells of CellSize
+        explicit FWallIndex(TArray<FPatch> &&InPatches, float CellSize = DefaultCellSize);
+
+        // Reads an index written by Save, returns null when the file is missing or not an index
+        static TUniquePtr<FWallIndex> Load(const FString &Path);
+        bool Save(const FString &Path) const;
+
+        // Finds the closest wall whose front faces Location within Radius, and which spans Location to the side
+        // and within HalfHeight up or down. Only the cells around Location are visited.
+        bool FindWall(const FVector &Location, float Radius, float HalfHeight, FWallHit &OutHit) const;
+
+        int32 Num() const
+        {
+            return Patches.Num();
+        }
+        const TArray<FPatch> &GetPatches() const
+        {
+            return Patches;
+        }
+
+    private:
+        FWallIndex() = default;
+        // Unpacks the patches into the form queries use
+        void UnpackPatches();
+
+        // Patch in the form queries use, with its plane axes unpacked
+        struct FQueryPatch
+        {
+            FVector3f Center;
+            FVector3f Normal;
+            // Horizontal axis along the wall and the axis up the wall
+            FVector3f Tangent;
+            FVector3f Bitangent;
+            float HalfWidth;
+            float HalfHeight;
+        };
+
+        TArray<FPatch> Patches;
+        TArray<FQueryPatch> QueryPatches;
+        // Patches of cell C are CellEntries[CellStarts[C]] up to CellEntries[CellStarts[C + 1]]
+        TArray<uint32> CellStarts;
+        TArray<uint32> CellEntries;
+        int32 NumCellsX = 0;
+        int32 NumCellsY = 0;
+        FVector2f Origin = FVector2f::ZeroVector;
+        float CellSize = DefaultCellSize;
+    };
+
+    // Plane axes of a wall normal, the tangent is horizontal and the bitangent points up the wall
+    void GetPatchAxes(const FVector3f &Normal, FVector3f &OutTangent, FVector3f &OutBitangent);
+} // namespace FPSWallIndex
@@ -0,0 +1,380 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "FPSWallIndexSubsystem.h"
+#include "FPSMovementKernel.h"
+#include "FPSMovementStats.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "Components/StaticMeshComponent.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/Paths.h"
+#include "StaticMeshResources.h"
+
+namespace
+{
+    FAutoConsoleCommandWithWorld GWallIndexBuildCommand(
+        TEXT("fps.WallIndex.Build"),
+        TEXT("Builds the wall index from the static geometry loaded in the editor and saves it for the map"),
+        FConsoleCommandWithWorldDelegate::CreateLambda(
+            [](UWorld *World)
+            {
+                if (UFPSWallIndexSubsystem *WallIndex = World ? World->GetSubsystem<UFPSWallIndexSubsystem>() : nullptr)
+                {
+                    WallIndex->BuildAndSave();
+                }
+            }));
+
+#if WITH_EDITOR
+    // Walls narrower or shorter than this are not worth running on
+    constexpr float MinPatchSize = 50.f;
+
+    // Part of the rectangle around a set of triangles they have to cover to be one patch
+    constexpr float MinPatchFill = .98f;
+
+    // Wall triangle in the axes of its plane
+    struct FWallTriangle
+    {
+        // Packed normal and rounded plane distance, triangles with the same key are coplanar
+        TPair<uint32, int32> Key;
+        FVector3f Normal;
+        FVector3f Tangent;
+        FVector3f Bitangent;
+        float PlaneDistance;
+        FVector2f Corners[3];
+        float Area;
+        // Coplanar triangles sharing an edge with this one
+        TArray<int32, TInlineAllocator<3>> Neighbours;
+    };
+
+    // Bounds of a set of coplanar triangles in the plane's axes, and the area they cover
+    struct FPatchBuilder
+    {
+        FVector2f Min = FVector2f(UE_BIG_NUMBER);
+        FVector2f Max = FVector2f(-UE_BIG_NUMBER);
+        float Area = 0.f;
+
+        void Add(const FWallTriangle &Triangle)
+        {
+            for (const FVector2f &Corner : Triangle.Corners)
+            {
+                Min = Min.ComponentMin(Corner);
+                Max = Max.ComponentMax(Corner);
+            }
+            Area += Triangle.Area;
+        }
+        // A patch is a rectangle, triangles around a doorway or a window do not fill theirs
+        bool IsFilled() const
+        {
+            const FVector2f Size = Max - Min;
+            return Area >= Size.X * Size.Y * MinPatchFill;
+        }
+    };
+
+    // Spacing of the traces that check a patch against the level's collision, and how far in front of and
+    // behind the patch they reach
+    constexpr float PatchCheckSpacing = 50.f;
+    constexpr float PatchCheckDepth = 10.f;
+    // Cosine of the largest angle between a patch and the collision under it
+    constexpr float PatchCheckNormalTolerance = .99f;
+
+    int32 FindRoot(TArray<int32> &Parents, int32 Index)
+    {
+        while (Parents[Index] != Index)
+        {
+            Index = Parents[Index] = Parents[Parents[Index]];
+        }
+        return Index;
+    }
+
+    void AddPatch(const FWallTriangle &Plane, const FPatchBuilder &Builder, TArray<FPSWallIndex::FPatch> &OutPatches)
+    {
+        const FVector2f Size = Builder.Max - Builder.Min;
+        if (Size.X < MinPatchSize || Size.Y < MinPatchSize)
+        {
+            return;
+        }
+        const FVector2f Middle = (Builder.Min + Builder.Max) * .5f;
+        const FVector3f Center =
+            Plane.Normal * Plane.PlaneDistance + Plane.Tangent * Middle.X + Plane.Bitangent * Middle.Y;
+        OutPatches.Add({Center.X, Center.Y, Center.Z, Plane.Key.Key, Size.X * .5f, Size.Y * .5f});
+    }
+
+    // Adds the wall patches of one placed mesh. The render mesh stands in for the collision, which matches the
+    // boxes levels are blocked out with.
+    void AddMeshPatches(const UStaticMesh &Mesh, const FTransform &Transform, TArray<FPSWallIndex::FPatch> &OutPatches)
+    {
+        const FStaticMeshRenderData *RenderData = Mesh.GetRenderData();
+        if (!RenderData || RenderData->LODResources.IsEmpty())
+        {
+            return;
+        }
+        const FStaticMeshLODResources &LOD = RenderData->LODResources[0];
+        const FPositionVertexBuffer &Positions = LOD.VertexBuffers.PositionVertexBuffer;
+        const FIndexArrayView Indices = LOD.IndexBuffer.GetArrayView();
+        // Mirrored placements flip the winding
+        const bool bMirrored = Transform.GetDeterminant() < 0.f;
+
+        // Render vertices are split along UV and normal seams, so edges are matched by position
+        auto QuantizePosition = [](const FVector &Position)
+        {
+            return FIntVector(FMath::RoundToInt32(Position.X * 10.0), FMath::RoundToInt32(Position.Y * 10.0),
+                              FMath::RoundToInt32(Position.Z * 10.0));
+        };
+        TArray<FWallTriangle> Triangles;
+        TMap<TPair<FIntVector, FIntVector>, int32> EdgeTriangles;
+        for (int32 Index = 0; Index + 2 < Indices.Num(); Index += 3)
+        {
+            const FVector Corners[3] = {
+                Transform.TransformPosition(FVector(Positions.VertexPosition(Indices[Index]))),
+                Transform.TransformPosition(FVector(Positions.VertexPosition(Indices[Index + 1]))),
+                Transform.TransformPosition(FVector(Positions.VertexPosition(Indices[Index + 2])))};
+            // Front faces wind clockwise seen from the front, the same face normal the mesh builder computes
+            FVector Normal = ((Corners[2] - Corners[0]) ^ (Corners[1] - Corners[0])).GetSafeNormal();
+            if (bMirrored)
+            {
+                Normal = -Normal;
+            }
+            if (Normal.IsZero() || !FPSMovementKernel::IsWall({float(Normal.X), float(Normal.Y), float(Normal.Z)}))
+            {
+                continue;
+            }
+
+            // Works in the unpacked normal's axes so the patch matches what queries see
+            const int32 TriangleIndex = Triangles.AddDefaulted();
+            FWallTriangle &Triangle = Triangles[TriangleIndex];
+            const uint32 PackedNormal =
+                FPSMovementKernel::PackWallNormal({float(Normal.X), float(Normal.Y), float(Normal.Z)});
+            const FPSMovementKernel::FVec3 Unpacked = FPSMovementKernel::UnpackWallNormal(PackedNormal);
+            Triangle.Key = TPair<uint32, int32>(PackedNormal, FMath::RoundToInt32(Normal | Corners[0]));
+            Triangle.Normal = FVector3f(Unpacked.X, Unpacked.Y, Unpacked.Z);
+            FPSWallIndex::GetPatchAxes(Triangle.Normal, Triangle.Tangent, Triangle.Bitangent);
+            Triangle.PlaneDistance = FVector3f(Corners[0]) | Triangle.Normal;
+            for (int32 Corner = 0; Corner < 3; Corner++)
+            {
+                const FVector3f Point(Corners[Corner]);
+                Triangle.Corners[Corner] = FVector2f(Point | Triangle.Tangent, Point | Triangle.Bitangent);
+            }
+            Triangle.Area =
+                FMath::Abs(FVector2f::CrossProduct(Triangle.Corners[1] - Triangle.Corners[0],
+                                                   Triangle.Corners[2] - Triangle.Corners[0])) * .5f;
+
+            // Links the triangle to coplanar triangles that share one of its edges
+            for (int32 Corner = 0; Corner < 3; Corner++)
+            {
+                FIntVector A = QuantizePosition(Corners[Corner]);
+                FIntVector B = QuantizePosition(Corners[(Corner + 1) % 3]);
+                if (B.X < A.X || (B.X == A.X && (B.Y < A.Y || (B.Y == A.Y && B.Z < A.Z))))
+                {
+                    Swap(A, B);
+                }
+                int32 &EdgeTriangle = EdgeTriangles.FindOrAdd(TPair<FIntVector, FIntVector>(A, B), INDEX_NONE);
+                if (EdgeTriangle == INDEX_NONE)
+                {
+                    EdgeTriangle = TriangleIndex;
+                }
+                else if (Triangles[EdgeTriangle].Key == Triangle.Key)
+                {
+                    Triangles[EdgeTriangle].Neighbours.Add(TriangleIndex);
+                    Triangle.Neighbours.Add(EdgeTriangle);
+                }
+            }
+        }
+
+        // Coplanar triangles connected through shared edges merge into one patch when they fill a rectangle
+        TArray<int32> Parents;
+        Parents.SetNumUninitialized(Triangles.Num());
+        for (int32 Index = 0; Index < Triangles.Num(); Index++)
+        {
+            Parents[Index] = Index;
+        }
+        for (int32 Index = 0; Index < Triangles.Num(); Index++)
+        {
+            for (const int32 Neighbour : Triangles[Index].Neighbours)
+            {
+                Parents[FindRoot(Parents, Index)] = FindRoot(Parents, Neighbour);
+            }
+        }
+        TMap<int32, FPatchBuilder> Builders;
+        for (int32 Index = 0; Index < Triangles.Num(); Index++)
+        {
+            Builders.FindOrAdd(FindRoot(Parents, Index)).Add(Triangles[Index]);
+        }
+
+        // Walls with holes in them fall back to the quads they are made of
+        TArray<bool> Paired;
+        Paired.SetNumZeroed(Triangles.Num());
+        for (int32 Index = 0; Index < Triangles.Num(); Index++)
+        {
+            const FPatchBuilder &Builder = Builders.FindChecked(FindRoot(Parents, Index));
+            if (Builder.IsFilled())
+            {
+                if (Parents[Index] == Index)
+                {
+                    AddPatch(Triangles[Index], Builder, OutPatches);
+                }
+                continue;
+            }
+            if (Paired[Index])
+            {
+                continue;
+            }
+            for (const int32 Neighbour : Triangles[Index].Neighbours)
+            {
+                FPatchBuilder Quad;
+                Quad.Add(Triangles[Index]);
+                Quad.Add(Triangles[Neighbour]);
+                if (!Paired[Neighbour] && Quad.IsFilled())
+                {
+                    Paired[Index] = Paired[Neighbour] = true;
+                    AddPatch(Triangles[Index], Quad, OutPatches);
+                    break;
+                }
+            }
+        }
+    }
+
+    // Keeps the parts of a patch the level's collision agrees with, so movement can trust the index without
+    // sweeping. Traces a grid over the patch and cuts out every column up the wall where one misses, which
+    // drops walls covered by other geometry, collision that differs from the render mesh and gaps the patch
+    // spans.
+    void AddCheckedPatches(const UWorld &World, const FPSWallIndex::FPatch &Patch,
+                           TArray<FPSWallIndex::FPatch> &OutPatches)
+    {
+        const FPSMovementKernel::FVec3 Unpacked = FPSMovementKernel::UnpackWallNormal(Patch.Normal);
+        const FVector3f Normal(Unpacked.X, Unpacked.Y, Unpacked.Z);
+        FVector3f Tangent;
+        FVector3f Bitangent;
+        FPSWallIndex::GetPatchAxes(Normal, Tangent, Bitangent);
+        const FVector3f Center(Patch.CenterX, Patch.CenterY, Patch.CenterZ);
+        const FVector3f Corner = Center - Tangent * Patch.HalfWidth - Bitangent * Patch.HalfHeight;
+        const int32 NumColumns = FMath::Max(FMath::FloorToInt32(2.f * Patch.HalfWidth / PatchCheckSpacing), 1);
+        const int32 NumRows = FMath::Max(FMath::FloorToInt32(2.f * Patch.HalfHeight / PatchCheckSpacing), 1);
+        const float ColumnWidth = 2.f * Patch.HalfWidth / NumColumns;
+        const float RowHeight = 2.f * Patch.HalfHeight / NumRows;
+        const FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(WallIndexBuild), false);
+
+        // Runs of columns that hit everywhere become patches, the column past the end closes the last run
+        int32 RunStart = 0;
+        for (int32 Column = 0; Column <= NumColumns; Column++)
+        {
+            bool bHit = Column < NumColumns;
+            for (int32 Row = 0; bHit && Row < NumRows; Row++)
+            {
+                const FVector3f Point =
+                    Corner + Tangent * ((Column + .5f) * ColumnWidth) + Bitangent * ((Row + .5f) * RowHeight);
+                FHitResult Hit;
+                bHit = World.LineTraceSingleByChannel(Hit, FVector(Point + Normal * PatchCheckDepth),
+                                                      FVector(Point - Normal * PatchCheckDepth), ECC_Pawn,
+                                                      QueryParams) &&
+                       !Hit.bStartPenetrating && (FVector3f(Hit.ImpactNormal) | Normal) >= PatchCheckNormalTolerance;
+            }
+            if (bHit)
+            {
+                continue;
+            }
+            const float HalfWidth = (Column - RunStart) * ColumnWidth * .5f;
+            if (2.f * HalfWidth >= MinPatchSize)
+            {
+                const FVector3f RunCenter = Corner + Tangent * (RunStart * ColumnWidth + HalfWidth) +
+                                            Bitangent * Patch.HalfHeight;
+                OutPatches.Add({RunCenter.X, RunCenter.Y, RunCenter.Z, Patch.Normal, HalfWidth, Patch.HalfHeight});
+            }
+            RunStart = Column + 1;
+        }
+    }
+
+    // Gathers the wall patches of every static mesh the player collides with and checks them against the level
+    TUniquePtr<FPSWallIndex::FWallIndex> BuildWallIndex(UWorld &World)
+    {
+        TArray<FPSWallIndex::FPatch> Patches;
+        for (TActorIterator<AActor> It(&World); It; ++It)
+        {
+            It->ForEachComponent<UStaticMeshComponent>(
+                false,
+                [&Patches](const UStaticMeshComponent *Component)
+                {
+                    const UStaticMesh *Mesh = Component->GetStaticMesh();
+                    if (!Mesh || Component->Mobility != EComponentMobility::Static ||
+                        !Component->IsCollisionEnabled() ||
+                        Component->GetCollisionResponseToChannel(ECC_Pawn) != ECR_Block)
+                    {
+                        return;
+                    }
+                    if (const UInstancedStaticMeshComponent *Instanced =
+                            Cast<UInstancedStaticMeshComponent>(Component))
+                    {
+                        for (int32 Instance = 0; Instance < Instanced->GetInstanceCount(); Instance++)
+                        {
+                            FTransform Transform;
+                            Instanced->GetInstanceTransform(Instance, Transform, true);
+                            AddMeshPatches(*Mesh, Transform, Patches);
+                        }
+                    }
+                    else
+                    {
+                        AddMeshPatches(*Mesh, Component->GetComponentTransform(), Patches);
+                    }
+                });
+        }
+        TArray<FPSWallIndex::FPatch> CheckedPatches;
+        for (const FPSWallIndex::FPatch &Patch : Patches)
+        {
+            AddCheckedPatches(World, Patch, CheckedPatches);
+        }
+        UE_LOG(LogFPSMovement, Display, TEXT("Checked %d wall patches against collision, kept %d"), Patches.Num(),
+               CheckedPatches.Num());
+        return MakeUnique<FPSWallIndex::FWallIndex>(MoveTemp(CheckedPatches));
+    }
+#endif
+} // namespace
+
+void UFPSWallIndexSubsystem::OnWorldBeginPlay(UWorld &InWorld)
+{
+    Super::OnWorldBeginPlay(InWorld);
+    const FString Path = GetIndexPath();
+    Index = FPSWallIndex::FWallIndex::Load(Path);
+    if (Index)
+    {
+        UE_LOG(LogFPSMovement, Display, TEXT("Loaded %d wall patches from %s"), Index->Num(), *Path);
+        return;
+    }
+#if WITH_EDITOR
+    Index = BuildWallIndex(InWorld);
+    UE_LOG(LogFPSMovement, Display,
+           TEXT("No wall index at %s, built %d wall patches from loaded geometry. Run fps.WallIndex.Build to save "
+                "one."),
+           *Path, Index->Num());
+#endif
+}
+
+void UFPSWallIndexSubsystem::Deinitialize()
+{
+    Index.Reset();
+    Super::Deinitialize();
+}
+
+bool UFPSWallIndexSubsystem::BuildAndSave()
+{
+#if WITH_EDITOR
+    Index = BuildWallIndex(*GetWorld());
+    const FString Path = GetIndexPath();
+    if (!Index->Save(Path))
+    {
+        UE_LOG(LogFPSMovement, Error, TEXT("Could not save wall index %s"), *Path);
+        return false;
+    }
+    UE_LOG(LogFPSMovement, Display, TEXT("Saved %d wall patches to %s"), Index->Num(), *Path);
+    return true;
+#else
+    UE_LOG(LogFPSMovement, Error, TEXT("Wall indices can only be built in the editor"));
+    return false;
+#endif
+}
+
+FString UFPSWallIndexSubsystem::GetIndexPath() const
+{
+    const FString MapName = UWorld::RemovePIEPrefix(GetWorld()->GetMapName());
+    return FPaths::ProjectContentDir() / TEXT("WallIndex") / MapName + TEXT(".fpswalls");
+}
@@ -0,0 +1,46 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "FPSWallIndex.h"
+#include "FPSWallIndexSubsystem.generated.h"
+
+/**
+ * Loads the wall index of the current map when play begins. The index is saved under Content/WallIndex and
+ * staged with the game. When a map has none, the editor builds one from the static geometry that is loaded,
+ * without saving it.
+ *
+ * Build and save the index for a map with the whole map loaded in the editor:
+ *   fps.WallIndex.Build
+ */
+UCLASS()
+class MOVEMENT_REMAKE_API UFPSWallIndexSubsystem : public UWorldSubsystem
+{
+    GENERATED_BODY()
+
+public:
+    virtual void OnWorldBeginPlay(UWorld &InWorld) override;
+    virtual void Deinitialize() override;
+
+    // Builds the index from the static geometry loaded in the world and saves it for the map, editor only
+    bool BuildAndSave();
+
+    // See FPSWallIndex::FWallIndex::FindWall, false when the map has no index
+    bool FindWall(const FVector &Location, float Radius, float HalfHeight, FPSWallIndex::FWallHit &OutHit) const
+    {
+        return Index && Index->FindWall(Location, Radius, HalfHeight, OutHit);
+    }
+    // Index of the current map, null when it has none
+    const FPSWallIndex::FWallIndex *GetIndex() const
+    {
+        return Index.Get();
+    }
+
+private:
+    // File the index of the current map is saved to
+    FString GetIndexPath() const;
+
+    TUniquePtr<FPSWallIndex::FWallIndex> Index;
+};
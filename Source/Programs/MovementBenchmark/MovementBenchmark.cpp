@@ -0,0 +1,325 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+// Steps a crowd of simulated characters through the movement kernel without the engine.
+// Build and run on Linux from the repository root:
+//   cmake -S Source/Programs -B Build/Programs && cmake --build Build/Programs --target MovementBenchmark
+//   Build/Programs/MovementBenchmark [Characters] [Frames]
+#include "FPSMovementKernel.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using namespace FPSMovementKernel;
+
+namespace
+{
+    // Simplified world: flat floor at Z = 0 with two walls either side of a corridor
+    constexpr float WallOffsetY = 400.f;
+    constexpr float CapsuleRadius = 34.f;
+    constexpr float CapsuleHalfHeight = 88.f;
+    constexpr float GravityZ = -980.f;
+    constexpr float GroundFriction = 8.f;
+    constexpr float FrameTime = 1.f / 60.f;
+    // Length of one scripted walk, slide, jump, wall run and wall jump loop
+    constexpr float ScriptLength = 4.f;
+    // Players on a full server, checked by the movement validator every frame
+    constexpr int ValidatedPlayers = 100;
+    // Frames a rollback rewinds and resimulates, about 130 ms at 60 Hz
+    constexpr int RollbackFrames = 8;
+
+    enum class ESimMode : uint8_t
+    {
+        Walking,
+        Sliding,
+        Falling,
+        WallRunning,
+    };
+
+    // Scripted input for one frame
+    struct FSimInput
+    {
+        float Forward;
+        float Right;
+        bool bCrouch;
+        bool bJump;
+    };
+
+    struct FSimCharacter
+    {
+        FVec3 Position;
+        FMovementState Move;
+        FViewState View;
+        ESimMode Mode;
+        // Offsets each character along the script so they do not all change state together
+        float ScriptOffset;
+    };
+
+    FSimInput GetScriptedInput(float Time)
+    {
+        const float T = std::fmod(Time, ScriptLength);
+        FSimInput Input = {1.f, 0.f, false, false};
+        if (T >= 1.f && T < 1.6f)
+        {
+            Input.bCrouch = true;
+        }
+        if (T >= 1.6f && T < 1.65f)
+        {
+            Input.Right = 1.f;
+            Input.bJump = true;
+        }
+        if (T >= 1.65f && T < 3.f)
+        {
+            Input.Right = 1.f;
+        }
+        if (T >= 3.f && T < 3.05f)
+        {
+            Input.bJump = true;
+        }
+        return Input;
+    }
+
+    // Ground movement with friction towards the input direction, like CalcVelocity
+    void ApplyGroundVelocity(FSimCharacter &Character, const FSimInput &Input, float MaxSpeed, float Friction,
+                             float DeltaTime)
+    {
+        const FVec3 WishDirection = GetSafeNormal({Input.Forward, Input.Right, 0.f});
+        FVec3 &Velocity = Character.Move.Velocity;
+        const float Speed = std::sqrt(SizeSquared(Velocity));
+        Velocity = Velocity - (Velocity - WishDirection * Speed) * std::fmin(DeltaTime * Friction, 1.f);
+        Velocity += WishDirection * (2048.f * DeltaTime);
+        const float NewSpeed = std::sqrt(SizeSquared(Velocity));
+        if (NewSpeed > MaxSpeed && NewSpeed > Speed)
+        {
+            Velocity = Velocity * ((Speed > MaxSpeed ? Speed : MaxSpeed) / NewSpeed);
+        }
+    }
+
+    void StepCharacter(FSimCharacter &Character, const FMovementParams &Params, float Time, float DeltaTime)
+    {
+        const FSimInput Input = GetScriptedInput(Time + Character.ScriptOffset);
+        FMovementState &Move = Character.Move;
+        if (Params.bCapsuleCrouch && Move.bWantsToSlide != Input.bCrouch)
+        {
+            // The capsule changes height around its base, the camera starts from where it was
+            const float HalfHeightAdjust = CapsuleHalfHeight * (Params.NormalScaleZ - Params.CrouchScaleZ);
+            OffsetCrouchCamera(Character.View, Input.bCrouch ? HalfHeightAdjust : -HalfHeightAdjust);
+        }
+        Move.bWantsToSlide = Input.bCrouch;
+
+        // Mode transitions, in the same order as the movement component
+        if (Character.Mode == ESimMode::Walking && !Move.bWantsToSlide)
+        {
+            Move.bAppliedSlideForce = false;
+        }
+        if (Character.Mode == ESimMode::Walking && Move.bWantsToSlide)
+        {
+            TryApplySlideImpulse(Move, Params);
+            Character.Mode = ESimMode::Sliding;
+        }
+        else if (Character.Mode == ESimMode::Sliding && !Move.bWantsToSlide)
+        {
+            Character.Mode = ESimMode::Walking;
+        }
+        if (Input.bJump)
+        {
+            if (Character.Mode == ESimMode::WallRunning)
+            {
+                Move.Velocity = WallJump(Move, Params);
+                Character.Mode = ESimMode::Falling;
+            }
+            else if (Character.Mode == ESimMode::Walking || Character.Mode == ESimMode::Sliding)
+            {
+                Move.Velocity.Z = 420.f;
+                Character.Mode = ESimMode::Falling;
+            }
+        }
+        if (Character.Mode == ESimMode::Falling && Move.bIsOnWall)
+        {
+            StartWallRun(Move, Params, {0.f, 1.f, 0.f});
+            Character.Mode = ESimMode::WallRunning;
+        }
+
+        // Velocity update for the current mode
+        switch (Character.Mode)
+        {
+        case ESimMode::Walking:
+            ApplyGroundVelocity(Character, Input, Params.WalkSpeed, GroundFriction, DeltaTime);
+            break;
+        case ESimMode::Sliding:
+            // The corridor floor is flat, use a slight incline so the slope term is exercised
+            Move.Velocity += SlopeSlideAcceleration({0.f, 0.0995f, 0.995f}, Params) * DeltaTime;
+            Move.Velocity.Z = 0.f;
+            ApplyGroundVelocity(Character, Input, Params.CrouchSpeed, Params.SlideFriction, DeltaTime);
+            break;
+        case ESimMode::Falling:
+            Move.Velocity.Z += GravityZ * DeltaTime;
+            break;
+        case ESimMode::WallRunning:
+            Move.Velocity.Z += GravityZ * DeltaTime;
+            Move.Velocity += WallRunAcceleration(Move, Params, {0.f, 0.f, -1.f}) * DeltaTime;
+            break;
+        }
+
+        // Moves and resolves contacts with the floor and walls
+        Character.Position += Move.Velocity * DeltaTime;
+        const bool bOnGround = Character.Mode == ESimMode::Walking || Character.Mode == ESimMode::Sliding;
+        Move.bIsOnWall = false;
+        const float WallY = WallOffsetY - CapsuleRadius;
+        if (Character.Position.Y >= WallY || Character.Position.Y <= -WallY)
+        {
+            const float Side = Character.Position.Y > 0.f ? 1.f : -1.f;
+            Character.Position.Y = WallY * Side;
+            Move.Velocity.Y = 0.f;
+            NotifyWallContact(Move, {0.f, -Side, 0.f}, bOnGround);
+        }
+        if (Character.Position.Z <= CapsuleHalfHeight && !bOnGround)
+        {
+            Character.Position.Z = CapsuleHalfHeight;
+            Move.Velocity.Z = 0.f;
+            Land(Move);
+            Character.Mode = Move.bWantsToSlide ? ESimMode::Sliding : ESimMode::Walking;
+        }
+        if (Character.Mode == ESimMode::WallRunning && !Move.bIsOnWall)
+        {
+            Character.Mode = ESimMode::Falling;
+        }
+
+        // Camera tilt and crouch transition
+        const FViewStep Step =
+            UpdateView(Character.View, Move, Params, Move.bWantsToSlide, Character.Mode == ESimMode::WallRunning,
+                       DeltaTime);
+        Character.Position.Z += Step.Crouch.LocationDeltaZ;
+    }
+
+    using FSimSnapshotRing = TSnapshotRing<FSimCharacter, 64>;
+} // namespace
+
+int main(int ArgC, char **ArgV)
+{
+    const int NumCharacters = ArgC > 1 ? std::atoi(ArgV[1]) : 100000;
+    const int NumFrames = ArgC > 2 ? std::atoi(ArgV[2]) : 600;
+    const FMovementParams Params = MakeDefaultParams();
+
+    std::vector<FSimCharacter> Characters(NumCharacters);
+    for (int Index = 0; Index < NumCharacters; Index++)
+    {
+        FSimCharacter &Character = Characters[Index];
+        Character = {};
+        Character.Position = {0.f, 0.f, CapsuleHalfHeight};
+        Character.View.CrouchScaleZ = Params.NormalScaleZ;
+        Character.Mode = ESimMode::Walking;
+        Character.ScriptOffset = ScriptLength * float(Index % 997) / 997.f;
+    }
+
+    std::vector<double> FrameMs(NumFrames);
+    // Frame to frame moves of the first characters, checked like the server validator does
+    const int NumValidated = NumCharacters < ValidatedPlayers ? NumCharacters : ValidatedPlayers;
+    std::vector<FMoveSample> Samples(NumValidated);
+    // Whether the slide impulse had been applied before the frame, the impulse is flagged on the frame it lands
+    std::vector<char> HadSlideForce(NumValidated);
+    std::vector<float> CarriedSpeeds(NumValidated, 0.f);
+    double ValidateMs = 0.0;
+    int NumViolations = 0;
+    // Snapshots of the validated players, saved every frame like the characters do for rollback
+    std::vector<FSimSnapshotRing> Histories(NumValidated);
+    double SnapshotMs = 0.0;
+    const auto Start = std::chrono::steady_clock::now();
+    for (int Frame = 0; Frame < NumFrames; Frame++)
+    {
+        const auto FrameStart = std::chrono::steady_clock::now();
+        const float Time = Frame * FrameTime;
+        for (int Index = 0; Index < NumValidated; Index++)
+        {
+            const FSimCharacter &Character = Characters[Index];
+            Samples[Index].Delta = Character.Position;
+            Samples[Index].Flags = (Character.Mode == ESimMode::Sliding ? MoveSampleSliding : 0) |
+                                   (Character.Mode == ESimMode::WallRunning ? MoveSampleWallRunning : 0) |
+                                   (Character.Move.bIsOnWall || Character.Move.bIsWallrunning ? MoveSampleOnWall : 0);
+            HadSlideForce[Index] = Character.Move.bAppliedSlideForce;
+        }
+        for (FSimCharacter &Character : Characters)
+        {
+            StepCharacter(Character, Params, Time, FrameTime);
+        }
+        FrameMs[Frame] =
+            std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - FrameStart).count();
+
+        const auto ValidateStart = std::chrono::steady_clock::now();
+        for (int Index = 0; Index < NumValidated; Index++)
+        {
+            FMoveSample &Sample = Samples[Index];
+            Sample.Delta = Characters[Index].Position - Sample.Delta;
+            Sample.DeltaTime = FrameTime;
+            if (!HadSlideForce[Index] && Characters[Index].Move.bAppliedSlideForce)
+            {
+                Sample.Flags |= MoveSampleSlideImpulse;
+            }
+            const FMoveCheck Check = CheckMove(Sample, Params, CarriedSpeeds[Index], 1.15f);
+            CarriedSpeeds[Index] = Check.CarriedSpeed;
+            NumViolations += Check.Violations != 0;
+        }
+        ValidateMs +=
+            std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - ValidateStart).count();
+
+        const auto SnapshotStart = std::chrono::steady_clock::now();
+        for (int Index = 0; Index < NumValidated; Index++)
+        {
+            Histories[Index].Save(Frame, Characters[Index]);
+        }
+        SnapshotMs +=
+            std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - SnapshotStart).count();
+    }
+    const double TotalMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - Start).count();
+
+    // Rewinds each validated player and resimulates the last frames from its snapshot on a copy, and checks the
+    // replay ends where the live simulation did
+    double RollbackMs = 0.0;
+    int NumRollbacks = 0;
+    int NumDesyncs = 0;
+    const int RollbackFrame = NumFrames - 1 - RollbackFrames;
+    for (int Index = 0; Index < NumValidated && RollbackFrame >= 0; Index++)
+    {
+        const FSimCharacter *Snapshot = Histories[Index].Find(RollbackFrame);
+        if (!Snapshot)
+        {
+            continue;
+        }
+        const auto RollbackStart = std::chrono::steady_clock::now();
+        FSimCharacter Replayed = *Snapshot;
+        for (int Frame = RollbackFrame + 1; Frame < NumFrames; Frame++)
+        {
+            StepCharacter(Replayed, Params, Frame * FrameTime, FrameTime);
+        }
+        RollbackMs +=
+            std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - RollbackStart).count();
+        NumRollbacks++;
+        const FVec3 &Live = Characters[Index].Position;
+        NumDesyncs += Replayed.Position.X != Live.X || Replayed.Position.Y != Live.Y || Replayed.Position.Z != Live.Z;
+    }
+
+    double WorstMs = 0.0;
+    for (double Ms : FrameMs)
+    {
+        WorstMs = Ms > WorstMs ? Ms : WorstMs;
+    }
+    // Sum of final positions, changes when the movement results change
+    double Checksum = 0.0;
+    for (const FSimCharacter &Character : Characters)
+    {
+        Checksum += Character.Position.X + Character.Position.Y + Character.Position.Z + Character.View.CameraRoll +
+                    Character.View.CrouchCameraOffsetZ;
+    }
+
+    std::printf("characters=%d frames=%d\n", NumCharacters, NumFrames);
+    std::printf("total_ms=%.3f avg_frame_ms=%.3f worst_frame_ms=%.3f ns_per_step=%.2f\n", TotalMs,
+                TotalMs / NumFrames, WorstMs, TotalMs * 1.e6 / (double(NumCharacters) * NumFrames));
+    std::printf("validate_%d_players_ns=%.1f violations=%d\n", NumValidated, ValidateMs * 1.e6 / NumFrames,
+                NumViolations);
+    std::printf("snapshot_%d_players_ns=%.1f rollback_%d_frames_ns=%.1f desyncs=%d\n", NumValidated,
+                SnapshotMs * 1.e6 / NumFrames, RollbackFrames,
+                NumRollbacks > 0 ? RollbackMs * 1.e6 / NumRollbacks : 0.0, NumDesyncs);
+    std::printf("checksum=%.4f\n", Checksum);
+    return 0;
+}
@@ -0,0 +1,81 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+// Converts movement telemetry files from Saved/Telemetry to CSV on standard output, without the engine.
+// Pass the parts of a session in order to get one table. Build and run on Linux from the repository root:
+//   cmake -S Source/Programs -B Build/Programs && cmake --build Build/Programs --target MovementTelemetryDecoder
+//   Build/Programs/MovementTelemetryDecoder Saved/Telemetry/TestMap-Server-*.fpstelemetry > Telemetry.csv
+#include "FPSMovementTelemetry.h"
+
+#include <cstdio>
+
+using namespace FPSMovementTelemetry;
+
+namespace
+{
+    // Names of EMovementMode and EFPSCustomMovementMode values
+    const char *GetModeName(uint8_t Mode, uint8_t CustomMode)
+    {
+        static const char *const ModeNames[] = {"None", "Walking", "NavWalking", "Falling", "Swimming", "Flying"};
+        static const char *const CustomModeNames[] = {"Custom", "Slide", "WallRun", "Mantle"};
+        constexpr uint8_t MoveCustom = 6;
+        if (Mode < MoveCustom)
+        {
+            return ModeNames[Mode];
+        }
+        return Mode == MoveCustom && CustomMode < 4 ? CustomModeNames[CustomMode] : "Unknown";
+    }
+
+    // Writes the records of one file, returns false when it is not a telemetry file
+    bool DecodeFile(const char *Path, unsigned long long &NumRecords)
+    {
+        FILE *File = std::fopen(Path, "rb");
+        if (!File)
+        {
+            std::fprintf(stderr, "Could not open %s\n", Path);
+            return false;
+        }
+        FHeader Header;
+        if (std::fread(&Header, sizeof(Header), 1, File) != 1 || Header.Magic != Magic || Header.Version != Version ||
+            Header.RecordSize != sizeof(FRecord))
+        {
+            std::fprintf(stderr, "%s is not a version %u movement telemetry file\n", Path, unsigned(Version));
+            std::fclose(File);
+            return false;
+        }
+        FRecord Records[1024];
+        size_t NumRead;
+        while ((NumRead = std::fread(Records, sizeof(FRecord), 1024, File)) > 0)
+        {
+            for (size_t Index = 0; Index < NumRead; Index++)
+            {
+                const FRecord &Record = Records[Index];
+                std::printf("%.4f,%u,%s,%s,%.2f,%.2f,%.2f,%.4f,%.4f,%.4f\n", Record.Time, Record.CharacterId,
+                            GetEventName(Record.Event), GetModeName(Record.MovementMode, Record.CustomMovementMode),
+                            Record.Velocity[0], Record.Velocity[1], Record.Velocity[2], Record.FloorNormal[0],
+                            Record.FloorNormal[1], Record.FloorNormal[2]);
+            }
+            NumRecords += NumRead;
+        }
+        std::fclose(File);
+        return true;
+    }
+} // namespace
+
+int main(int Argc, char **Argv)
+{
+    if (Argc < 2)
+    {
+        std::fprintf(stderr, "Usage: %s <File.fpstelemetry>... > Telemetry.csv\n", Argv[0]);
+        return 1;
+    }
+    std::printf("Time,CharacterId,Event,MovementMode,VelocityX,VelocityY,VelocityZ,FloorNormalX,FloorNormalY,"
+                "FloorNormalZ\n");
+    unsigned long long NumRecords = 0;
+    int NumFailed = 0;
+    for (int Arg = 1; Arg < Argc; Arg++)
+    {
+        NumFailed += DecodeFile(Argv[Arg], NumRecords) ? 0 : 1;
+    }
+    std::fprintf(stderr, "Decoded %llu records from %d files\n", NumRecords, Argc - 1 - NumFailed);
+    return NumFailed == 0 ? 0 : 1;
+}
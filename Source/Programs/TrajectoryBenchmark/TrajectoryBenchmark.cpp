@@ -0,0 +1,156 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+// Times batched trajectory predictions and checks them against stepping the same physics in small steps,
+// without the engine. Build and run on Linux from the repository root:
+//   cmake -S Source/Programs -B Build/Programs && cmake --build Build/Programs --target TrajectoryBenchmark
+//   Build/Programs/TrajectoryBenchmark [Predictions] [Frames]
+#include "FPSMovementTrajectory.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+using namespace FPSMovementKernel;
+using namespace FPSMovementTrajectory;
+
+namespace
+{
+    constexpr float GravityZ = -980.f;
+    constexpr float BrakingDecelerationWalking = 2048.f;
+    // Furthest ahead bots and aim assist look
+    constexpr float MaxPredictionTime = 2.f;
+    // Step of the reference simulation
+    constexpr float ReferenceStep = 1.f / 2000.f;
+
+    // Arcs in the mix a frame of bot and aim assist queries would ask for
+    FArc MakeRandomArc(std::mt19937 &Random, const FMovementParams &Params)
+    {
+        std::uniform_real_distribution<float> Unit(-1.f, 1.f);
+        FMovementState State = {};
+        State.Velocity = {Unit(Random) * 800.f, Unit(Random) * 800.f, Unit(Random) * 400.f};
+        const float WallYaw = Unit(Random) * 3.14159f;
+        State.WallNormal = {std::cos(WallYaw), std::sin(WallYaw), 0.f};
+        State.bIsWallrunning = Random() % 2 == 0;
+        const FVec3 Location = {Unit(Random) * 5000.f, Unit(Random) * 5000.f, 200.f + Unit(Random) * 100.f};
+        switch (Random() % 5)
+        {
+        case 0:
+            return MakeFallArc(Location, State.Velocity, GravityZ);
+        case 1:
+            return MakeWallJumpArc(State, Params, Location, GravityZ);
+        case 2:
+            return MakeWallRunArc(State, Params, Location, GravityZ);
+        case 3:
+            return MakeSlideArc(State, Params, Location, {0.f, 0.f, 1.f}, BrakingDecelerationWalking,
+                                Random() % 2 == 0);
+        default:
+        {
+            // Slopes between 5 and 25 degrees
+            const float Slope = (15.f + Unit(Random) * 10.f) * 3.14159f / 180.f;
+            return MakeSlideArc(State, Params, Location, {std::sin(Slope), 0.f, std::cos(Slope)},
+                                BrakingDecelerationWalking, Random() % 2 == 0);
+        }
+        }
+    }
+
+    // Steps the arc's physics in small steps, the reference the closed forms are checked against
+    FVec3 SimulateArc(const FArc &Arc, float Time)
+    {
+        FVec3 Delta = {0.f, 0.f, 0.f};
+        FVec3 Velocity = Arc.Velocity;
+        for (float Elapsed = 0.f; Elapsed < Time; Elapsed += ReferenceStep)
+        {
+            const float Step = std::fmin(ReferenceStep, Time - Elapsed);
+            if (Arc.Type == EArcType::Ballistic)
+            {
+                Delta += Velocity * Step + Arc.Acceleration * (.5f * Step * Step);
+                Velocity += Arc.Acceleration * Step;
+            }
+            else
+            {
+                // Slope pull, then braking down to the minimum speed, like the slide physics
+                Velocity += Arc.Acceleration * Step;
+                const float Speed = std::sqrt(SizeSquared(Velocity));
+                if (Speed > Arc.MinSpeed)
+                {
+                    const float NewSpeed =
+                        std::fmax(Speed - (Arc.Friction * Speed + Arc.BrakingDeceleration) * Step, Arc.MinSpeed);
+                    Velocity = Velocity * (NewSpeed / Speed);
+                }
+                Delta += Velocity * Step;
+            }
+        }
+        if (Arc.Type == EArcType::Slide)
+        {
+            Delta.Z = FloorDeltaZ(Arc.FloorNormal, Delta);
+        }
+        return Arc.Start + Delta;
+    }
+
+    float Distance(const FVec3 &A, const FVec3 &B)
+    {
+        return std::sqrt(SizeSquared(A - B));
+    }
+} // namespace
+
+int main(int ArgC, char **ArgV)
+{
+    const int NumPredictions = ArgC > 1 ? std::atoi(ArgV[1]) : 1000;
+    const int NumFrames = ArgC > 2 ? std::atoi(ArgV[2]) : 600;
+    const FMovementParams Params = MakeDefaultParams();
+
+    std::mt19937 Random(1);
+    std::uniform_real_distribution<float> PredictionTime(0.f, MaxPredictionTime);
+    std::vector<FArc> Arcs(NumPredictions);
+    std::vector<float> Times(NumPredictions);
+    std::vector<float> LandingZ(NumPredictions);
+    for (int Index = 0; Index < NumPredictions; Index++)
+    {
+        Arcs[Index] = MakeRandomArc(Random, Params);
+        Times[Index] = PredictionTime(Random);
+        LandingZ[Index] = Arcs[Index].Start.Z - 150.f;
+    }
+    std::vector<FArcPoint> Points(NumPredictions);
+    std::vector<FArcSummary> Summaries(NumPredictions);
+
+    // One batch of positions and one of apex and landing points per frame
+    double EvaluateMs = 0.0;
+    double SummarizeMs = 0.0;
+    double Checksum = 0.0;
+    for (int Frame = 0; Frame < NumFrames; Frame++)
+    {
+        const auto EvaluateStart = std::chrono::steady_clock::now();
+        EvaluateBatch(Arcs.data(), Times.data(), Points.data(), NumPredictions);
+        const auto SummarizeStart = std::chrono::steady_clock::now();
+        SummarizeBatch(Arcs.data(), LandingZ.data(), MaxPredictionTime, Summaries.data(), NumPredictions);
+        const auto End = std::chrono::steady_clock::now();
+        EvaluateMs += std::chrono::duration<double, std::milli>(SummarizeStart - EvaluateStart).count();
+        SummarizeMs += std::chrono::duration<double, std::milli>(End - SummarizeStart).count();
+        Checksum += Points[Frame % NumPredictions].Position.X + Summaries[Frame % NumPredictions].End.Z;
+    }
+
+    // Largest error of the predictions against the small step simulation. Slides on slopes are stepped at the
+    // frame rate like the slide physics, their error is how far a 60 Hz game drifts from the small steps.
+    float MaxClosedFormError = 0.f;
+    float MaxSlopeSlideError = 0.f;
+    for (int Index = 0; Index < NumPredictions; Index++)
+    {
+        const FArc &Arc = Arcs[Index];
+        const float Error =
+            std::fmax(Distance(Points[Index].Position, SimulateArc(Arc, Times[Index])),
+                      Distance(Summaries[Index].End, SimulateArc(Arc, Summaries[Index].EndTime)));
+        float &MaxError = IsSlopeSlide(Arc) ? MaxSlopeSlideError : MaxClosedFormError;
+        MaxError = std::fmax(MaxError, Error);
+    }
+
+    std::printf("predictions=%d frames=%d\n", NumPredictions, NumFrames);
+    std::printf("evaluate_us_per_frame=%.2f summarize_us_per_frame=%.2f ns_per_prediction=%.1f\n",
+                EvaluateMs * 1000.0 / NumFrames, SummarizeMs * 1000.0 / NumFrames,
+                (EvaluateMs + SummarizeMs) * 1.e6 / (double(NumPredictions) * NumFrames * 2));
+    std::printf("max_closed_form_error_cm=%.3f max_slope_slide_error_cm=%.3f\n", MaxClosedFormError,
+                MaxSlopeSlideError);
+    std::printf("checksum=%.4f\n", Checksum);
+    return 0;
+}